@@ -1,8 +1,24 @@
 #include <cstring>
+#include <cstddef>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <system_error>
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include <sys/stat.h>
+#include <strings.h>
+#include <unistd.h>
 #include "caen1725Config.h"
 #include "INIReader.h"
 #include "caen1725Lib.h"
@@ -10,19 +26,69 @@
 // debug flag
 static bool configDebug = false;
 
+// maximum number of boards programmed at the same time
+static int32_t configThreads = 8;
+
+// compiled parameter cache, by default the config filename + ".cache"
+static bool configCacheEnable = true;
+static std::string configCacheFile;
+
+// library write mode while programming the boards
+static int32_t configWriteMode = C1725_WRITE_CHANGED;
+
+// time allowed for the DC offsets of all boards to load in the background
+static const uint32_t configDACLoadTimeout_us = 1000000;
+
+// hash of the config file last applied, and the lock of the parameters
+static uint64_t configHash = 0;
+static std::mutex configMutex;
+
+static int32_t caen1725ConfigDownload();
+static uint64_t fnv1a(const char *data, size_t len, uint64_t hash);
+static int32_t configCacheLoad(const char *cachefile, caen1725param_t *params, uint64_t *hash,
+			       std::vector<std::string> *files);
+static int32_t configFill();
+static void param2chan(int32_t id, c1725ChannelConfig_t *chan);
 
-// place to store the ini INIReader instance
-INIReader *ir;
 
 static caen1725param_t param[MAX_VME_SLOTS+1];
 static caen1725param_t all_param;
 #define _zeros_ {0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0, 0}
-static caen1725param_t defparam =
+// Built in defaults, replaced by the ALLSLOTS section
+static const caen1725param_t configDefaults =
   {
-    .external_trigger = 0,
+    .external_trigger = 2,
     .fpio_level = 0,
     .enable_input_mask = 0,
-    .max_events_per_blt = 0,
+    .trg_in_mode = 0,
+    .veto_polarity = 1,
+    .flag_trunc_event = 1,
+    .global_trg_channel_mask = 0,
+    .global_trg_coinc_window = 0,
+    .global_trg_majority = 0,
+    .global_trg_lvds = 0,
+    .global_trg_software = 1,
+    .fptrgout_channel_mask = 0,
+    .fptrgout_channel_logic = 0,
+    .fptrgout_majority = 0,
+    .fptrgout_lvds = 0,
+    .fptrgout_software = 1,
+    .fpio_trgout_enable = 1,
+    .fpio_lvds_mask = 0,
+    .fpio_trg_in_mask = 0,
+    .fpio_trg_out_mask = 0,
+    .run_delay = 0,
+    .veto_delay = 0,
+    .monitor_mode = 0,
+    .monitor_dac = 0,
+    .intlevel = 0,
+    .optical_int = 0,
+    .vme_berr = 1,
+    .align64 = 1,
+    .address_relocate = 0,
+    .roak = 1,
+    .ext_blk_space = 0,
+    .max_events_per_blt = 1,
     .record_length = _zeros_,
     .input_delay =  _zeros_,
     .gain_factor = _zeros_,
@@ -38,6 +104,7 @@ static caen1725param_t defparam =
     .test_pulse_rate = _zeros_,
     .self_trigger = _zeros_
   };
+static caen1725param_t defparam = configDefaults;
 
 
 int32_t
@@ -46,6 +113,7 @@ caen1725ConfigInitGlobals()
   if(configDebug)
     std::cout << __func__ << ": INFO: here" << std::endl;
 
+  defparam = configDefaults;
   for(int32_t ip = 0; ip < MAX_VME_SLOTS; ip++)
     {
       memcpy(&param[ip], &defparam, sizeof(caen1725param_t));
@@ -88,123 +156,583 @@ string2mask(const char* bitstring)
 }
 
 
-/**
- * @brief Write the Ini values for the input slot to the local module structure
- * @param[in] slotstring String specifing the slot number "ALLSLOTS", "SLOT3", ...
+/*
+ * Index of the config file, filled in one pass of the parser.  Each key name
+ * ("TRG_THRESHOLD_CHAN11") is resolved once to a key ID and channel, and its
+ * value stored by section, key and channel, so that filling the parameters
+ * needs no string building or map lookups.
  */
-void
-slot2param(std::string slotstring)
+enum configKeyType { CONFIG_MODULE, CONFIG_INT, CONFIG_BOOL };
+
+typedef int32_t (caen1725param_t::*configChannelParam)[C1725_MAX_ADC_CHANNELS+1];
+typedef int32_t caen1725param_t::*configBoardParam;
+
+static const struct
 {
-  caen1725param_t *sp;
-  if(ir == NULL)
-    return;
+  const char *name;
+  configKeyType type;
+  configChannelParam param; // channel keys, which also take a _CHANn suffix
+  configBoardParam board;   // board keys, with the range of their value
+  int32_t min, max;
+} configKeys[] =
+  {
+    { "EXTERNAL_TRIGGER",    CONFIG_MODULE, nullptr },
+    { "FPIO_LEVEL",          CONFIG_MODULE, nullptr },
+    { "ENABLE_INPUT_MASK",   CONFIG_MODULE, nullptr },
+    { "TRG_IN_MODE",         CONFIG_INT,  nullptr, &caen1725param_t::trg_in_mode, 0, 1 },
+    { "VETO_POLARITY",       CONFIG_INT,  nullptr, &caen1725param_t::veto_polarity, 0, 1 },
+    { "FLAG_TRUNC_EVENT",    CONFIG_BOOL, nullptr, &caen1725param_t::flag_trunc_event, 0, 1 },
+    { "GLOBAL_TRG_CHANNEL_MASK", CONFIG_INT, nullptr,
+      &caen1725param_t::global_trg_channel_mask, 0, C1725_GLOBAL_TRG_CHANNEL_MASK },
+    { "GLOBAL_TRG_COINC_WINDOW", CONFIG_INT, nullptr,
+      &caen1725param_t::global_trg_coinc_window, 0, 15 },
+    { "GLOBAL_TRG_MAJORITY", CONFIG_INT,  nullptr, &caen1725param_t::global_trg_majority, 0, 7 },
+    { "GLOBAL_TRG_LVDS",     CONFIG_BOOL, nullptr, &caen1725param_t::global_trg_lvds, 0, 1 },
+    { "GLOBAL_TRG_SOFTWARE", CONFIG_BOOL, nullptr, &caen1725param_t::global_trg_software, 0, 1 },
+    { "FPTRGOUT_CHANNEL_MASK", CONFIG_INT, nullptr,
+      &caen1725param_t::fptrgout_channel_mask, 0, C1725_FPTRGOUT_CHANNEL_MASK },
+    { "FPTRGOUT_CHANNEL_LOGIC", CONFIG_INT, nullptr,
+      &caen1725param_t::fptrgout_channel_logic, 0, C1725_FPTRGOUT_CHANNEL_LOGIC_MAJORITY },
+    { "FPTRGOUT_MAJORITY",   CONFIG_INT,  nullptr, &caen1725param_t::fptrgout_majority, 0, 7 },
+    { "FPTRGOUT_LVDS",       CONFIG_BOOL, nullptr, &caen1725param_t::fptrgout_lvds, 0, 1 },
+    { "FPTRGOUT_SOFTWARE",   CONFIG_BOOL, nullptr, &caen1725param_t::fptrgout_software, 0, 1 },
+    { "FPIO_TRGOUT_ENABLE",  CONFIG_BOOL, nullptr, &caen1725param_t::fpio_trgout_enable, 0, 1 },
+    { "FPIO_LVDS_MASK",      CONFIG_INT,  nullptr, &caen1725param_t::fpio_lvds_mask, 0, 0xFF },
+    { "FPIO_TRG_IN_MASK",    CONFIG_INT,  nullptr, &caen1725param_t::fpio_trg_in_mask, 0, 0x3 },
+    { "FPIO_TRG_OUT_MASK",   CONFIG_INT,  nullptr, &caen1725param_t::fpio_trg_out_mask, 0, 0x1FF },
+    { "RUN_DELAY",           CONFIG_INT,  nullptr, &caen1725param_t::run_delay, 0, 0xFF },
+    { "VETO_DELAY",          CONFIG_INT,  nullptr, &caen1725param_t::veto_delay, 0, 0xFF },
+    { "MONITOR_MODE",        CONFIG_INT,  nullptr, &caen1725param_t::monitor_mode,
+      0, C1725_MONITOR_MODE_VOLT_LEVEL },
+    { "MONITOR_DAC",         CONFIG_INT,  nullptr, &caen1725param_t::monitor_dac,
+      0, C1725_MONITOR_DAC_MASK },
+    { "INTERRUPT_LEVEL",     CONFIG_INT,  nullptr, &caen1725param_t::intlevel,
+      0, C1725_READOUT_CTRL_INTLEVEL_MASK },
+    { "OPTICAL_INTERRUPT",   CONFIG_BOOL, nullptr, &caen1725param_t::optical_int, 0, 1 },
+    { "VME_BERR",            CONFIG_BOOL, nullptr, &caen1725param_t::vme_berr, 0, 1 },
+    { "ALIGN64",             CONFIG_BOOL, nullptr, &caen1725param_t::align64, 0, 1 },
+    { "ADDRESS_RELOCATE",    CONFIG_BOOL, nullptr, &caen1725param_t::address_relocate, 0, 1 },
+    { "ROAK",                CONFIG_BOOL, nullptr, &caen1725param_t::roak, 0, 1 },
+    { "EXT_BLK_SPACE",       CONFIG_BOOL, nullptr, &caen1725param_t::ext_blk_space, 0, 1 },
+    { "MAX_EVENTS_PER_BLT",  CONFIG_INT,  nullptr, &caen1725param_t::max_events_per_blt,
+      1, C1725_MAX_EVT_BLT_MASK },
+    { "RECORD_LENGTH",       CONFIG_INT,  &caen1725param_t::record_length },
+    { "INPUT_DELAY",         CONFIG_INT,  &caen1725param_t::input_delay },
+    { "GAIN_FACTOR",         CONFIG_INT,  &caen1725param_t::gain_factor },
+    { "MAX_TAIL",            CONFIG_INT,  &caen1725param_t::max_tail },
+    { "PRE_TRIGGER",         CONFIG_INT,  &caen1725param_t::pre_trigger },
+    { "N_LFW",               CONFIG_INT,  &caen1725param_t::n_lfw },
+    { "BLINE_DEFMODE",       CONFIG_BOOL, &caen1725param_t::bline_defmode },
+    { "BLINE_DEFVALUE",      CONFIG_INT,  &caen1725param_t::bline_defvalue },
+    { "TRG_THRESHOLD",       CONFIG_INT,  &caen1725param_t::trg_threshold },
+    { "DC_OFFSET",           CONFIG_INT,  &caen1725param_t::dc_offset },
+    { "TEST_PULSE_POLARITY", CONFIG_INT,  &caen1725param_t::test_pulse_polarity },
+    { "TEST_PULSE",          CONFIG_BOOL, &caen1725param_t::test_pulse },
+    { "TEST_PULSE_RATE",     CONFIG_INT,  &caen1725param_t::test_pulse_rate },
+    { "SELF_TRIGGER",        CONFIG_BOOL, &caen1725param_t::self_trigger }
+  };
+enum { KEY_EXTERNAL_TRIGGER, KEY_FPIO_LEVEL, KEY_ENABLE_INPUT_MASK };
+#define CONFIG_NKEYS (int32_t) (sizeof(configKeys) / sizeof(configKeys[0]))
+
+// Values of a section: index in configValues, or -1 if not in the file.
+// Channel CHANNEL_COMMON is the key without the _CHANn suffix
+typedef struct
+{
+  bool found;
+  int32_t value[CONFIG_NKEYS][C1725_MAX_ADC_CHANNELS+1];
+} configSection;
+
+// Sections by layer and slot (ALLSLOTS at 0).  The CRATE layer holds the
+// [CRATE name] and [CRATE name SLOT n] sections of this crate, and overrides
+// the base layer key by key
+enum { LAYER_BASE, LAYER_CRATE, CONFIG_NLAYERS };
+static configSection configIndex[CONFIG_NLAYERS][MAX_VME_SLOTS+1];
+static std::vector<std::string> configValues;
+static std::vector<int32_t> configValueFile;   // file that set each value
+static bool configLoaded = false;
+
+// Files parsed, in order: the config file, then each INCLUDE as it is reached
+static std::vector<std::string> configFiles;
+static uint64_t configFilesHash = 0;           // crate name, then path and contents of each
+#define CONFIG_MAX_INCLUDE_DEPTH 8
+
+// Crate name that selects the CRATE sections, the hostname by default
+static std::string configCrate;
+
+// Where the parser is
+static std::string configCurrentSection;
+static int32_t configCurrentSlot = -1, configCurrentLayer = LAYER_BASE;
+static int32_t configCurrentFile = -1;
+static std::vector<std::string> configIncludeStack;
+static bool configParseFailed = false;
+
+static void
+configIndexClear()
+{
+  for(int32_t il = 0; il < CONFIG_NLAYERS; il++)
+    for(int32_t is = 0; is <= MAX_VME_SLOTS; is++)
+      {
+	configSection *cs = &configIndex[il][is];
+
+	cs->found = false;
+	std::fill(&cs->value[0][0], &cs->value[0][0] + sizeof(cs->value) / sizeof(int32_t), -1);
+      }
+  configValues.clear();
+  configValueFile.clear();
+  configFiles.clear();
+  configFilesHash = CAEN1725_CACHE_HASH_INIT;
+  configCurrentSection.clear();
+  configCurrentSlot = -1;
+  configCurrentLayer = LAYER_BASE;
+  configCurrentFile = -1;
+  configIncludeStack.clear();
+  configParseFailed = false;
+  configLoaded = false;
+}
 
-  // figure out with slot to fill from the string
-  if(slotstring.compare("ALLSLOTS") == 0)
+/* Crate name for the CRATE sections */
+static const std::string &
+configCrateName()
+{
+  if(configCrate.empty())
     {
-      sp = &all_param;
+      char host[256] = "";
+
+      gethostname(host, sizeof(host) - 1);
+      configCrate = host;
     }
 
-  // Check for "SLOT" parameter with slotnumber
-  int32_t slotID = -1;
-  if(sscanf(slotstring.c_str(),"SLOT %d", &slotID) == 1)
+  return configCrate;
+}
+
+/* Whether [CRATE name] is for this crate: the crate name, or its short hostname */
+static bool
+configCrateMatch(const std::string &name)
+{
+  const std::string &crate = configCrateName();
+
+  return (strcasecmp(name.c_str(), crate.c_str()) == 0) ||
+    (strcasecmp(name.c_str(), crate.substr(0, crate.find('.')).c_str()) == 0);
+}
+
+/**
+ * @brief Key ID and channel of a key name
+ * @param[in] name Key name, any case, e.g. "TRG_THRESHOLD_CHAN11"
+ * @param[out] chan Channel, or CHANNEL_COMMON
+ * @return Key ID, or -1 if the key is unknown
+ */
+static int32_t
+configKeyID(const char *name, int32_t *chan)
+{
+  static std::unordered_map<std::string, int32_t> ids;
+
+  if(ids.empty())
+    for(int32_t ik = 0; ik < CONFIG_NKEYS; ik++)
+      ids[configKeys[ik].name] = ik;
+
+  std::string key(name);
+  std::transform(key.begin(), key.end(), key.begin(), ::toupper);
+
+  *chan = CHANNEL_COMMON;
+  std::unordered_map<std::string, int32_t>::const_iterator it = ids.find(key);
+  if(it != ids.end())
+    return it->second;
+
+  size_t pos = key.rfind("_CHAN");
+  if((pos == std::string::npos) || (pos + 5 == key.size()) ||
+     (key.find_first_not_of("0123456789", pos + 5) != std::string::npos))
+    return -1;
+
+  int32_t ich = atoi(key.c_str() + pos + 5);
+  it = ids.find(key.substr(0, pos));
+  if((it == ids.end()) || (configKeys[it->second].param == nullptr) ||
+     (ich >= C1725_MAX_ADC_CHANNELS))
+    return -1;
+
+  *chan = ich;
+  return it->second;
+}
+
+/**
+ * @brief Layer and slot of the section the parser entered
+ * @param[in] section Section name
+ */
+static void
+configSectionStart(const char *section)
+{
+  char crate[256] = "";
+  int32_t slotID = -1, n = 0;
+
+  configCurrentSection = section;
+  configCurrentSlot = -1;
+  configCurrentLayer = LAYER_BASE;
+
+  if(configCurrentSection.empty())
+    return; // before the first section: INCLUDE only
+
+  if(configCurrentSection.compare("ALLSLOTS") == 0)
+    configCurrentSlot = 0;
+  else if(sscanf(section, "SLOT %d", &slotID) == 1)
     {
       if(configDebug)
 	std::cout << "slot = " << slotID << std::endl;
+    }
+  else if(sscanf(section, "CRATE %255s %n", crate, &n) == 1)
+    {
+      if(!configCrateMatch(crate))
+	return;
 
-      if((slotID > 2) && (slotID < MAX_VME_SLOTS))
-	sp = &param[slotID];
-      else
+      configCurrentLayer = LAYER_CRATE;
+      if(section[n] == '\0')
+	configCurrentSlot = 0;
+      else if(sscanf(section + n, "SLOT %d", &slotID) != 1)
 	{
-	  std::cerr << __func__ << "(" << slotstring << "): Invalid id = " << slotID << std::endl;
+	  std::cerr << __func__ << ": WARN: Unknown section [" << section << "]" << std::endl;
 	  return;
 	}
     }
+  else
+    {
+      std::cerr << __func__ << ": WARN: Unknown section [" << section << "]" << std::endl;
+      return;
+    }
+
+  if(slotID != -1)
+    {
+      if((slotID > 2) && (slotID < MAX_VME_SLOTS))
+	configCurrentSlot = slotID;
+      else
+	std::cerr << __func__ << "(" << section << "): Invalid id = " << slotID << std::endl;
+    }
+
+  if(configCurrentSlot >= 0)
+    configIndex[configCurrentLayer][configCurrentSlot].found = true;
+}
+
+static int32_t configParseFile(const std::string &filename);
+
+/**
+ * @brief ini_parse handler: add a value to the index
+ * @return 1 (continue parsing)
+ */
+static int
+configValueHandler(void *user, const char *section, const char *name, const char *value)
+{
+  if(configCurrentSection.compare(section) != 0)
+    configSectionStart(section);
+
+  // INCLUDE: parse the file here, in any section that applies to this crate
+  if(strcasecmp(name, "INCLUDE") == 0)
+    {
+      if((configCurrentSlot < 0) && !configCurrentSection.empty())
+	return 1;
+
+      const std::string &parent = configIncludeStack.back();
+      std::string path(value);
+      if((path[0] != '/') && (parent.rfind('/') != std::string::npos))
+	path = parent.substr(0, parent.rfind('/') + 1) + path;
+
+      std::string sect = configCurrentSection;
+      int32_t slot = configCurrentSlot, layer = configCurrentLayer, file = configCurrentFile;
+
+      if(configParseFile(path) < 0)
+	configParseFailed = true;
+
+      configCurrentSection = sect;
+      configCurrentSlot = slot;
+      configCurrentLayer = layer;
+      configCurrentFile = file;
+      return 1;
+    }
+
+  if(configCurrentSlot < 0)
+    {
+      if(configCurrentSection.empty())
+	std::cerr << __func__ << ": WARN: " << name << " outside of a section" << std::endl;
+      return 1;
+    }
+
+  int32_t ich, ikey = configKeyID(name, &ich);
+  if(ikey < 0)
+    {
+      std::cerr << __func__ << ": WARN: Unknown key [" << section << "] " << name << std::endl;
+      return 1;
+    }
+
+  // A later file replaces the value.  A repeated key (or a multi-line value) in
+  // the same file is appended, as by INIReader
+  int32_t &iv = configIndex[configCurrentLayer][configCurrentSlot].value[ikey][ich];
+  if((iv >= 0) && (configValueFile[iv] == configCurrentFile))
+    configValues[iv] += std::string("\n") + value;
+  else
+    {
+      iv = configValues.size();
+      configValues.emplace_back(value);
+      configValueFile.push_back(configCurrentFile);
+    }
+
+  return 1;
+}
+
+/* ini_parse_stream reader of the config file contents */
+typedef struct
+{
+  const char *ptr;
+  const char *end;
+} configStream;
+
+static char *
+configStreamReader(char *str, int num, void *stream)
+{
+  configStream *cs = (configStream *) stream;
+  int n = 0;
+
+  if(cs->ptr >= cs->end)
+    return NULL;
+
+  while((n < num - 1) && (cs->ptr < cs->end))
+    {
+      char c = *cs->ptr++;
+      str[n++] = c;
+      if(c == '\n')
+	break;
+    }
+  str[n] = '\0';
+
+  return str;
+}
+
+/**
+ * @brief Read a config file, add it to configFiles and its hash, and index it
+ * @param[in] filename Config file
+ * @return 0 if successful, -1 otherwise
+ */
+static int32_t
+configParseFile(const std::string &filename)
+{
+  if(std::find(configIncludeStack.begin(), configIncludeStack.end(), filename) !=
+     configIncludeStack.end())
+    {
+      std::cerr << __func__ << ": ERROR: " << filename << " includes itself" << std::endl;
+      return -1;
+    }
+  if(configIncludeStack.size() >= CONFIG_MAX_INCLUDE_DEPTH)
+    {
+      std::cerr << __func__ << ": ERROR: " << filename << ": more than "
+		<< CONFIG_MAX_INCLUDE_DEPTH << " levels of INCLUDE" << std::endl;
+      return -1;
+    }
+
+  std::ifstream in(filename, std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if(!in)
+    {
+      std::cerr << __func__ << ": ERROR: Can't load: " << filename << std::endl;
+      return -1;
+    }
+
+  configFilesHash = fnv1a(filename.c_str(), filename.size() + 1, configFilesHash);
+  configFilesHash = fnv1a(contents.data(), contents.size(), configFilesHash);
+  configFiles.push_back(filename);
+
+  configIncludeStack.push_back(filename);
+  configCurrentFile = configFiles.size() - 1;
+  configCurrentSection.clear();
+  configCurrentSlot = -1;
+  configCurrentLayer = LAYER_BASE;
+
+  configStream cs = { contents.data(), contents.data() + contents.size() };
+  int32_t rval = ini_parse_stream(configStreamReader, &cs, configValueHandler, NULL);
+  configIncludeStack.pop_back();
+
+  if(rval > 0)
+    std::cerr << __func__ << ": WARN: " << filename << ": parse error at line " << rval << std::endl;
+
+  return (rval < 0) ? -1 : 0;
+}
+
+/**
+ * @brief Index a config file and the files it includes
+ * @param[in] filename Config file
+ * @return 0 if successful, -1 otherwise
+ */
+static int32_t
+configParse(const std::string &filename)
+{
+  configIndexClear();
+
+  const std::string &crate = configCrateName();
+  configFilesHash = fnv1a(crate.c_str(), crate.size() + 1, configFilesHash);
+
+  int32_t rval = configParseFile(filename);
+  if(configParseFailed)
+    rval = -1;
+  configLoaded = (rval == 0);
+
+  return rval;
+}
+
+/* Value of a key in a section, NULL if not in the file.  The CRATE layer first */
+static const std::string *
+configValue(int32_t slot, int32_t ikey, int32_t ich)
+{
+  int32_t iv = configIndex[LAYER_CRATE][slot].value[ikey][ich];
+
+  if(iv < 0)
+    iv = configIndex[LAYER_BASE][slot].value[ikey][ich];
+
+  return (iv < 0) ? NULL : &configValues[iv];
+}
+
+/* Integer value, as INIReader::GetInteger */
+static int32_t
+configInteger(const std::string *value, int32_t default_value)
+{
+  if(value == NULL)
+    return default_value;
+
+  const char *str = value->c_str();
+  char *end;
+  long n = strtol(str, &end, 0);
+
+  return (end > str) ? n : default_value;
+}
+
+/* Boolean value, as INIReader::GetBoolean */
+static int32_t
+configBoolean(const std::string *value, int32_t default_value)
+{
+  if(value == NULL)
+    return default_value;
+
+  std::string str(*value);
+  std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+  if((str == "true") || (str == "yes") || (str == "on") || (str == "1"))
+    return 1;
+  if((str == "false") || (str == "no") || (str == "off") || (str == "0"))
+    return 0;
+
+  return default_value;
+}
+
+/* Index of value in the list of choices (any case), default_value if not in the file,
+   -1 if it is not one of them */
+static int32_t
+configChoice(const std::string *value, const char *const *choices, int32_t default_value)
+{
+  if(value == NULL)
+    return default_value;
+
+  for(int32_t ic = 0; choices[ic] != NULL; ic++)
+    if(strcasecmp(value->c_str(), choices[ic]) == 0)
+      return ic;
+
+  return -1;
+}
+
+/**
+ * @brief Write the Ini values for the input slot to the local module structure
+ * @param[in] slotID Slot number, or 0 for ALLSLOTS
+ * @return Number of invalid values
+ */
+int32_t
+slot2param(int32_t slotID)
+{
+  caen1725param_t *sp;
+  const std::string *value;
+  int32_t nerr = 0;
+
+  if(!configLoaded || (slotID < 0) || (slotID > MAX_VME_SLOTS))
+    return 0;
+
+  sp = (slotID == 0) ? &all_param : &param[slotID];
+
+  std::string section = (slotID == 0) ? std::string("ALLSLOTS") :
+    "SLOT " + std::to_string(slotID);
 
   //
   // Module parameters
   //
-  std::string var_string = ir->Get(slotstring, "EXTERNAL_TRIGGER","NA");
-  if(var_string.compare("NA") == 0)
+  static const char *const external_trigger[] =
+    { "DISABLED", "ACQUISITION_ONLY", "ACQUISITION_AND_TRGOUT", NULL };
+  value = configValue(slotID, KEY_EXTERNAL_TRIGGER, CHANNEL_COMMON);
+  sp->external_trigger = configChoice(value, external_trigger, defparam.external_trigger);
+  if(sp->external_trigger < 0)
     {
+      std::cerr << __func__ << ": ERROR: " << section << ": Invalid EXTERNAL_TRIGGER ("
+		<< *value << ")" << std::endl;
       sp->external_trigger = defparam.external_trigger;
-    }
-  else
-    {
-      // FIXME: check value
-      if(var_string.compare("") == 0)
-	sp->external_trigger = 1;
-      else
-	sp->external_trigger = 0;
+      nerr++;
     }
 
-  std::string fpio_string = ir->Get(slotstring, "FPIO_LEVEL", "NA");
-  if(var_string.compare("NA") == 0)
+  static const char *const fpio_level[] = { "NIM", "TTL", NULL };
+  value = configValue(slotID, KEY_FPIO_LEVEL, CHANNEL_COMMON);
+  sp->fpio_level = configChoice(value, fpio_level, defparam.fpio_level);
+  if(sp->fpio_level < 0)
     {
+      std::cerr << __func__ << ": ERROR: " << section << ": Invalid FPIO_LEVEL ("
+		<< *value << ")" << std::endl;
       sp->fpio_level = defparam.fpio_level;
+      nerr++;
     }
-  else
+
+  value = configValue(slotID, KEY_ENABLE_INPUT_MASK, CHANNEL_COMMON);
+  sp->enable_input_mask = string2mask(value ? value->c_str() : "0");
+
+  //
+  // Board parameters, checked against their range
+  //
+  for(int32_t ikey = 0; ikey < CONFIG_NKEYS; ikey++)
     {
-      // FIXME: check value
-      if(var_string.compare("TTL") == 0)
-	sp->fpio_level = 1;
-      else
-	sp->fpio_level = 0;
-    }
+      if(configKeys[ikey].board == nullptr)
+	continue;
+
+      int32_t *sparam = &(sp->*configKeys[ikey].board);
 
-  sp->enable_input_mask =
-    string2mask(ir->Get(slotstring, "ENABLE_INPUT_MASK", "0").c_str());
+      value = configValue(slotID, ikey, CHANNEL_COMMON);
+      if(value == NULL)
+	{
+	  *sparam = defparam.*configKeys[ikey].board;
+	  continue;
+	}
+
+      // out of range when it does not parse.  Monitor mode 2 is reserved
+      int32_t v = (configKeys[ikey].type == CONFIG_BOOL) ?
+	configBoolean(value, -1) : configInteger(value, INT32_MIN);
+      if((v < configKeys[ikey].min) || (v > configKeys[ikey].max) ||
+	 ((configKeys[ikey].board == &caen1725param_t::monitor_mode) && (v == 2)))
+	{
+	  std::cerr << __func__ << ": ERROR: " << section << ": Invalid "
+		    << configKeys[ikey].name << " (" << *value << ")" << std::endl;
+	  *sparam = defparam.*configKeys[ikey].board;
+	  nerr++;
+	  continue;
+	}
+
+      *sparam = v;
+    }
 
   //
-  // Channel parameters
+  // Channel parameters: the key without _CHANn is the default of each channel
   //
-  std::string var_str;
-  int32_t ich;
-
-#define _CHANNEL_SEARCH(_var, _param)		\
-  var_str.clear();				\
-  var_str = _var;			\
-  sp->_param[CHANNEL_COMMON] =					\
-    ir->GetInteger(slotstring, var_str, defparam._param[CHANNEL_COMMON]); \
-  for(ich = 0; ich < 16; ich++)						\
-    {									\
-      std::string ch_var_str = var_str + "_CHAN" + std::to_string(ich);	\
-      sp->_param[ich]  =						\
-	ir->GetInteger(slotstring, ch_var_str, sp->_param[CHANNEL_COMMON]); \
-    }
-
-#define _BOOL_CHANNEL_SEARCH(_var, _param)	\
-  var_str.clear();				\
-  var_str = _var;			\
-  sp->_param[CHANNEL_COMMON] =					\
-    ir->GetBoolean(slotstring, var_str, defparam._param[CHANNEL_COMMON]); \
-  for(ich = 0; ich < 16; ich++)						\
-    {									\
-      std::string ch_var_str = var_str + "_CHAN" + std::to_string(ich);	\
-      sp->_param[ich]  =						\
-	ir->GetBoolean(slotstring, ch_var_str, sp->_param[CHANNEL_COMMON]); \
-    }
-
-  _CHANNEL_SEARCH("RECORD_LENGTH", record_length);
-  _CHANNEL_SEARCH("INPUT_DELAY", input_delay);
-  _CHANNEL_SEARCH("GAIN_FACTOR", gain_factor);
-  _CHANNEL_SEARCH("MAX_TAIL", max_tail);
-  _CHANNEL_SEARCH("PRE_TRIGGER", pre_trigger);
-  _CHANNEL_SEARCH("N_LFW", n_lfw);
-
-  _BOOL_CHANNEL_SEARCH("BLINE_DEFMODE", bline_defmode);
-
-  _CHANNEL_SEARCH("BLINE_DEFVALUE", bline_defvalue);
-  _CHANNEL_SEARCH("TRG_THRESHOLD", trg_threshold);
-  _CHANNEL_SEARCH("DC_OFFSET", dc_offset);
-
-  _CHANNEL_SEARCH("TEST_PULSE_POLARITY", test_pulse_polarity);
-  _BOOL_CHANNEL_SEARCH("TEST_PULSE", test_pulse);
-  _CHANNEL_SEARCH("TEST_PULSE_RATE", test_pulse_rate);
-  _BOOL_CHANNEL_SEARCH("SELF_TRIGGER", self_trigger);
+  for(int32_t ikey = 0; ikey < CONFIG_NKEYS; ikey++)
+    {
+      if(configKeys[ikey].param == nullptr)
+	continue;
+
+      int32_t *sparam = sp->*configKeys[ikey].param;
+      int32_t *dparam = defparam.*configKeys[ikey].param;
+      int32_t (*get)(const std::string *, int32_t) =
+	(configKeys[ikey].type == CONFIG_BOOL) ? configBoolean : configInteger;
+
+      sparam[CHANNEL_COMMON] =
+	get(configValue(slotID, ikey, CHANNEL_COMMON), dparam[CHANNEL_COMMON]);
+      for(int32_t ich = 0; ich < C1725_MAX_ADC_CHANNELS; ich++)
+	sparam[ich] = get(configValue(slotID, ikey, ich), sparam[CHANNEL_COMMON]);
+    }
 
   // fill the defaults with ALLSLOTS
-  if(slotstring.compare("ALLSLOTS") == 0)
+  if(slotID == 0)
     {
       memcpy(&defparam, &all_param, sizeof(caen1725param_t));
       for(int32_t ip = 0; ip < MAX_VME_SLOTS; ip++)
@@ -213,6 +741,7 @@ slot2param(std::string slotstring)
 	}
     }
 
+  return nerr;
 }
 
 /**
@@ -250,6 +779,43 @@ caen1725ConfigPrintParameters(uint32_t id)
   PRINTPARAM(fpio_level);
   PRINTPARAM(enable_input_mask);
 
+  PRINTPARAM(trg_in_mode);
+  PRINTPARAM(veto_polarity);
+  PRINTPARAM(flag_trunc_event);
+
+  PRINTPARAM(global_trg_channel_mask);
+  PRINTPARAM(global_trg_coinc_window);
+  PRINTPARAM(global_trg_majority);
+  PRINTPARAM(global_trg_lvds);
+  PRINTPARAM(global_trg_software);
+
+  PRINTPARAM(fptrgout_channel_mask);
+  PRINTPARAM(fptrgout_channel_logic);
+  PRINTPARAM(fptrgout_majority);
+  PRINTPARAM(fptrgout_lvds);
+  PRINTPARAM(fptrgout_software);
+
+  PRINTPARAM(fpio_trgout_enable);
+  PRINTPARAM(fpio_lvds_mask);
+  PRINTPARAM(fpio_trg_in_mask);
+  PRINTPARAM(fpio_trg_out_mask);
+
+  PRINTPARAM(run_delay);
+  PRINTPARAM(veto_delay);
+
+  PRINTPARAM(monitor_mode);
+  PRINTPARAM(monitor_dac);
+
+  PRINTPARAM(intlevel);
+  PRINTPARAM(optical_int);
+  PRINTPARAM(vme_berr);
+  PRINTPARAM(align64);
+  PRINTPARAM(address_relocate);
+  PRINTPARAM(roak);
+  PRINTPARAM(ext_blk_space);
+
+  PRINTPARAM(max_events_per_blt);
+
   PRINTCH(record_length);
   PRINTCH(input_delay);
   PRINTCH(gain_factor);
@@ -271,19 +837,18 @@ caen1725ConfigPrintParameters(uint32_t id)
 /**
  * @brief Write the local parameter structure for the specified slot to the library
  * @param[in] id slot id
- * @return 0
+ * @return number of library calls that failed
  */
 int32_t
 param2caen(int32_t id)
 {
-  /* Write the parameters to the device */
-  { // hardcoded, atm
-    uint32_t trg_in_mode = 0, // 0 : TRG-IN as common trigger
-      veto_polarity = 1,      // 1 : Veto active on high logic level
-      frag_trunc_event = 1;   // 1 : enabled
+  int32_t nerr = 0;
+  caen1725param_t *sp = &param[id];
 
-    c1725SetBoardConfiguration(id, trg_in_mode, veto_polarity, frag_trunc_event);
-  }
+  /* Write the parameters to the device */
+  if(c1725SetBoardConfiguration(id, sp->trg_in_mode, sp->veto_polarity,
+				sp->flag_trunc_event) != OK)
+    nerr++;
 
 #ifdef __notdoneyet
   c1725SetAcquisitionControl(int32_t id, uint32_t mode, uint32_t arm, uint32_t clocksource,
@@ -292,123 +857,605 @@ param2caen(int32_t id)
 
 #endif //__notdoneyet
 
-  { // hardcoded, atm
-    // Internal triggers
-    uint32_t channel_enable = 0, majority_coincidence_window = 0, majority_level = 0;
-    // External triggers
-    uint32_t lvds_trigger_enable = 0, external_trigger_enable = 1, software_trigger_enable = 1;
+  /* TRG-IN to the acquisition, and to TRG-OUT */
+  if(c1725SetGlobalTrigger(id, sp->global_trg_channel_mask, sp->global_trg_coinc_window,
+			   sp->global_trg_majority, sp->global_trg_lvds,
+			   sp->external_trigger != 0, sp->global_trg_software) != OK)
+    nerr++;
+
+  if(c1725SetFPTrigOut(id, sp->fptrgout_channel_mask, sp->fptrgout_channel_logic,
+		       sp->fptrgout_majority, sp->fptrgout_lvds,
+		       sp->external_trigger == 2, sp->fptrgout_software) != OK)
+    nerr++;
+
+  if(c1725SetFPIO(id, sp->fpio_level, sp->fpio_trgout_enable, sp->fpio_lvds_mask,
+		  sp->fpio_trg_in_mask, sp->fpio_trg_out_mask) != OK)
+    nerr++;
+
+  if(c1725SetEnableChannelMask(id, sp->enable_input_mask) != OK)
+    nerr++;
+
+  if(c1725SetRunDelay(id, sp->run_delay) != OK)
+    nerr++;
+  if(c1725SetExtendedVetoDelay(id, sp->veto_delay) != OK)
+    nerr++;
+
+  if(c1725SetMonitorDAC(id, sp->monitor_dac) != OK)
+    nerr++;
+  if(c1725SetMonitorMode(id, sp->monitor_mode) != OK)
+    nerr++;
+
+  if(c1725SetReadoutControl(id, sp->intlevel, sp->optical_int,
+			    sp->vme_berr, sp->align64, sp->address_relocate,
+			    sp->roak, sp->ext_blk_space) != OK)
+    nerr++;
+
+  if(c1725SetMaxEventsPerBLT(id, sp->max_events_per_blt) != OK)
+    nerr++;
+
+  // All channels in one pass, with the all channel registers where possible.
+  // The DC offsets are loaded in the background, see caen1725ConfigDownload
+  c1725ChannelConfig_t chan[C1725_MAX_ADC_CHANNELS];
+  uint32_t offset[C1725_MAX_ADC_CHANNELS];
+  param2chan(id, chan);
+  for(int32_t ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      chan[ichan].dc_offset_queued = 1;
+      offset[ichan] = chan[ichan].dc_offset;
+    }
+  if(c1725SetChannelBlock(id, 0xFFFF, chan) != OK)
+    nerr++;
+  if(c1725DACLoadQueue(id, 0xFFFF, offset) != OK)
+    nerr++;
 
-    c1725SetGlobalTrigger(id, channel_enable, majority_coincidence_window, majority_level,
-			  lvds_trigger_enable, external_trigger_enable,
-			  software_trigger_enable);
-  }
+  return nerr;
+}
 
-  { // hardcoded, atm
-    // Internal trigger settings
-    uint32_t channel_enable = 0, channel_logic = 0, majority_level = 0;
-    // External triggers
-    uint32_t lvds_trigger_enable = 0, external_trigger_enable = 1, software_trigger_enable = 1;
+/**
+ * @brief Channel settings of a board from its parameters
+ * @param[in] id slot number
+ * @param[out] chan Array of C1725_MAX_ADC_CHANNELS channel settings
+ */
+static void
+param2chan(int32_t id, c1725ChannelConfig_t *chan)
+{
+  for(int32_t ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      chan[ichan].record_length = param[id].record_length[ichan];
+      chan[ichan].input_delay = param[id].input_delay[ichan];
+      chan[ichan].dynamic_range = param[id].gain_factor[ichan];
+      chan[ichan].pre_trigger = param[id].pre_trigger[ichan];
+      chan[ichan].trigger_threshold = param[id].trg_threshold[ichan];
+      chan[ichan].fixed_baseline_enable = param[id].bline_defmode[ichan];
+      chan[ichan].fixed_baseline = param[id].bline_defvalue[ichan];
 
-    c1725SetFPTrigOut(id, channel_enable, channel_logic,
-		      majority_level, lvds_trigger_enable,
-		      external_trigger_enable, software_trigger_enable);
+#ifdef NOTYETDEFINED
+      c1725SetCoupleTriggerLogic(id, ichan, uint32_t logic);
+#endif
+      chan[ichan].samples_under_threshold = param[id].n_lfw[ichan];
+      chan[ichan].maximum_tail = param[id].max_tail[ichan];
 
-    uint32_t lemo_enable = 1, lvds_mask = 0, trg_in_mask =0 , trg_out_mask = 0;
-    c1725SetFPIO(id, param[id].fpio_level, lemo_enable,
-		 lvds_mask, trg_in_mask, trg_out_mask);
-  }
+      chan[ichan].test_pulse_enable = param[id].test_pulse[ichan];
+      chan[ichan].test_pulse_rate = param[id].test_pulse_rate[ichan];
+      chan[ichan].test_pulse_polarity = param[id].test_pulse_polarity[ichan];
+      chan[ichan].self_trigger_enable = param[id].self_trigger[ichan];
 
+#ifdef NOTYETDEFINED
+      c1725SetCoupleOverTriggerLogic(id, ichan, uint32_t logic);
+#endif
 
-  c1725SetEnableChannelMask(id, param[id].enable_input_mask);
+      chan[ichan].dc_offset = param[id].dc_offset[ichan];
+      chan[ichan].dc_offset_queued = 0;
+    }
+}
 
-  { // hardcoded, atm
+int32_t
+caen1725ConfigLoadParameters()
+{
+  if(!configLoaded)
+    return 1;
 
-    uint32_t run_delay = 0, veto_delay = 0;
-    c1725SetRunDelay(id, run_delay);
-    c1725SetExtendedVetoDelay(id, veto_delay);
+  int32_t nerr = configFill();
+  if(nerr)
+    {
+      std::cerr << __func__ << ": ERROR: " << nerr << " invalid values, boards not configured"
+		<< std::endl;
+      return 1;
+    }
 
+  return caen1725ConfigDownload();
+}
 
-    int32_t dac = 0, mode = 0;
-    c1725SetMonitorDAC(id, dac);
-    c1725SetMonitorMode(id, mode);
+/**
+ * @brief Fill the parameters of every section of the indexed config file
+ * @return Number of invalid values
+ */
+static int32_t
+configFill()
+{
+  int32_t nerr = 0;
 
-    uint32_t intlevel = 0, optical_int = 0, vme_berr = 1, align64 = 1,
-      address_relocate = 0, roak = 1, ext_blk_space = 0;
+  /* Handle the ALLSLOTS section first (defaults for reset of crate) */
+  if(configIndex[LAYER_BASE][0].found || configIndex[LAYER_CRATE][0].found)
+    nerr += slot2param(0);
 
-    c1725SetReadoutControl(id, intlevel, optical_int,
-			   vme_berr, align64, address_relocate,
-			   roak, ext_blk_space);
+  /* Then the others */
+  for(int32_t islot = 1; islot <= MAX_VME_SLOTS; islot++)
+    {
+      if(configIndex[LAYER_BASE][islot].found || configIndex[LAYER_CRATE][islot].found)
+	nerr += slot2param(islot);
+    }
 
-    uint32_t max_events = 1;
-    c1725SetMaxEventsPerBLT(id, max_events);
+  return nerr;
+}
 
-  }
+/**
+ * @brief Write the local parameter structures of all initialized modules to the library.
+ *        The DC offsets are left loading in the background (c1725DACLoadStart), boards
+ *        interleaved; caen1725ConfigVerify waits for them.
+ * @return 0 if successful, 1 if any module failed
+ */
+static int32_t
+caen1725ConfigDownload()
+{
+  /* Program the boards concurrently.  The library locks each board separately */
+  int32_t nc1725 = c1725N();
+  std::vector<int32_t> nerr(nc1725, 0);
+  std::atomic<int32_t> next(0);
+  uint32_t pending, failed;
 
+  /* DC offsets of a previous download still loading */
+  if((nc1725 > 0) && (c1725DACLoadStatus(c1725Slot(0), &pending, &failed) == 1))
+    c1725DACLoadWait(configDACLoadTimeout_us);
 
-  for(int32_t ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+  /* Only the registers that differ from the library shadow are written */
+  uint32_t writes0 = 0, skipped0 = 0, writes = 0, skipped = 0, w, s;
+  for(int32_t ic = 0; ic < nc1725; ic++)
     {
-      c1725SetRecordLength(id, ichan, param[id].record_length[ichan]);
-      c1725SetInputDelay(id, ichan, param[id].input_delay[ichan]);
-      c1725SetDynamicRange(id, ichan, param[id].gain_factor[ichan]);
-      c1725SetPreTrigger(id, ichan, param[id].pre_trigger[ichan]);
-      c1725SetTriggerThreshold(id, ichan, param[id].trg_threshold[ichan]);
-      if(param[id].bline_defmode[ichan])
-	c1725SetFixedBaseline(id, ichan, param[id].bline_defvalue[ichan]);
+      c1725GetWriteStats(c1725Slot(ic), &w, &s);
+      writes0 += w;
+      skipped0 += s;
+    }
+  int32_t libWriteMode = c1725GetWriteMode();
+  c1725SetWriteMode(configWriteMode);
 
-#ifdef NOTYETDEFINED
-      c1725SetCoupleTriggerLogic(id, ichan, uint32_t logic);
-#endif
-      c1725SetSamplesUnderThreshold(id, ichan, param[id].n_lfw[ichan]);
-      c1725SetMaxmimumTail(id, ichan, param[id].max_tail[ichan]);
+  auto worker = [&]()
+    {
+      int32_t ic;
+      while((ic = next++) < nc1725)
+	nerr[ic] = param2caen(c1725Slot(ic));
+    };
+
+  std::vector<std::thread> pool;
+  int32_t nthreads = std::min(configThreads, nc1725);
+  for(int32_t it = 1; it < nthreads; it++)
+    {
+      try
+	{
+	  pool.emplace_back(worker);
+	}
+      catch(const std::system_error &e)
+	{
+	  std::cerr << __func__ << ": WARN: " << it << " threads: " << e.what() << std::endl;
+	  break;
+	}
+    }
+  worker();
 
-      c1725SetDPPControl(id, ichan,
-			 param[id].test_pulse[ichan], param[id].test_pulse_rate[ichan],
-			 param[id].test_pulse_polarity[ichan], param[id].self_trigger[ichan]);
+  for(auto &t : pool)
+    t.join();
 
-#ifdef NOTYETDEFINED
-      c1725SetCoupleOverTriggerLogic(id, ichan, uint32_t logic);
-#endif
+  c1725SetWriteMode(libWriteMode);
+
+  int32_t dacerr = (c1725DACLoadStart(configDACLoadTimeout_us) != OK);
+
+  for(int32_t ic = 0; ic < nc1725; ic++)
+    {
+      c1725GetWriteStats(c1725Slot(ic), &w, &s);
+      writes += w;
+      skipped += s;
+    }
+  if(configDebug || (configWriteMode == C1725_WRITE_DRYRUN))
+    std::cout << __func__ << ": INFO: " << (writes - writes0) << " register writes"
+	      << ((configWriteMode == C1725_WRITE_DRYRUN) ? " (dry run), " : ", ")
+	      << (skipped - skipped0) << " unchanged" << std::endl;
+
+  /* One report for all boards */
+  int32_t nfail = 0;
+  std::ostringstream report;
+  for(int32_t ic = 0; ic < nc1725; ic++)
+    {
+      if(nerr[ic] == 0)
+	continue;
+
+      nfail++;
+      report << " " << c1725Slot(ic) << "(" << nerr[ic] << ")";
+    }
+
+  if(nfail)
+    {
+      std::cerr << __func__ << ": ERROR: " << nfail << " of " << nc1725
+		<< " boards failed to configure, slot(errors):" << report.str() << std::endl;
+      return 1;
+    }
+
+  return dacerr;
+}
+
+/**
+ * @brief Write the parameters of the last caen1725Config to the boards again, for
+ *        registers found to differ by caen1725ConfigVerify (it updates the library
+ *        shadow with what it read, so the write mode C1725_WRITE_CHANGED writes those)
+ * @return 0 if successful, 1 if any module failed
+ */
+int32_t
+caen1725ConfigRestore()
+{
+  std::lock_guard<std::mutex> lock(configMutex);
+
+  return caen1725ConfigDownload();
+}
+
+/**
+ * @brief Read back the registers programmed from the parameters on every board, and
+ *        compare them with the parameters, once the DC offsets have loaded
+ * @param[out] report Registers that differ, may be NULL
+ * @param[in] nmax Size of report
+ * @return Number of registers that differ (report holds the first nmax of them),
+ *         -1 if a board could not be checked
+ */
+int32_t
+caen1725ConfigVerify(caen1725mismatch_t *report, int32_t nmax)
+{
+  int32_t nbad = 0, nfail = 0, nc1725 = c1725N();
+  std::ostringstream summary;
+
+  /* DC offsets still loading from caen1725ConfigDownload.  A channel that failed
+     shows up as a difference */
+  c1725DACLoadWait(configDACLoadTimeout_us);
+
+  for(int32_t ic = 0; ic < nc1725; ic++)
+    {
+      int32_t id = c1725Slot(ic), nregs = 0, n;
+      c1725Readback_t regs[10 + C1725_CHANBLOCK_NREG * C1725_MAX_ADC_CHANNELS];
+      c1725ChannelConfig_t chan[C1725_MAX_ADC_CHANNELS];
+      caen1725param_t *sp = &param[id];
+
+      /* Board registers as param2caen programs them.  The interrupt level is left
+	 to c1725IntConnect, and the events per BLT to the readout list */
+      regs[nregs++] = { offsetof(c1725_address, config),
+			C1725_CONFIG_TRG_IN_VETO | C1725_CONFIG_VETO_LEVEL_HI |
+			C1725_CONFIG_FLAG_TRUNC_EVENT,
+			(sp->trg_in_mode ? C1725_CONFIG_TRG_IN_VETO : 0u) |
+			(sp->veto_polarity ? C1725_CONFIG_VETO_LEVEL_HI : 0u) |
+			(sp->flag_trunc_event ? 0u : C1725_CONFIG_FLAG_TRUNC_EVENT),
+			0, "board_config" };
+      regs[nregs++] = { offsetof(c1725_address, global_trigger_mask), 0xFFFFFFFF,
+			(uint32_t) sp->global_trg_channel_mask |
+			((uint32_t) sp->global_trg_coinc_window << 20) |
+			((uint32_t) sp->global_trg_majority << 24) |
+			(sp->global_trg_lvds ? C1725_GLOBAL_TRG_LVDS_ENABLE : 0u) |
+			(sp->external_trigger ? C1725_GLOBAL_TRG_EXTERNAL_ENABLE : 0u) |
+			(sp->global_trg_software ? C1725_GLOBAL_TRG_SOFTWARE_ENABLE : 0u),
+			0, "global_trigger_mask" };
+      regs[nregs++] = { offsetof(c1725_address, fp_trg_out_enable_mask), 0xFFFFFFFF,
+			(uint32_t) sp->fptrgout_channel_mask |
+			((uint32_t) sp->fptrgout_channel_logic << 8) |
+			((uint32_t) sp->fptrgout_majority << 10) |
+			(sp->fptrgout_lvds ? C1725_FPTRGOUT_LVDS_ENABLE : 0u) |
+			((sp->external_trigger == 2) ? C1725_FPTRGOUT_EXTERNAL_ENABLE : 0u) |
+			(sp->fptrgout_software ? C1725_FPTRGOUT_SOFTWARE_ENABLE : 0u),
+			0, "fp_trg_out_enable_mask" };
+      regs[nregs++] = { offsetof(c1725_address, fp_io_ctrl),
+			C1725_FPIO_LEMO_LEVEL_TTL | C1725_FPIO_TRGOUT_ENABLE |
+			C1725_FPIO_LVDS_MODE_MASK | C1725_FPIO_TRGIN_MODE_MASK |
+			C1725_FPIO_TRGOUT_MODE_MASK,
+			(sp->fpio_level ? C1725_FPIO_LEMO_LEVEL_TTL : 0u) |
+			(sp->fpio_trgout_enable ? C1725_FPIO_TRGOUT_ENABLE : 0u) |
+			((uint32_t) sp->fpio_lvds_mask << 2) |
+			((uint32_t) sp->fpio_trg_in_mask << 10) |
+			((uint32_t) sp->fpio_trg_out_mask << 14),
+			0, "fp_io_ctrl" };
+      regs[nregs++] = { offsetof(c1725_address, channel_enable_mask), C1725_ENABLE_CHANNEL_MASK,
+			sp->enable_input_mask, 0, "enable_input_mask" };
+      regs[nregs++] = { offsetof(c1725_address, run_start_stop_delay), C1725_RUNDELAY_MASK,
+			(uint32_t) sp->run_delay, 0, "run_delay" };
+      regs[nregs++] = { offsetof(c1725_address, extended_veto_delay), C1725_EXTENDED_VETO_MASK,
+			(uint32_t) sp->veto_delay, 0, "veto_delay" };
+      regs[nregs++] = { offsetof(c1725_address, voltage_level_mode_config), C1725_MONITOR_DAC_MASK,
+			(uint32_t) sp->monitor_dac, 0, "monitor_dac" };
+      regs[nregs++] = { offsetof(c1725_address, analog_monitor_mode), C1725_MONITOR_MODE_MASK,
+			(uint32_t) sp->monitor_mode, 0, "monitor_mode" };
+      regs[nregs++] = { offsetof(c1725_address, readout_ctrl),
+			C1725_READOUT_CTRL_OPTICAL_INT_ENABLE | C1725_READOUT_CTRL_BERR_ENABLE |
+			C1725_READOUT_CTRL_ALIGN64_ENABLE | C1725_READOUT_CTRL_RELOC_ENABLE |
+			C1725_READOUT_CTRL_ROAK_ENABLE | C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE,
+			(sp->optical_int ? C1725_READOUT_CTRL_OPTICAL_INT_ENABLE : 0u) |
+			(sp->vme_berr ? C1725_READOUT_CTRL_BERR_ENABLE : 0u) |
+			(sp->align64 ? C1725_READOUT_CTRL_ALIGN64_ENABLE : 0u) |
+			(sp->address_relocate ? C1725_READOUT_CTRL_RELOC_ENABLE : 0u) |
+			(sp->roak ? C1725_READOUT_CTRL_ROAK_ENABLE : 0u) |
+			(sp->ext_blk_space ? C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE : 0u),
+			0, "readout_ctrl" };
+
+      param2chan(id, chan);
+      n = c1725ChannelBlockReadback(0xFFFF, chan, &regs[nregs],
+				    (int32_t) (sizeof(regs) / sizeof(regs[0])) - nregs);
+      if(n == ERROR)
+	{
+	  nfail++;
+	  continue;
+	}
+      nregs += n;
+
+      /* All registers of the board in one locked pass */
+      n = c1725Readback(id, regs, nregs);
+      if(n == ERROR)
+	{
+	  nfail++;
+	  continue;
+	}
+      if(n == 0)
+	continue;
+
+      summary << " " << id << "(" << n << ")";
+
+      for(int32_t ir = 0; ir < nregs; ir++)
+	{
+	  c1725Readback_t *r = &regs[ir];
+
+	  if(((r->readback ^ r->expected) & r->mask) == 0)
+	    continue;
+
+	  if(configDebug)
+	    std::cerr << __func__ << ": slot " << std::dec << id << " "
+		      << r->name << " @ 0x" << std::hex << r->offset
+		      << " = 0x" << (r->readback & r->mask)
+		      << ", expected 0x" << (r->expected & r->mask) << std::dec << std::endl;
+
+	  if((report != NULL) && (nbad < nmax))
+	    {
+	      caen1725mismatch_t *m = &report[nbad];
+
+	      m->slot = id;
+	      m->chan = ((r->offset >= 0x1000) && (r->offset < 0x2000)) ?
+		(int32_t) ((r->offset >> 8) & 0xF) : -1;
+	      m->offset = r->offset;
+	      m->mask = r->mask;
+	      m->expected = r->expected & r->mask;
+	      m->readback = r->readback & r->mask;
+	      m->name = r->name;
+	    }
+	  nbad++;
+	}
+    }
+
+  if(nfail)
+    {
+      std::cerr << __func__ << ": ERROR: " << nfail << " of " << nc1725
+		<< " boards could not be checked" << std::endl;
+      return -1;
+    }
+
+  if(nbad)
+    std::cerr << __func__ << ": ERROR: " << nbad
+	      << " registers differ from the configuration, slot(registers):"
+	      << summary.str() << std::endl;
+
+  return nbad;
+}
 
-      c1725SetDCOffset(id, ichan, param[id].dc_offset[ichan]);
-  }
+/**
+ * @brief Set which registers are written when the parameters are applied to the boards
+ * @param[in] mode
+ *     C1725_WRITE_ALL     - every register
+ *     C1725_WRITE_CHANGED - only registers that differ from the library shadow (default)
+ *     C1725_WRITE_DRYRUN  - print the changed registers, write nothing
+ * @return 0 if successful, 1 otherwise
+ */
+int32_t
+caen1725ConfigSetWriteMode(int32_t mode)
+{
+  if((mode < C1725_WRITE_ALL) || (mode > C1725_WRITE_DRYRUN))
+    {
+      std::cerr << __func__ << ": ERROR: Invalid mode = " << mode << std::endl;
+      return 1;
+    }
+
+  configWriteMode = mode;
 
   return 0;
 }
 
+/**
+ * @brief Set the number of threads used to program the boards
+ * @param[in] nthreads Maximum boards programmed at the same time (1: one at a time)
+ * @return 0 if successful, 1 otherwise
+ */
 int32_t
-caen1725ConfigLoadParameters()
+caen1725ConfigSetThreads(int32_t nthreads)
 {
-  if(ir == NULL)
-    return 1;
+  if(nthreads < 1)
+    {
+      std::cerr << __func__ << ": ERROR: Invalid nthreads = " << nthreads << std::endl;
+      return 1;
+    }
 
-  /* Handle the ALLSLOTS section first (defaults for reset of crate) */
-  std::string current_slot = "ALLSLOTS";
+  configThreads = nthreads;
+
+  return 0;
+}
+
+/**
+ * @brief 64 bit FNV-1a hash
+ * @param[in] data Input bytes
+ * @param[in] len Number of bytes
+ * @param[in] hash Hash of the preceding bytes, or CAEN1725_CACHE_HASH_INIT
+ * @return hash
+ */
+static uint64_t
+fnv1a(const char *data, size_t len, uint64_t hash)
+{
+  for(size_t i = 0; i < len; i++)
+    {
+      hash ^= (uint8_t) data[i];
+      hash *= 0x100000001b3ULL;
+    }
+
+  return hash;
+}
+
+/**
+ * @brief Read a compiled parameter cache
+ * @param[in] cachefile Cache filename
+ * @param[out] params Array of MAX_VME_SLOTS+1 parameters, indexed by slot.
+ *                    Index 0 holds the ALLSLOTS parameters.
+ * @param[out] hash Hash of the config file the cache was compiled from
+ * @return 0 if successful, 1 otherwise
+ */
+int32_t
+caen1725ConfigCacheRead(const char *cachefile, caen1725param_t *params, uint64_t *hash)
+{
+  return configCacheLoad(cachefile, params, hash, NULL);
+}
+
+/**
+ * @brief Read a compiled parameter cache, and the config files it was compiled from
+ * @param[in] cachefile Cache filename
+ * @param[out] params Array of MAX_VME_SLOTS+1 parameters, indexed by slot
+ * @param[out] hash Hash of the crate name and the config files
+ * @param[out] files Config files, in the order they were parsed.  May be NULL
+ * @return 0 if successful, 1 otherwise
+ */
+static int32_t
+configCacheLoad(const char *cachefile, caen1725param_t *params, uint64_t *hash,
+		std::vector<std::string> *files)
+{
+  caen1725cache_t hdr;
+  int32_t rval = 1;
 
-  std::set<std::string> sections = ir->Sections();
-  std::set<std::string>::iterator it = sections.find(current_slot);
+  FILE *f = fopen(cachefile, "rb");
+  if(f == NULL)
+    return 1;
 
-  if(it != sections.end())
+  if((fread(&hdr, sizeof(hdr), 1, f) == 1) &&
+     (hdr.magic == CAEN1725_CACHE_MAGIC) && (hdr.version == CAEN1725_CACHE_VERSION) &&
+     (hdr.param_size == sizeof(caen1725param_t)) && (hdr.nslots == MAX_VME_SLOTS + 1) &&
+     (fread(params, sizeof(caen1725param_t), hdr.nslots, f) == hdr.nslots))
     {
-      slot2param(current_slot);
+      *hash = hdr.hash;
+      rval = 0;
+
+      for(uint32_t ifile = 0; (files != NULL) && (ifile < hdr.nfiles); ifile++)
+	{
+	  uint32_t len = 0;
+	  char path[4096];
+
+	  if((fread(&len, sizeof(len), 1, f) != 1) || (len >= sizeof(path)) ||
+	     (fread(path, 1, len, f) != len))
+	    {
+	      rval = 1;
+	      break;
+	    }
+	  files->emplace_back(path, len);
+	}
     }
 
-  /* Loop through the others */
-  for(it=sections.begin(); it!=sections.end(); ++it)
+  fclose(f);
+  return rval;
+}
+
+/* Hash of the crate name and the config files, as configParse computes it.
+   0 if a file cannot be read */
+static uint64_t
+configHashFiles(const std::vector<std::string> &files)
+{
+  const std::string &crate = configCrateName();
+  uint64_t hash = fnv1a(crate.c_str(), crate.size() + 1, CAEN1725_CACHE_HASH_INIT);
+
+  for(const std::string &file : files)
     {
-      if(it->compare("ALLSLOTS") == 0) continue;
+      std::ifstream in(file, std::ios::binary);
+      std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      if(!in)
+	return 0;
 
-      slot2param(*it);
+      hash = fnv1a(file.c_str(), file.size() + 1, hash);
+      hash = fnv1a(contents.data(), contents.size(), hash);
     }
 
-  int32_t nc1725 = c1725N();
-  for(int32_t ic = 0; ic < nc1725; ic++)
+  return hash;
+}
+
+/* Write the local parameter structures to cachefile, tagged with the hash of the
+   crate name and config files, followed by the config files */
+static int32_t
+caen1725ConfigCacheWrite(std::string cachefile, uint64_t hash, const std::vector<std::string> &files)
+{
+  caen1725cache_t hdr = { CAEN1725_CACHE_MAGIC, CAEN1725_CACHE_VERSION,
+			  sizeof(caen1725param_t), MAX_VME_SLOTS + 1, hash,
+			  (uint32_t) files.size(), 0 };
+  std::string tmpfile = cachefile + ".tmp";
+
+  // param[0] is unused by the slots, the cache keeps the ALLSLOTS parameters there
+  std::vector<caen1725param_t> params(param, param + MAX_VME_SLOTS + 1);
+  params[0] = all_param;
+
+  FILE *f = fopen(tmpfile.c_str(), "wb");
+  if(f == NULL)
+    return 1;
+
+  bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1) &&
+    (fwrite(params.data(), sizeof(caen1725param_t), params.size(), f) == params.size());
+  for(const std::string &file : files)
+    {
+      uint32_t len = file.size();
+      ok = ok && (fwrite(&len, sizeof(len), 1, f) == 1) &&
+	(fwrite(file.data(), 1, len, f) == len);
+    }
+  ok = (fclose(f) == 0) && ok;
+
+  // replace the old cache only when the new one is complete
+  if(!ok || (rename(tmpfile.c_str(), cachefile.c_str()) != 0))
     {
-      param2caen(c1725Slot(ic));
+      remove(tmpfile.c_str());
+      return 1;
     }
 
   return 0;
 }
 
+/**
+ * @brief Use a compiled parameter cache to skip parsing unchanged config files
+ * @param[in] enable 0 to disable the cache
+ * @param[in] cachefile Cache filename.  NULL for the config filename + "." + crate
+ *                      name + ".cache"
+ * @return 0
+ */
+int32_t
+caen1725ConfigSetCache(int32_t enable, const char *cachefile)
+{
+  configCacheEnable = enable;
+  configCacheFile = (cachefile == NULL) ? "" : cachefile;
+
+  return 0;
+}
+
+/**
+ * @brief Set the crate name that selects the [CRATE name] sections of the config files
+ * @param[in] crate Crate name.  NULL for the hostname (default)
+ * @return 0
+ */
+int32_t
+caen1725ConfigSetCrate(const char *crate)
+{
+  std::lock_guard<std::mutex> lock(configMutex);
+
+  configCrate = (crate == NULL) ? "" : crate;
+
+  return 0;
+}
+
 // load in parameters to structure from filename
 int32_t
 caen1725Config(const char *filename)
@@ -416,30 +1463,298 @@ caen1725Config(const char *filename)
   if(configDebug)
     std::cout << __func__ << ": INFO: here" << std::endl;
 
-  ir = new INIReader(filename);
-  if(ir->ParseError() < 0)
+  std::lock_guard<std::mutex> lock(configMutex);
+
+  /* The cache is keyed with the crate name and the contents of the config file
+     and every file it includes */
+  std::string cachefile = configCacheFile.empty() ?
+    std::string(filename) + "." + configCrateName() + ".cache" : configCacheFile;
+
+  if(configCacheEnable)
+    {
+      std::vector<caen1725param_t> params(MAX_VME_SLOTS + 1);
+      std::vector<std::string> files;
+      uint64_t cachehash = 0;
+
+      if((configCacheLoad(cachefile.c_str(), params.data(), &cachehash, &files) == 0) &&
+	 !files.empty() && (files[0] == filename) && (configHashFiles(files) == cachehash))
+	{
+	  if(configDebug)
+	    std::cout << __func__ << ": INFO: parameters from " << cachefile << std::endl;
+
+	  all_param = params[0];
+	  defparam = all_param;
+	  for(int32_t ip = 1; ip <= MAX_VME_SLOTS; ip++)
+	    param[ip] = params[ip];
+	  configHash = cachehash;
+	  configFiles = files;
+
+	  return caen1725ConfigDownload();
+	}
+    }
+
+  if(configParse(filename) < 0)
     {
       std::cout << "Can't load: " << filename << std::endl;
       return 1;
     }
 
-  caen1725ConfigLoadParameters();
+  int32_t rval = caen1725ConfigLoadParameters();
+  configHash = (rval == 0) ? configFilesHash : 0;
+
+  if(configCacheEnable && (rval == 0) && (caen1725ConfigCacheWrite(cachefile, configFilesHash, configFiles) != 0) &&
+     configDebug)
+    std::cout << __func__ << ": INFO: cannot write " << cachefile << std::endl;
+
+  return rval;
+}
+
+/**
+ * @brief Copy the values of a channel parameter that differ in the reloaded file,
+ *        logging those of the channels
+ * @param[in] when Time of the reload, for the log
+ * @param[in] id slot number
+ * @param[in] name Parameter name, for the log
+ * @param[in,out] running Running values, CHANNEL_COMMON + 1 of them
+ * @param[in] updated Values from the reloaded file
+ * @param[in,out] nchange Incremented for each channel changed
+ * @return Mask of the channels changed
+ */
+static uint32_t
+reloadChannel(const char *when, int32_t id, const char *name, int32_t *running,
+	      const int32_t *updated, int32_t *nchange)
+{
+  uint32_t chanmask = 0;
+
+  for(int32_t ich = 0; ich <= CHANNEL_COMMON; ich++)
+    {
+      if(running[ich] == updated[ich])
+	continue;
+
+      if(ich < CHANNEL_COMMON)
+	{
+	  std::cout << "caen1725ConfigReload: " << when << " slot " << id << " "
+		    << name << "[" << ich << "] " << running[ich]
+		    << " -> " << updated[ich] << std::endl;
+	  chanmask |= (1 << ich);
+	  (*nchange)++;
+	}
+      running[ich] = updated[ich];
+    }
+
+  return chanmask;
+}
+
+/**
+ * @brief Re-read the config file and apply the parameters that are safe to change
+ *        during acquisition (TRG_THRESHOLD, BLINE_DEFVALUE, DC_OFFSET) to the boards,
+ *        between readouts.  Each change is logged.  Other changes are reported, and
+ *        wait for the next caen1725Config.
+ * @param[in] filename Config file
+ * @return 0 if successful or the file has not changed, 1 otherwise
+ */
+int32_t
+caen1725ConfigReload(const char *filename)
+{
+  std::lock_guard<std::mutex> lock(configMutex);
+
+  if(configParse(filename) < 0)
+    {
+      std::cerr << __func__ << ": ERROR: Can't load: " << filename << std::endl;
+      return 1;
+    }
+
+  if(configFilesHash == configHash)
+    return 0;
+
+  /* Parameters of the new files, leaving the running ones as they are */
+  std::vector<caen1725param_t> running(param, param + MAX_VME_SLOTS + 1);
+  caen1725param_t running_all = all_param, running_def = defparam;
+
+  int32_t ninvalid = configFill();
+
+  std::vector<caen1725param_t> updated(param, param + MAX_VME_SLOTS + 1);
+  std::copy(running.begin(), running.end(), param);
+  all_param = running_all;
+  defparam = running_def;
+
+  if(ninvalid)
+    {
+      std::cerr << __func__ << ": ERROR: " << ninvalid << " invalid values in "
+		<< filename << ", nothing updated" << std::endl;
+      return 1;
+    }
+
+  char when[32];
+  time_t now = time(NULL);
+  strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+  int32_t nchange = 0, nerr = 0;
+  for(int32_t ic = 0; ic < c1725N(); ic++)
+    {
+      int32_t id = c1725Slot(ic);
+      caen1725param_t *sp = &param[id], *up = &updated[id], previous = *sp;
+      uint32_t chanmask = 0;
+      int32_t nboard = 0;
+
+      chanmask |= reloadChannel(when, id, "trg_threshold", sp->trg_threshold,
+				up->trg_threshold, &nboard);
+      chanmask |= reloadChannel(when, id, "bline_defvalue", sp->bline_defvalue,
+				up->bline_defvalue, &nboard);
+      chanmask |= reloadChannel(when, id, "dc_offset", sp->dc_offset,
+				up->dc_offset, &nboard);
+
+      /* Anything else needs a new download */
+      if(memcmp(sp, up, sizeof(caen1725param_t)) != 0)
+	std::cerr << __func__ << ": WARN: " << when << " slot " << id
+		  << ": parameters other than TRG_THRESHOLD, BLINE_DEFVALUE and DC_OFFSET"
+		  << " changed, and are ignored until the next download" << std::endl;
+
+      if(chanmask == 0)
+	continue;
+
+      c1725ChannelConfig_t chan[C1725_MAX_ADC_CHANNELS];
+      param2chan(id, chan);
+      if(c1725UpdateChannelBlock(id, chanmask, chan) != OK)
+	{
+	  /* Keep the values the board has, so the next reload tries again */
+	  std::cerr << __func__ << ": ERROR: slot " << id << ": update failed" << std::endl;
+	  *sp = previous;
+	  nerr++;
+	  continue;
+	}
+
+      nchange += nboard;
+    }
+
+  if(nerr == 0)
+    configHash = configFilesHash;
+
+  std::cout << __func__ << ": " << when << " " << nchange << " parameters updated from "
+	    << filename << std::endl;
+
+  return nerr ? 1 : 0;
+}
+
+// config file watch, caen1725ConfigWatch
+static struct
+{
+  std::thread *thread;
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool stop;
+} configWatch;
+
+/**
+ * @brief Reload a config file each time it, or a file it includes, is modified, until
+ *        configWatch.stop.  A modified file is reloaded once it is unchanged for one
+ *        period, so that a file being written is not read
+ * @param[in] filename Config file
+ * @param[in] period_ms Time between checks of the files
+ */
+static void
+configWatchThread(std::string filename, uint32_t period_ms)
+{
+  std::vector<int64_t> last;
+  bool pending = true;
+
+  std::unique_lock<std::mutex> lock(configWatch.mutex);
+  do
+    {
+      std::vector<std::string> files;
+      {
+	std::lock_guard<std::mutex> flock(configMutex);
+	files = configFiles;
+      }
+      if(files.empty())
+	files.push_back(filename);
+
+      std::vector<int64_t> now;
+      for(const std::string &file : files)
+	{
+	  struct stat st = {};
+
+	  stat(file.c_str(), &st);
+	  now.push_back(st.st_mtim.tv_sec);
+	  now.push_back(st.st_mtim.tv_nsec);
+	  now.push_back(st.st_size);
+	}
+
+      if(now != last)
+	{
+	  last = now;
+	  pending = true;
+	  continue;
+	}
+
+      if(!pending)
+	continue;
+      pending = false;
+
+      lock.unlock();
+      caen1725ConfigReload(filename.c_str());
+      lock.lock();
+    }
+  while(!configWatch.cond.wait_for(lock, std::chrono::milliseconds(period_ms),
+				   []{ return configWatch.stop; }));
+}
+
+/**
+ * @brief Watch a config file during a run, and apply the parameters that are safe to
+ *        change during acquisition when it is modified (see caen1725ConfigReload)
+ * @param[in] filename Config file, NULL to stop watching
+ * @param[in] period_ms Time between checks of the file
+ * @return 0 if successful, 1 otherwise
+ */
+int32_t
+caen1725ConfigWatch(const char *filename, uint32_t period_ms)
+{
+  if(configWatch.thread != NULL)
+    {
+      {
+	std::lock_guard<std::mutex> lock(configWatch.mutex);
+	configWatch.stop = true;
+      }
+      configWatch.cond.notify_all();
+      configWatch.thread->join();
+      delete configWatch.thread;
+      configWatch.thread = NULL;
+    }
+
+  if(filename == NULL)
+    return 0;
+
+  if(period_ms == 0)
+    {
+      std::cerr << __func__ << ": ERROR: Invalid period_ms = " << period_ms << std::endl;
+      return 1;
+    }
+
+  configWatch.stop = false;
+  try
+    {
+      configWatch.thread = new std::thread(configWatchThread, std::string(filename), period_ms);
+    }
+  catch(const std::system_error &e)
+    {
+      std::cerr << __func__ << ": ERROR: " << e.what() << std::endl;
+      return 1;
+    }
+
   return 0;
 }
 
-// destroy the ini object
+// free the index of the config file
 int32_t
 caen1725ConfigFree()
 {
   if(configDebug)
     std::cout << __func__ << ": INFO: here" << std::endl;
 
-  if(ir == NULL)
+  if(!configLoaded)
     return 1;
 
-  if(configDebug)
-    std::cout << "delete ir" << std::endl;
-  delete ir;
+  configIndexClear();
 
   return 0;
 }
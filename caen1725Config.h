@@ -9,12 +9,52 @@ extern "C" {
   #define CHANNEL_COMMON C1725_MAX_ADC_CHANNELS
   typedef struct
   {
-    int32_t external_trigger;
+    int32_t external_trigger;   // 0: disabled, 1: acquisition only, 2: acquisition and TRG-OUT
 
     int32_t fpio_level;
     uint16_t enable_input_mask;
 
-    int32_t max_events_per_blt; // need to fill
+    // board configuration
+    int32_t trg_in_mode;
+    int32_t veto_polarity;
+    int32_t flag_trunc_event;
+
+    // global trigger
+    int32_t global_trg_channel_mask;
+    int32_t global_trg_coinc_window;
+    int32_t global_trg_majority;
+    int32_t global_trg_lvds;
+    int32_t global_trg_software;
+
+    // front panel TRG-OUT
+    int32_t fptrgout_channel_mask;
+    int32_t fptrgout_channel_logic;
+    int32_t fptrgout_majority;
+    int32_t fptrgout_lvds;
+    int32_t fptrgout_software;
+
+    // front panel IO
+    int32_t fpio_trgout_enable;
+    int32_t fpio_lvds_mask;
+    int32_t fpio_trg_in_mask;
+    int32_t fpio_trg_out_mask;
+
+    int32_t run_delay;
+    int32_t veto_delay;
+
+    int32_t monitor_mode;
+    int32_t monitor_dac;
+
+    // readout control
+    int32_t intlevel;
+    int32_t optical_int;
+    int32_t vme_berr;
+    int32_t align64;
+    int32_t address_relocate;
+    int32_t roak;
+    int32_t ext_blk_space;
+
+    int32_t max_events_per_blt;
 
     int32_t record_length[C1725_MAX_ADC_CHANNELS+1];
     int32_t input_delay[C1725_MAX_ADC_CHANNELS+1];
@@ -35,10 +75,49 @@ extern "C" {
 
   } caen1725param_t;
 
+  /* Compiled parameter cache: this header, then MAX_VME_SLOTS+1 caen1725param_t
+     indexed by slot, with the ALLSLOTS parameters at index 0, then the path of
+     each config file it was compiled from (uint32_t length, then the path).
+     Bump the version when caen1725param_t changes */
+  #define CAEN1725_CACHE_MAGIC     0x43313732 /* "C172" */
+  #define CAEN1725_CACHE_VERSION   4
+  #define CAEN1725_CACHE_HASH_INIT 0xcbf29ce484222325ULL /* FNV-1a offset basis */
+  typedef struct
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t param_size; /* sizeof(caen1725param_t) */
+    uint32_t nslots;     /* MAX_VME_SLOTS+1 */
+    uint64_t hash;       /* FNV-1a of the crate name and the config files */
+    uint32_t nfiles;     /* config files: the one given to caen1725Config, then includes */
+    uint32_t reserved;
+  } caen1725cache_t;
+
+  /* A register that differs from the configuration (caen1725ConfigVerify) */
+  typedef struct
+  {
+    int32_t slot;
+    int32_t chan;       /* -1 for a board register */
+    uint32_t offset;
+    uint32_t mask;      /* bits set from the configuration */
+    uint32_t expected;  /* masked */
+    uint32_t readback;  /* masked */
+    const char *name;
+  } caen1725mismatch_t;
+
   /* routine prototypes */
   int32_t caen1725ConfigInitGlobals();
   int32_t caen1725Config(const char *filename);
   int32_t caen1725ConfigFree();
+  int32_t caen1725ConfigReload(const char *filename);
+  int32_t caen1725ConfigWatch(const char *filename, uint32_t period_ms);
+  int32_t caen1725ConfigVerify(caen1725mismatch_t *report, int32_t nmax);
+  int32_t caen1725ConfigRestore();
+  int32_t caen1725ConfigSetThreads(int32_t nthreads);
+  int32_t caen1725ConfigSetWriteMode(int32_t mode);
+  int32_t caen1725ConfigSetCache(int32_t enable, const char *cachefile);
+  int32_t caen1725ConfigSetCrate(const char *crate);
+  int32_t caen1725ConfigCacheRead(const char *cachefile, caen1725param_t *params, uint64_t *hash);
   void    caen1725ConfigPrintParameters(uint32_t id);
 #ifdef __cplusplus
 }
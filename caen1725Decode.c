@@ -0,0 +1,527 @@
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      caen1725Decode.c
+ * @brief     Decoder for CAEN 1725 DPP-DAW data.
+ *
+ *            Splits a readout buffer into board events and channel records,
+ *            and unpacks the 14 bit samples into int16 arrays.  Sample
+ *            unpacking uses AVX2 or SSE2 when available (selected at run
+ *            time), with a scalar fallback.  No locks or global state is
+ *            used beyond the implementation selection.
+ *
+ *            The c1725View routines walk the same buffer without copying,
+ *            for consumers that only look at a few channels.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#if !defined(VXWORKS) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define C1725_DECODE_X86
+#endif
+#include "jvme.h"
+#include "caen1725Decode.h"
+
+/* Data words are in VME (big endian) byte order */
+#ifdef VXWORKS
+#define DATA(_x) (_x)
+#else
+#define DATA(_x) LSWAP(_x)
+#endif
+
+#define C1725_DECODE_UNSET  -1
+
+static int32_t c1725DecodeISA = C1725_DECODE_UNSET;
+
+static void
+c1725UnpackScalar(const uint32_t *data, uint32_t nwords, int16_t *samples)
+{
+  uint32_t iw, word;
+
+  for(iw = 0; iw < nwords; iw++)
+    {
+      word = DATA(data[iw]);
+      samples[2 * iw]     = word & C1725_CHANNEL_SAMPLE_MASK;
+      samples[2 * iw + 1] = (word >> C1725_CHANNEL_SAMPLE_SHIFT) & C1725_CHANNEL_SAMPLE_MASK;
+    }
+}
+
+#ifdef C1725_DECODE_X86
+/*
+ * After byte swapping, each 32 bit word holds the first sample in its low
+ * 16 bits and the second in its high 16 bits, which is already the order of
+ * two consecutive int16 in (little endian) memory.  Only masking remains.
+ */
+__attribute__((target("sse2")))
+static void
+c1725UnpackSSE2(const uint32_t *data, uint32_t nwords, int16_t *samples)
+{
+  const __m128i mask = _mm_set1_epi16(C1725_CHANNEL_SAMPLE_MASK);
+  uint32_t iw = 0;
+
+  for(; iw + 4 <= nwords; iw += 4)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *) &data[iw]);
+      /* swap bytes in each 16 bit half, then the two halves */
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+      v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+      v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+      _mm_storeu_si128((__m128i *) &samples[2 * iw], _mm_and_si128(v, mask));
+    }
+
+  c1725UnpackScalar(&data[iw], nwords - iw, &samples[2 * iw]);
+}
+
+__attribute__((target("avx2")))
+static void
+c1725UnpackAVX2(const uint32_t *data, uint32_t nwords, int16_t *samples)
+{
+  const __m256i mask = _mm256_set1_epi16(C1725_CHANNEL_SAMPLE_MASK);
+  const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+					3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  uint32_t iw = 0;
+
+  for(; iw + 16 <= nwords; iw += 16)
+    {
+      __m256i v0 = _mm256_loadu_si256((const __m256i *) &data[iw]);
+      __m256i v1 = _mm256_loadu_si256((const __m256i *) &data[iw + 8]);
+      v0 = _mm256_and_si256(_mm256_shuffle_epi8(v0, swap), mask);
+      v1 = _mm256_and_si256(_mm256_shuffle_epi8(v1, swap), mask);
+      _mm256_storeu_si256((__m256i *) &samples[2 * iw], v0);
+      _mm256_storeu_si256((__m256i *) &samples[2 * iw + 16], v1);
+    }
+
+  for(; iw + 8 <= nwords; iw += 8)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i *) &data[iw]);
+      _mm256_storeu_si256((__m256i *) &samples[2 * iw],
+			  _mm256_and_si256(_mm256_shuffle_epi8(v, swap), mask));
+    }
+
+  c1725UnpackScalar(&data[iw], nwords - iw, &samples[2 * iw]);
+}
+#endif /* C1725_DECODE_X86 */
+
+static int32_t
+c1725DecodeSupported(int32_t isa)
+{
+  switch(isa)
+    {
+    case C1725_DECODE_SCALAR:
+      return 1;
+#ifdef C1725_DECODE_X86
+    case C1725_DECODE_SSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case C1725_DECODE_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return 0;
+    }
+}
+
+/**
+ * @brief Select the sample unpacking implementation
+ * @param[in] isa C1725_DECODE_SCALAR, C1725_DECODE_SSE2 or C1725_DECODE_AVX2.
+ *                -1 selects the best supported by this CPU.
+ * @return OK if successful, ERROR if not supported.
+ */
+int32_t
+c1725DecodeSetISA(int32_t isa)
+{
+  if(isa < 0)
+    {
+      isa = C1725_DECODE_AVX2;
+      while(!c1725DecodeSupported(isa))
+	isa--;
+    }
+  else if(!c1725DecodeSupported(isa))
+    {
+      fprintf(stderr, "%s: ERROR: Implementation %d not supported\n",
+	      __func__, isa);
+      return ERROR;
+    }
+
+  __atomic_store_n(&c1725DecodeISA, isa, __ATOMIC_RELAXED);
+
+  return OK;
+}
+
+/**
+ * @brief Get the sample unpacking implementation in use
+ * @return C1725_DECODE_SCALAR, C1725_DECODE_SSE2 or C1725_DECODE_AVX2
+ */
+int32_t
+c1725DecodeGetISA()
+{
+  int32_t isa = __atomic_load_n(&c1725DecodeISA, __ATOMIC_RELAXED);
+
+  if(isa == C1725_DECODE_UNSET)
+    {
+      c1725DecodeSetISA(-1);
+      isa = __atomic_load_n(&c1725DecodeISA, __ATOMIC_RELAXED);
+    }
+
+  return isa;
+}
+
+/**
+ * @brief Unpack channel sample words into 14 bit samples
+ * @param[in] data Sample words, VME byte order
+ * @param[in] nwords Number of sample words
+ * @param[out] samples 2 * nwords samples
+ */
+void
+c1725UnpackSamples(const volatile uint32_t *data, uint32_t nwords, int16_t *samples)
+{
+  const uint32_t *words = (const uint32_t *) data;
+
+  switch(c1725DecodeGetISA())
+    {
+#ifdef C1725_DECODE_X86
+    case C1725_DECODE_AVX2:
+      c1725UnpackAVX2(words, nwords, samples);
+      break;
+    case C1725_DECODE_SSE2:
+      c1725UnpackSSE2(words, nwords, samples);
+      break;
+#endif
+    default:
+      c1725UnpackScalar(words, nwords, samples);
+    }
+}
+
+/* Check and index the event at data.  Returns the event size or ERROR */
+static int32_t
+c1725ParseEvent(const volatile uint32_t *data, uint32_t nwords, c1725EventView_t *event)
+{
+  uint32_t header[C1725_HEADER_NWORDS], iw, ihdr, ichan;
+
+  if(nwords < C1725_HEADER_NWORDS)
+    {
+      fprintf(stderr, "%s: ERROR: Buffer too small for a header (%d words)\n",
+	      __func__, nwords);
+      return ERROR;
+    }
+
+  for(ihdr = 0; ihdr < C1725_HEADER_NWORDS; ihdr++)
+    header[ihdr] = DATA(data[ihdr]);
+
+  if((header[0] & C1725_HEADER_TYPE_MASK) != C1725_HEADER_TYPE_ID)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid header word (0x%08x)\n",
+	      __func__, header[0]);
+      return ERROR;
+    }
+
+  event->data = data;
+  event->nwords = header[0] & C1725_HEADER_EVENTSIZE_MASK;
+  if((event->nwords < C1725_HEADER_NWORDS) || (event->nwords > nwords))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid event size (%d, %d words available)\n",
+	      __func__, event->nwords, nwords);
+      return ERROR;
+    }
+
+  event->slot = (header[1] & C1725_HEADER_BOARDID_MASK) >> 27;
+  event->pattern = (header[1] & C1725_HEADER_BIT_PATTERN_MASK) >> 8;
+  event->channel_mask = (header[1] & C1725_HEADER_CHANNEL_MASK) |
+    ((header[2] & C1725_HEADER_CHANNEL_MASK_HI) >> 16);
+  event->event_counter = header[2] & C1725_HEADER_EVENT_CNT_MASK;
+  event->trigger_time = header[3] & C1725_HEADER_TRIGTIME_MASK;
+  event->nchannels = 0;
+
+  iw = C1725_HEADER_NWORDS;
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      uint32_t size;
+
+      event->chan[ichan] = NULL;
+      if(!(event->channel_mask & (1 << ichan)))
+	continue;
+
+      if(iw + C1725_CHANNEL_HEADER_NWORDS > event->nwords)
+	{
+	  fprintf(stderr, "%s: ERROR: Slot %d channel %d header beyond event size (%d)\n",
+		  __func__, event->slot, ichan, event->nwords);
+	  return ERROR;
+	}
+
+      size = DATA(data[iw]) & C1725_CHANNEL_SIZE_MASK;
+      if((size < C1725_CHANNEL_HEADER_NWORDS) || (iw + size > event->nwords))
+	{
+	  fprintf(stderr, "%s: ERROR: Slot %d channel %d invalid size (%d)\n",
+		  __func__, event->slot, ichan, size);
+	  return ERROR;
+	}
+
+      event->chan[ichan] = &data[iw];
+      event->nchannels++;
+      iw += size;
+    }
+
+  if(iw != event->nwords)
+    {
+      fprintf(stderr, "%s: ERROR: Slot %d channel data (%d words) does not match event size (%d)\n",
+	      __func__, event->slot, iw, event->nwords);
+      return ERROR;
+    }
+
+  return event->nwords;
+}
+
+/**
+ * @brief Decode one board event
+ * @param[in] data Address of the event header
+ * @param[in] nwords Number of words available at data
+ * @param[out] event Decoded event
+ * @param[out] samples Buffer for the unpacked samples of all channels
+ * @param[in] maxsamples Size of the samples buffer
+ * @return If successful, the number of words in the event.  Otherwise ERROR.
+ */
+int32_t
+c1725DecodeEvent(const volatile uint32_t *data, uint32_t nwords,
+		 c1725DecodedEvent_t *event, int16_t *samples, uint32_t maxsamples)
+{
+  c1725EventView_t view;
+  c1725ChannelView_t cview;
+  uint32_t ichan, nsamples = 0;
+
+  if(c1725ParseEvent(data, nwords, &view) == ERROR)
+    return ERROR;
+
+  event->slot = view.slot;
+  event->pattern = view.pattern;
+  event->channel_mask = view.channel_mask;
+  event->event_counter = view.event_counter;
+  event->trigger_time = view.trigger_time;
+  event->nwords = view.nwords;
+  event->nchannels = 0;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      c1725DecodedChannel_t *chan;
+
+      if(c1725EventViewChannel(&view, ichan, &cview) != OK)
+	continue;
+
+      if(nsamples + cview.nsamples > maxsamples)
+	{
+	  fprintf(stderr, "%s: ERROR: Sample buffer too small (%d)\n",
+		  __func__, maxsamples);
+	  return ERROR;
+	}
+
+      chan = &event->chan[event->nchannels++];
+      chan->channel = ichan;
+      chan->trigger_time = cview.trigger_time;
+      chan->nsamples = cview.nsamples;
+      chan->samples = &samples[nsamples];
+
+      c1725UnpackSamples(cview.words, cview.nsamples / 2, chan->samples);
+      nsamples += chan->nsamples;
+    }
+
+  return event->nwords;
+}
+
+/**
+ * @brief Decode all events in a buffer from c1725ReadEvent or c1725CBLTReadBlock
+ * @param[in] data Readout buffer
+ * @param[in] nwords Number of words in the buffer
+ * @param[out] events Decoded events
+ * @param[in] maxevents Size of the events array
+ * @param[out] samples Buffer for the unpacked samples of all events
+ * @param[in] maxsamples Size of the samples buffer
+ * @return If successful, the number of events decoded.  Otherwise ERROR.
+ */
+int32_t
+c1725DecodeBlock(const volatile uint32_t *data, uint32_t nwords,
+		 c1725DecodedEvent_t *events, uint32_t maxevents,
+		 int16_t *samples, uint32_t maxsamples)
+{
+  uint32_t iw = 0, nev = 0, nsamples = 0, ichan;
+  int32_t rval;
+
+  while(iw < nwords)
+    {
+      uint32_t word = DATA(data[iw]);
+
+      if((word == C1725_DMA_FILLER_WORD) || (word == C1725_FILLER_WORD))
+	{
+	  iw++;
+	  continue;
+	}
+
+      if(nev >= maxevents)
+	{
+	  fprintf(stderr, "%s: ERROR: More than %d events in buffer\n",
+		  __func__, maxevents);
+	  return ERROR;
+	}
+
+      rval = c1725DecodeEvent(&data[iw], nwords - iw, &events[nev],
+			      &samples[nsamples], maxsamples - nsamples);
+      if(rval == ERROR)
+	return ERROR;
+
+      for(ichan = 0; ichan < events[nev].nchannels; ichan++)
+	nsamples += events[nev].chan[ichan].nsamples;
+
+      iw += rval;
+      nev++;
+    }
+
+  return nev;
+}
+
+/**
+ * @brief Initialize a view over a buffer from c1725ReadEvent or c1725CBLTReadBlock
+ * @param[out] view View
+ * @param[in] data Readout buffer
+ * @param[in] nwords Number of words in the buffer
+ * @return OK
+ */
+int32_t
+c1725ViewInit(c1725View_t *view, const volatile uint32_t *data, uint32_t nwords)
+{
+  view->data = data;
+  view->nwords = nwords;
+  view->pos = 0;
+
+  return OK;
+}
+
+/* Skip fillers, return 1 if an event follows */
+static int32_t
+c1725ViewSkipFiller(c1725View_t *view)
+{
+  while(view->pos < view->nwords)
+    {
+      uint32_t word = DATA(view->data[view->pos]);
+
+      if((word != C1725_DMA_FILLER_WORD) && (word != C1725_FILLER_WORD))
+	return 1;
+      view->pos++;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Advance to the next event in the buffer
+ * @param[in,out] view View
+ * @param[out] event Event, pointing into the buffer
+ * @return 1 if an event was found, 0 at the end of the buffer, ERROR for an invalid event.
+ */
+int32_t
+c1725ViewNextEvent(c1725View_t *view, c1725EventView_t *event)
+{
+  int32_t rval;
+
+  if(!c1725ViewSkipFiller(view))
+    return 0;
+
+  rval = c1725ParseEvent(&view->data[view->pos], view->nwords - view->pos, event);
+  if(rval == ERROR)
+    return ERROR;
+
+  view->pos += rval;
+
+  return 1;
+}
+
+/**
+ * @brief Advance past the consecutive events of the next board in the buffer
+ * @param[in,out] view View
+ * @param[out] board Events of the board, to be iterated with c1725ViewInit
+ * @return 1 if a board was found, 0 at the end of the buffer, ERROR for an invalid event.
+ */
+int32_t
+c1725ViewNextBoard(c1725View_t *view, c1725BoardView_t *board)
+{
+  c1725EventView_t event;
+  uint32_t end;
+  int32_t rval;
+
+  if(!c1725ViewSkipFiller(view))
+    return 0;
+
+  rval = c1725ParseEvent(&view->data[view->pos], view->nwords - view->pos, &event);
+  if(rval == ERROR)
+    return ERROR;
+
+  board->data = &view->data[view->pos];
+  board->slot = event.slot;
+  board->nevents = 1;
+  view->pos += rval;
+  end = view->pos;
+
+  while(c1725ViewSkipFiller(view))
+    {
+      const volatile uint32_t *next = &view->data[view->pos];
+
+      if((DATA(next[0]) & C1725_HEADER_TYPE_MASK) != C1725_HEADER_TYPE_ID)
+	break;
+      if(((DATA(next[1]) & C1725_HEADER_BOARDID_MASK) >> 27) != board->slot)
+	break;
+
+      rval = c1725ParseEvent(next, view->nwords - view->pos, &event);
+      if(rval == ERROR)
+	return ERROR;
+
+      board->nevents++;
+      view->pos += rval;
+      end = view->pos;
+    }
+
+  board->nwords = end - (uint32_t) (board->data - view->data);
+  view->pos = end;
+
+  return 1;
+}
+
+/**
+ * @brief Get a channel record of an event
+ * @param[in] event Event
+ * @param[in] channel Channel number
+ * @param[out] chan Channel record, pointing into the buffer
+ * @return OK if successful, ERROR if the channel is not in the event.
+ */
+int32_t
+c1725EventViewChannel(const c1725EventView_t *event, uint32_t channel,
+		      c1725ChannelView_t *chan)
+{
+  const volatile uint32_t *hdr;
+
+  if((channel >= C1725_MAX_ADC_CHANNELS) || (event->chan[channel] == NULL))
+    return ERROR;
+
+  hdr = event->chan[channel];
+  chan->channel = channel;
+  chan->trigger_time = DATA(hdr[1]) & C1725_CHANNEL_TRIGTIME_MASK;
+  chan->nsamples = 2 * ((DATA(hdr[0]) & C1725_CHANNEL_SIZE_MASK) - C1725_CHANNEL_HEADER_NWORDS);
+  chan->words = &hdr[C1725_CHANNEL_HEADER_NWORDS];
+
+  return OK;
+}
+
+/**
+ * @brief Unpack the samples of a channel record
+ * @param[in] chan Channel record
+ * @param[out] samples chan->nsamples samples
+ * @return Number of samples
+ */
+int32_t
+c1725ChannelViewUnpack(const c1725ChannelView_t *chan, int16_t *samples)
+{
+  c1725UnpackSamples(chan->words, chan->nsamples / 2, samples);
+
+  return chan->nsamples;
+}
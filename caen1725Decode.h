@@ -0,0 +1,245 @@
+#pragma once
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      caen1725Decode.h
+ * @brief     Decoder for CAEN 1725 DPP-DAW data, as placed in memory by
+ *            c1725ReadEvent and c1725CBLTReadBlock (VME byte order).
+ *
+ */
+#include <stdint.h>
+#include "caen1725Lib.h"
+
+/* Sample unpacking implementations */
+#define C1725_DECODE_SCALAR  0
+#define C1725_DECODE_SSE2    1
+#define C1725_DECODE_AVX2    2
+
+/** Decoded channel record.  Samples are in the caller's sample buffer */
+typedef struct
+{
+  uint32_t channel;
+  uint32_t trigger_time;
+  uint32_t nsamples;
+  int16_t *samples;
+} c1725DecodedChannel_t;
+
+/** Decoded board event */
+typedef struct
+{
+  uint32_t slot;
+  uint32_t pattern;
+  uint32_t channel_mask;
+  uint32_t event_counter;
+  uint32_t trigger_time;
+  uint32_t nwords;
+  uint32_t nchannels;
+  c1725DecodedChannel_t chan[C1725_MAX_ADC_CHANNELS];
+} c1725DecodedEvent_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t c1725DecodeSetISA(int32_t isa);
+int32_t c1725DecodeGetISA();
+
+void    c1725UnpackSamples(const volatile uint32_t *data, uint32_t nwords, int16_t *samples);
+
+int32_t c1725DecodeEvent(const volatile uint32_t *data, uint32_t nwords,
+			 c1725DecodedEvent_t *event, int16_t *samples, uint32_t maxsamples);
+int32_t c1725DecodeBlock(const volatile uint32_t *data, uint32_t nwords,
+			 c1725DecodedEvent_t *events, uint32_t maxevents,
+			 int16_t *samples, uint32_t maxsamples);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Zero-copy view of a readout buffer.
+ *
+ * The view types point into the buffer (e.g. dma_dabufp contents) and copy
+ * nothing; the buffer must outlive them.  Samples are read in place with
+ * c1725ChannelViewSample, or unpacked with c1725ChannelViewUnpack.
+ */
+
+/** Iterator over the events of a buffer */
+typedef struct
+{
+  const volatile uint32_t *data;
+  uint32_t nwords;
+  uint32_t pos;		/* next word to examine */
+} c1725View_t;
+
+/** Consecutive events from one board */
+typedef struct
+{
+  const volatile uint32_t *data;	/* first event header */
+  uint32_t nwords;
+  uint32_t slot;
+  uint32_t nevents;
+} c1725BoardView_t;
+
+/** One board event */
+typedef struct
+{
+  const volatile uint32_t *data;	/* event header */
+  uint32_t nwords;
+  uint32_t slot;
+  uint32_t pattern;
+  uint32_t channel_mask;
+  uint32_t event_counter;
+  uint32_t trigger_time;
+  uint32_t nchannels;
+  const volatile uint32_t *chan[C1725_MAX_ADC_CHANNELS];	/* channel header, NULL if absent */
+} c1725EventView_t;
+
+/** One channel record, samples still packed in the buffer */
+typedef struct
+{
+  const volatile uint32_t *words;	/* packed sample words */
+  uint32_t channel;
+  uint32_t trigger_time;
+  uint32_t nsamples;
+} c1725ChannelView_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t c1725ViewInit(c1725View_t *view, const volatile uint32_t *data, uint32_t nwords);
+int32_t c1725ViewNextEvent(c1725View_t *view, c1725EventView_t *event);
+int32_t c1725ViewNextBoard(c1725View_t *view, c1725BoardView_t *board);
+int32_t c1725EventViewChannel(const c1725EventView_t *event, uint32_t channel,
+			      c1725ChannelView_t *chan);
+int32_t c1725ChannelViewUnpack(const c1725ChannelView_t *chan, int16_t *samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief Sample isample of a channel record, read from the buffer
+ */
+static inline int16_t
+c1725ChannelViewSample(const c1725ChannelView_t *chan, uint32_t isample)
+{
+  uint32_t word = chan->words[isample >> 1];
+
+#ifndef VXWORKS
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap32(word);
+#endif
+#endif
+
+  return (word >> ((isample & 1) * C1725_CHANNEL_SAMPLE_SHIFT)) & C1725_CHANNEL_SAMPLE_MASK;
+}
+
+#ifdef __cplusplus
+namespace caen1725
+{
+  /** Channel record, indexable like an array of samples */
+  class ChannelSpan
+  {
+  public:
+    ChannelSpan() { view.words = 0; view.channel = 0; view.trigger_time = 0; view.nsamples = 0; }
+    explicit ChannelSpan(const c1725ChannelView_t &v) : view(v) {}
+
+    uint32_t channel() const { return view.channel; }
+    uint32_t trigger_time() const { return view.trigger_time; }
+    uint32_t size() const { return view.nsamples; }
+    bool empty() const { return view.nsamples == 0; }
+    int16_t operator[](uint32_t i) const { return c1725ChannelViewSample(&view, i); }
+    int32_t unpack(int16_t *samples) const { return c1725ChannelViewUnpack(&view, samples); }
+    const c1725ChannelView_t &c_view() const { return view; }
+
+  private:
+    c1725ChannelView_t view;
+  };
+
+  /** Board event */
+  class EventView
+  {
+  public:
+    EventView() { view.data = 0; view.nwords = 0; }
+    explicit EventView(const c1725EventView_t &v) : view(v) {}
+
+    uint32_t slot() const { return view.slot; }
+    uint32_t pattern() const { return view.pattern; }
+    uint32_t channel_mask() const { return view.channel_mask; }
+    uint32_t event_counter() const { return view.event_counter; }
+    uint32_t trigger_time() const { return view.trigger_time; }
+    uint32_t nwords() const { return view.nwords; }
+    uint32_t nchannels() const { return view.nchannels; }
+    bool has(uint32_t ch) const { return (ch < C1725_MAX_ADC_CHANNELS) && view.chan[ch]; }
+
+    /** Channel record, empty if the channel is not in the event */
+    ChannelSpan channel(uint32_t ch) const
+    {
+      c1725ChannelView_t c;
+      if(c1725EventViewChannel(&view, ch, &c) != 0)
+	return ChannelSpan();
+      return ChannelSpan(c);
+    }
+
+    const c1725EventView_t &c_view() const { return view; }
+
+  private:
+    c1725EventView_t view;
+  };
+
+  /** Events of a buffer, for range-based for loops.  Stops at the first invalid event */
+  class View
+  {
+  public:
+    class iterator
+    {
+    public:
+      iterator() : done(true) {}
+      explicit iterator(const c1725View_t &v) : it(v), done(false) { ++(*this); }
+
+      const EventView &operator*() const { return current; }
+      const EventView *operator->() const { return &current; }
+      iterator &operator++()
+      {
+	c1725EventView_t e;
+	if(c1725ViewNextEvent(&it, &e) == 1)
+	  current = EventView(e);
+	else
+	  done = true;
+	return *this;
+      }
+      bool operator!=(const iterator &o) const { return done != o.done; }
+      bool operator==(const iterator &o) const { return done == o.done; }
+
+    private:
+      c1725View_t it;
+      EventView current;
+      bool done;
+    };
+
+    View(const volatile uint32_t *data, uint32_t nwords) { c1725ViewInit(&view, data, nwords); }
+    explicit View(const c1725BoardView_t &board) { c1725ViewInit(&view, board.data, board.nwords); }
+
+    iterator begin() const { return iterator(view); }
+    iterator end() const { return iterator(); }
+
+    /** Split into per board views */
+    template<typename F> int32_t for_each_board(F f) const
+    {
+      c1725View_t it = view;
+      c1725BoardView_t board;
+      int32_t rval;
+      while((rval = c1725ViewNextBoard(&it, &board)) == 1)
+	f(board.slot, View(board));
+      return rval;
+    }
+
+  private:
+    c1725View_t view;
+  };
+}
+#endif /* __cplusplus */
@@ -26,17 +26,57 @@
 #include <iv.h>
 #include <semLib.h>
 #include <vxLib.h>
+#include <sysLib.h>
+#include <tickLib.h>
 #endif
 #include <stdio.h>
+#include <stddef.h>
+#include <stdarg.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
 #include "jvme.h"
 #include "caen1725Lib.h"
 
-/* Mutex to guard TI read/writes */
-pthread_mutex_t     c1725Mutex = PTHREAD_MUTEX_INITIALIZER;
-#define C1725LOCK     if(pthread_mutex_lock(&c1725Mutex)<0) perror("pthread_mutex_lock");
-#define C1725UNLOCK   if(pthread_mutex_unlock(&c1725Mutex)<0) perror("pthread_mutex_unlock");
+/* Readout counters of each slot (c1725CountersSnapshot).  Relaxed atomic adds,
+   so the readout does not take a lock to count */
+static c1725Counters_t c1725Counters[MAX_VME_SLOTS+1];
+#define C1725COUNT(_id, _field, _n)					\
+  __atomic_fetch_add(&c1725Counters[_id]._field, (_n), __ATOMIC_RELAXED)
+
+/* Lock mutex, and count the wait for slot id if it was held */
+static inline void
+c1725MutexLock(pthread_mutex_t *mutex, int32_t id)
+{
+  struct timespec t0, t1;
+
+  if(pthread_mutex_trylock(mutex) == 0)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if(pthread_mutex_lock(mutex) < 0)
+    perror("pthread_mutex_lock");
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  C1725COUNT(id, lock_waits, 1);
+  C1725COUNT(id, lock_wait_ns,
+	     (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec));
+}
+
+/* Mutexes to guard C1725 read/writes, one for each slot */
+pthread_mutex_t     c1725Mutex[MAX_VME_SLOTS+1] =
+  { [0 ... MAX_VME_SLOTS] = PTHREAD_MUTEX_INITIALIZER };
+#define C1725LOCK(_id)   c1725MutexLock(&c1725Mutex[_id], _id);
+#define C1725UNLOCK(_id) if(pthread_mutex_unlock(&c1725Mutex[_id])<0) perror("pthread_mutex_unlock");
+
+/* Mutex to guard the DMA engine, the MCST window and the DMA counters.
+   When held together with a slot mutex, take this one first */
+pthread_mutex_t     c1725DmaMutex = PTHREAD_MUTEX_INITIALIZER;
+#define C1725DMALOCK     if(pthread_mutex_lock(&c1725DmaMutex)<0) perror("pthread_mutex_lock");
+/* In the readout, with the wait counted for the slot read */
+#define C1725DMALOCKID(_id) c1725MutexLock(&c1725DmaMutex, _id);
+#define C1725DMAUNLOCK   if(pthread_mutex_unlock(&c1725DmaMutex)<0) perror("pthread_mutex_unlock");
 
 /* Define external Functions */
 #ifdef VXWORKS
@@ -53,6 +93,58 @@ static unsigned long c1725MCSTOffset=0; /* offset between VME and local address
 static uint32_t c1725MCSTBase = 0x09000000;
 static int32_t c1725IntLevel=5;        /* default interrupt level */
 static int32_t c1725IntVector=0xa8;    /* default interrupt vector */
+static int32_t c1725IntRunning=0;      /* c1725Isr connected */
+static volatile uint32_t c1725IntCount=0; /* interrupts received */
+#ifdef VXWORKS
+static SEM_ID c1725IntSem = NULL;      /* given by c1725Isr, that cannot take a mutex */
+#else
+static pthread_mutex_t c1725IntMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  c1725IntCond = PTHREAD_COND_INITIALIZER;
+#endif
+static uint32_t c1725DMATransfers=0;   /* DMAs started by the readout routines */
+static uint32_t c1725DMARetries=0;     /* DMAs repeated to complete a readout */
+static uint32_t c1725DMAReadouts=0;    /* readouts done by DMA */
+static uint32_t c1725DMASaved=0;       /* DMAs saved compared to fixed 4 KB transfers */
+static uint32_t c1725ExtBlkSpace[MAX_VME_SLOTS+1]; /* readout_ctrl EXT_BLK_SPACE, for DMA sizes */
+
+/* DMA readout in progress.  Guarded by c1725DmaMutex */
+static struct
+{
+  int32_t active;                 /* c1725DmaStart called, c1725DmaFinish not yet */
+  int32_t id;                     /* slot whose readout_status flags the end of data */
+  int32_t dummy;                  /* alignment filler inserted */
+  int32_t xferCount;              /* words completed */
+  int32_t nwrds;                  /* words requested in the current DMA */
+  int32_t nwrds_leftover;         /* words still to request */
+  int32_t maxchunk;               /* most words one DMA can address */
+  int32_t dmas;                   /* DMAs issued */
+  volatile uint32_t *data;        /* destination of the readout */
+  volatile uint32_t *laddr;       /* destination of the current DMA */
+  unsigned long vmeAdr;
+} c1725Dma;
+
+/* Readout started by c1725ReadEventStart or c1725CBLTReadStart, that holds the DMA
+   lock until c1725ReadComplete.  Set and cleared by its thread */
+static int32_t   c1725ReadStarted = 0;
+static pthread_t c1725ReadOwner;
+
+/* Whether this thread started a readout not yet completed.  Taking the DMA lock
+   again would deadlock */
+static int32_t
+c1725ReadStartedHere()
+{
+  return __atomic_load_n(&c1725ReadStarted, __ATOMIC_ACQUIRE) &&
+    pthread_equal(c1725ReadOwner, pthread_self());
+}
+
+/* Refuse what takes the DMA lock, in the thread that holds it for a started readout */
+#define CHECKREADSTARTED						\
+  if(c1725ReadStartedHere())						\
+    {									\
+      fprintf(stderr, "%s: ERROR: Readout in progress, finish it with c1725ReadComplete\n", \
+	      __func__);						\
+      return ERROR;							\
+    }
 
 /* Some globals for test routines */
 static int32_t def_acq_ctrl=0x1;       /* default acq_ctrl */
@@ -73,6 +165,256 @@ static int32_t def_dac_val=0x1000;     /* default DAC setting for each channel *
       return ERROR;							\
     }
 
+#define C1725_CALIB_TIMEOUT_US 1000000 /* c1725ADCCalibration */
+#define C1725_CALIB_POLL_NS    1000000 /* pause between calibration status reads */
+
+/* Shadow of the configuration registers of each module, guarded by the slot
+   mutex.  Index from c1725ShadowIndex */
+#define C1725_SHADOW_NREG  (1024 + 128 + 16)
+static uint32_t c1725Shadow[MAX_VME_SLOTS+1][C1725_SHADOW_NREG];
+static uint8_t  c1725ShadowValid[MAX_VME_SLOTS+1][C1725_SHADOW_NREG];
+static uint32_t c1725ShadowHits[MAX_VME_SLOTS+1];      /* reads served from the shadow */
+static uint32_t c1725ShadowMisses[MAX_VME_SLOTS+1];    /* cacheable reads from the module */
+static uint32_t c1725ShadowMismatch[MAX_VME_SLOTS+1];  /* shadow differed from the module */
+static int32_t  c1725ShadowMode = C1725_SHADOW_ENABLE;
+
+/* What c1725WriteReg does with a write (c1725SetWriteMode), and its counts */
+static int32_t  c1725WriteMode = C1725_WRITE_ALL;
+static uint32_t c1725Writes[MAX_VME_SLOTS+1];          /* writes made (or listed) */
+static uint32_t c1725WritesSkipped[MAX_VME_SLOTS+1];   /* writes of the value already held */
+
+/* Absolute CLOCK_REALTIME time timeout_us from now, for pthread_cond_timedwait */
+static void
+c1725Deadline(struct timespec *deadline, uint32_t timeout_us)
+{
+  clock_gettime(CLOCK_REALTIME, deadline);
+  deadline->tv_sec += timeout_us / 1000000;
+  deadline->tv_nsec += (timeout_us % 1000000) * 1000;
+  if(deadline->tv_nsec >= 1000000000)
+    {
+      deadline->tv_sec++;
+      deadline->tv_nsec -= 1000000000;
+    }
+}
+
+/* Microseconds since t0, from CLOCK_MONOTONIC */
+static uint64_t
+c1725ElapsedUs(struct timespec *t0)
+{
+  struct timespec t1;
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return (uint64_t) (t1.tv_sec - t0->tv_sec) * 1000000 + (t1.tv_nsec - t0->tv_nsec) / 1000;
+}
+
+/* Shadow index of a register offset, or -1 if it is not a configuration register */
+static int32_t
+c1725ShadowIndex(unsigned long offset)
+{
+  if((offset >= 0x1000) && (offset < 0x2000))
+    {
+      switch(offset & 0xFF)
+	{
+	case 0x20: case 0x28: case 0x34: case 0x38: case 0x60: case 0x64: case 0x68:
+	case 0x78: case 0x7C: case 0x80: case 0x84: case 0x98:
+	  return (offset - 0x1000) >> 2;
+	}
+      return -1; /* status, firmware_revision and adc_temperature */
+    }
+
+  switch(offset)
+    {
+    /* Not the read only roc_firmware_revision (0x8124) and board_info (0x8140) */
+    case 0x8000: case 0x8100: case 0x810C: case 0x8110: case 0x811C: case 0x8120:
+    case 0x8138: case 0x8144: case 0x8168: case 0x8170: case 0x81A0: case 0x81C4:
+      return 1024 + ((offset - 0x8000) >> 2);
+
+    case 0xEF00: case 0xEF08: case 0xEF0C: case 0xEF10: case 0xEF14: case 0xEF18:
+    case 0xEF1C: case 0xEF20:
+      return 1152 + ((offset - 0xEF00) >> 2);
+    }
+
+  return -1;
+}
+
+/* Offset of register chan_off of channel chan */
+#define C1725_CHAN_OFFSET(_chan, _chan_off)  (0x1000 + ((_chan) << 8) + (_chan_off))
+
+/* Register offset of a shadow index */
+static unsigned long
+c1725ShadowOffset(int32_t ireg)
+{
+  if(ireg < 1024)
+    return 0x1000 + (ireg << 2);
+  if(ireg < 1152)
+    return 0x8000 + ((ireg - 1024) << 2);
+
+  return 0xEF00 + ((ireg - 1152) << 2);
+}
+
+/* Read a register of module id, from the shadow if possible.  Slot lock held */
+static uint32_t
+c1725ReadReg(int32_t id, volatile uint32_t *reg)
+{
+  int32_t ireg;
+  uint32_t rval;
+
+  if(c1725ShadowMode == C1725_SHADOW_DISABLE)
+    return vmeRead32(reg);
+
+  ireg = c1725ShadowIndex((unsigned long) reg - (unsigned long) c1725p[id]);
+  if(ireg < 0)
+    return vmeRead32(reg);
+
+  if(c1725ShadowValid[id][ireg] && (c1725ShadowMode == C1725_SHADOW_ENABLE))
+    {
+      c1725ShadowHits[id]++;
+      return c1725Shadow[id][ireg];
+    }
+
+  rval = vmeRead32(reg);
+  c1725ShadowMisses[id]++;
+
+  if(c1725ShadowValid[id][ireg] && (rval != c1725Shadow[id][ireg]))
+    {
+      fprintf(stderr, "%s: WARN: slot %d register 0x%04lx = 0x%08x, shadow 0x%08x\n",
+	      __func__, id, c1725ShadowOffset(ireg), rval, c1725Shadow[id][ireg]);
+      c1725ShadowMismatch[id]++;
+    }
+
+  c1725Shadow[id][ireg] = rval;
+  c1725ShadowValid[id][ireg] = 1;
+
+  return rval;
+}
+
+/* Update the shadow of module id for a write of val to offset.  Slot lock held */
+static void
+c1725ShadowWrite(int32_t id, unsigned long offset, uint32_t val)
+{
+  int32_t ireg, ichan;
+
+  ireg = c1725ShadowIndex(offset);
+  if(ireg >= 0)
+    {
+      c1725Shadow[id][ireg] = val;
+      c1725ShadowValid[id][ireg] = 1;
+      return;
+    }
+
+  if(offset == 0x8004) /* config_bitset */
+    c1725Shadow[id][c1725ShadowIndex(0x8000)] |= val;
+  else if(offset == 0x8008) /* config_bitclear */
+    c1725Shadow[id][c1725ShadowIndex(0x8000)] &= ~val;
+  else if(((offset & 0xFF00) == 0x8000) &&
+	  (c1725ShadowIndex(0x1000 | (offset & 0xFF)) >= 0))
+    { /* All channel write */
+      for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	{
+	  ireg = c1725ShadowIndex(0x1000 | (ichan << 8) | (offset & 0xFF));
+	  c1725Shadow[id][ireg] = val;
+	  c1725ShadowValid[id][ireg] = 1;
+	}
+    }
+  else if((offset == 0xEF24) || (offset == 0xEF34)) /* software_reset, config_reload */
+    memset(c1725ShadowValid[id], 0, sizeof(c1725ShadowValid[id]));
+}
+
+/* Whether the shadow says register offset of module id holds val.  Slot lock held */
+static int32_t
+c1725ShadowHolds(int32_t id, unsigned long offset, uint32_t val)
+{
+  int32_t ireg = c1725ShadowIndex(offset);
+
+  return (ireg >= 0) && c1725ShadowValid[id][ireg] &&
+    (c1725ShadowMode == C1725_SHADOW_ENABLE) && (c1725Shadow[id][ireg] == val);
+}
+
+/* Whether the write mode skips a write of val to offset of module id, as it
+   already holds it.  Counted as skipped.  Slot lock held */
+static int32_t
+c1725WriteSkip(int32_t id, unsigned long offset, uint32_t val)
+{
+  if((c1725WriteMode == C1725_WRITE_ALL) || !c1725ShadowHolds(id, offset, val))
+    return 0;
+
+  c1725WritesSkipped[id]++;
+  return 1;
+}
+
+/* Whether the write mode drops a write of val to offset of module id, listing
+   it in a dry run.  Slot lock held */
+static int32_t
+c1725WriteFilter(int32_t id, unsigned long offset, uint32_t val)
+{
+  int32_t ireg = c1725ShadowIndex(offset);
+  int32_t known = (ireg >= 0) && c1725ShadowValid[id][ireg] &&
+    (c1725ShadowMode == C1725_SHADOW_ENABLE);
+
+  if(c1725WriteSkip(id, offset, val))
+    return 1;
+
+  c1725Writes[id]++;
+
+  if(c1725WriteMode != C1725_WRITE_DRYRUN)
+    return 0;
+
+  if(known)
+    printf("c1725 slot %2d: 0x%04lx = 0x%08x (was 0x%08x)\n",
+	   id, offset, val, c1725Shadow[id][ireg]);
+  else
+    printf("c1725 slot %2d: 0x%04lx = 0x%08x\n", id, offset, val);
+
+  return 1;
+}
+
+/* Write a register of module id, and keep the shadow up to date.  Slot lock held */
+static void
+c1725WriteReg(int32_t id, volatile uint32_t *reg, uint32_t val)
+{
+  unsigned long offset = (unsigned long) reg - (unsigned long) c1725p[id];
+
+  if(c1725WriteFilter(id, offset, val))
+    return;
+
+  vmeWrite32(reg, val);
+  c1725ShadowWrite(id, offset, val);
+}
+
+/* Write the register at offset of every initialized module with one cycle to
+   the MCST address, or one module at a time if it is not set up.  No locks held.
+   Refused during a readout started by this thread */
+static int32_t
+c1725MCSTWrite(unsigned long offset, uint32_t val)
+{
+  int32_t ic, id;
+
+  CHECKREADSTARTED;
+
+  if(c1725WriteMode == C1725_WRITE_DRYRUN)
+    {
+      printf("c1725 MCST   : 0x%04lx = 0x%08x\n", offset, val);
+      return OK;
+    }
+
+  C1725DMALOCK;
+  if(c1725MCSTp != NULL)
+    vmeWrite32((volatile uint32_t *) ((unsigned long) c1725MCSTp + offset), val);
+
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      id = c1725ID[ic];
+      C1725LOCK(id);
+      if(c1725MCSTp == NULL)
+	vmeWrite32((volatile uint32_t *) ((unsigned long) c1725p[id] + offset), val);
+      c1725ShadowWrite(id, offset, val);
+      C1725UNLOCK(id);
+    }
+  C1725DMAUNLOCK;
+
+  return OK;
+}
+
 int32_t
 c1725CheckAddresses()
 {
@@ -102,6 +444,9 @@ c1725CheckAddresses()
   CHECKOFFSET(0x1128, chan[1].input_dynamic_range);
   CHECKOFFSET(0x1828, chan[8].input_dynamic_range);
   CHECKOFFSET(0x8000, config);
+  CHECKOFFSET(0x8020, all_minimum_record_length);
+  CHECKOFFSET(0x8060, all_trigger_threshold);
+  CHECKOFFSET(0x8098, all_dc_offset);
   CHECKOFFSET(0x809C, channel_adc_calibration);
   CHECKOFFSET(0x8120, channel_enable_mask);
 
@@ -248,6 +593,11 @@ c1725Init(uint32_t addr, uint32_t addr_inc, int32_t nadc)
 
       c1725p[slot_number] = tmp_c1725;
       c1725ID[Nc1725++] = slot_number;
+      /* The shadow from the module itself, whatever happened to it since the last
+	 Init, so that a Download in C1725_WRITE_CHANGED mode writes what differs */
+      c1725ShadowRefresh(slot_number);
+      c1725ExtBlkSpace[slot_number] =
+	(vmeRead32(&tmp_c1725->readout_ctrl) & C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE) ? 1 : 0;
       printf("%s: Initialized C1725 in slot %d at address 0x%lx \n", __func__,
 	      slot_number, (unsigned long) c1725p[slot_number] - c1725AddrOffset);
     }
@@ -326,12 +676,12 @@ c1725PrintChanStatus(int32_t id, int32_t chan)
   CHECKID(id);
   if (chan < 0 || chan > 8) return ERROR;
 
-  C1725LOCK;
-  status           = vmeRead32(&c1725p[id]->chan[chan].status);
-  fpga_firmware    = vmeRead32(&c1725p[id]->chan[chan].firmware_revision);
-  dac              = vmeRead32(&c1725p[id]->chan[chan].dc_offset);
-  thresh           = vmeRead32(&c1725p[id]->chan[chan].trigger_threshold);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  status           = c1725ReadReg(id, &c1725p[id]->chan[chan].status);
+  fpga_firmware    = c1725ReadReg(id, &c1725p[id]->chan[chan].firmware_revision);
+  dac              = c1725ReadReg(id, &c1725p[id]->chan[chan].dc_offset);
+  thresh           = c1725ReadReg(id, &c1725p[id]->chan[chan].trigger_threshold);
+  C1725UNLOCK(id);
 
   printf("Channel %d   status (0x1%d88) = 0x%x \n",chan,chan,status);
   printf("      firmware (0x1%d8c) = 0x%x\n",
@@ -363,18 +713,18 @@ c1725PrintStatus(int32_t id)
   int32_t ichan;
 
   CHECKID(id);
-  C1725LOCK;
-  firmware     = vmeRead32(&c1725p[id]->roc_firmware_revision);
-  board_info   = vmeRead32(&c1725p[id]->board_info);
-  config  = vmeRead32(&c1725p[id]->config);
-  acq_ctrl     = vmeRead32(&c1725p[id]->acq_ctrl);
-  acq_status   = vmeRead32(&c1725p[id]->acq_status);
-  relocation_address   = vmeRead32(&c1725p[id]->relocation_address);
-  readout_status   = vmeRead32(&c1725p[id]->readout_status);
-  board_id     = vmeRead32(&c1725p[id]->board_id);
-  interrupt_id = vmeRead32(&c1725p[id]->interrupt_id);
-  global_trigger_mask = vmeRead32(&c1725p[id]->global_trigger_mask);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  firmware     = c1725ReadReg(id, &c1725p[id]->roc_firmware_revision);
+  board_info   = c1725ReadReg(id, &c1725p[id]->board_info);
+  config  = c1725ReadReg(id, &c1725p[id]->config);
+  acq_ctrl     = c1725ReadReg(id, &c1725p[id]->acq_ctrl);
+  acq_status   = c1725ReadReg(id, &c1725p[id]->acq_status);
+  relocation_address   = c1725ReadReg(id, &c1725p[id]->relocation_address);
+  readout_status   = c1725ReadReg(id, &c1725p[id]->readout_status);
+  board_id     = c1725ReadReg(id, &c1725p[id]->board_id);
+  interrupt_id = c1725ReadReg(id, &c1725p[id]->interrupt_id);
+  global_trigger_mask = c1725ReadReg(id, &c1725p[id]->global_trigger_mask);
+  C1725UNLOCK(id);
 
   c1725Base = (unsigned long)c1725p[id];
 
@@ -981,6 +1331,388 @@ c1725ChannelsStatus(int32_t id, int32_t sflag)
   return OK;
 }
 
+/* Fields of the status snapshot, for c1725StatusSnapshotJSON */
+typedef struct
+{
+  const char *name;
+  size_t offset;
+} c1725StatusField_t;
+
+#define BOARDFIELD(_f) { #_f, offsetof(c1725BoardStatus_t, _f) }
+static const c1725StatusField_t c1725BoardFields[] =
+  {
+    BOARDFIELD(slot), BOARDFIELD(a24), BOARDFIELD(firmware_major), BOARDFIELD(firmware_minor),
+    BOARDFIELD(firmware_date), BOARDFIELD(mcst_addr), BOARDFIELD(mcst_position),
+    BOARDFIELD(max_events_per_blt),
+    BOARDFIELD(trg_in_mode), BOARDFIELD(veto_polarity), BOARDFIELD(flag_trunc_event),
+    BOARDFIELD(acq_mode), BOARDFIELD(acq_arm), BOARDFIELD(acq_clock_external),
+    BOARDFIELD(lvds_busy_enable), BOARDFIELD(lvds_veto_enable), BOARDFIELD(lvds_runin_enable),
+    BOARDFIELD(running), BOARDFIELD(event_ready), BOARDFIELD(event_full),
+    BOARDFIELD(clock_external), BOARDFIELD(pll_locked), BOARDFIELD(acq_ready),
+    BOARDFIELD(sin_level), BOARDFIELD(trg_level), BOARDFIELD(shutdown), BOARDFIELD(temperature),
+    BOARDFIELD(intlevel), BOARDFIELD(optical_int), BOARDFIELD(vme_berr), BOARDFIELD(align64),
+    BOARDFIELD(address_relocate), BOARDFIELD(roak), BOARDFIELD(ext_blk_space),
+    BOARDFIELD(readout_event_ready), BOARDFIELD(berr_occurred), BOARDFIELD(vme_fifo_empty),
+    BOARDFIELD(event_stored), BOARDFIELD(event_size),
+    BOARDFIELD(failure_pll), BOARDFIELD(failure_temperature), BOARDFIELD(failure_power),
+    BOARDFIELD(global_trg_channel_mask), BOARDFIELD(global_trg_coinc_window),
+    BOARDFIELD(global_trg_majority), BOARDFIELD(global_trg_lvds),
+    BOARDFIELD(global_trg_external), BOARDFIELD(global_trg_software),
+    BOARDFIELD(fptrgout_channel_mask), BOARDFIELD(fptrgout_channel_logic),
+    BOARDFIELD(fptrgout_majority), BOARDFIELD(fptrgout_lvds),
+    BOARDFIELD(fptrgout_external), BOARDFIELD(fptrgout_software),
+    BOARDFIELD(fpio_level), BOARDFIELD(fpio_trgout_enable), BOARDFIELD(fpio_lvds_mask),
+    BOARDFIELD(fpio_trg_in_mask), BOARDFIELD(fpio_trg_out_mask),
+    BOARDFIELD(channel_enable_mask), BOARDFIELD(run_delay), BOARDFIELD(veto_delay),
+    BOARDFIELD(monitor_mode), BOARDFIELD(monitor_dac)
+  };
+#undef BOARDFIELD
+
+#define CHANFIELD(_f) { #_f, offsetof(c1725ChannelStatus_t, _f) }
+static const c1725StatusField_t c1725ChannelFields[] =
+  {
+    CHANFIELD(record_length), CHANFIELD(dynamic_range), CHANFIELD(input_delay),
+    CHANFIELD(pre_trigger), CHANFIELD(trigger_threshold), CHANFIELD(fixed_baseline),
+    CHANFIELD(samples_under_threshold), CHANFIELD(maximum_tail),
+    CHANFIELD(test_pulse_enable), CHANFIELD(test_pulse_rate), CHANFIELD(test_pulse_polarity),
+    CHANFIELD(self_trigger_enable), CHANFIELD(dc_offset),
+    CHANFIELD(memory_full), CHANFIELD(memory_empty), CHANFIELD(spi_busy),
+    CHANFIELD(calibration_done), CHANFIELD(overtemp), CHANFIELD(adc_temperature)
+  };
+#undef CHANFIELD
+
+#define NFIELDS(_t) (int32_t) (sizeof(_t) / sizeof(_t[0]))
+
+/* Status of module id from its registers.  Slot lock held */
+static void
+c1725BoardStatus(int32_t id, c1725BoardStatus_t *bs)
+{
+  volatile c1725_address *r = c1725p[id];
+  uint32_t rreg;
+  int32_t ichan;
+
+  memset(bs, 0, sizeof(c1725BoardStatus_t));
+
+  bs->slot = id;
+  bs->a24 = (uint32_t) ((unsigned long) c1725p[id] - c1725AddrOffset);
+
+  rreg = c1725ReadReg(id, &r->roc_firmware_revision);
+  bs->firmware_major = (rreg & C1725_ROC_FIRMWARE_MAJOR_MASK) >> 8;
+  bs->firmware_minor = (rreg & C1725_ROC_FIRMWARE_MINOR_MASK);
+  bs->firmware_date = (rreg & C1725_ROC_FIRMWARE_DATE_MASK) >> 16;
+
+  rreg = c1725ReadReg(id, &r->multicast_address);
+  bs->mcst_addr = (rreg & C1725_MCST_ADDR_MASK) << 24;
+  bs->mcst_position = (rreg & C1725_MCST_SLOT_MASK) >> 8;
+
+  bs->max_events_per_blt = c1725ReadReg(id, &r->max_events_per_blt) & C1725_MAX_EVT_BLT_MASK;
+
+  rreg = c1725ReadReg(id, &r->config);
+  bs->trg_in_mode = (rreg & C1725_CONFIG_TRG_IN_VETO) ? 1 : 0;
+  bs->veto_polarity = (rreg & C1725_CONFIG_VETO_LEVEL_HI) ? 1 : 0;
+  bs->flag_trunc_event = (rreg & C1725_CONFIG_FLAG_TRUNC_EVENT) ? 0 : 1;
+
+  rreg = c1725ReadReg(id, &r->acq_ctrl);
+  bs->acq_mode = (rreg & C1725_ACQ_MODE_MASK);
+  bs->acq_arm = (rreg & C1725_ACQ_RUN) ? 1 : 0;
+  bs->acq_clock_external = (rreg & C1725_ACQ_CLK_EXT) ? 1 : 0;
+  bs->lvds_busy_enable = (rreg & C1725_ACQ_LVDS_BUSY_ENABLE) ? 1 : 0;
+  bs->lvds_veto_enable = (rreg & C1725_ACQ_LVDS_VETO_ENABLE) ? 1 : 0;
+  bs->lvds_runin_enable = (rreg & C1725_ACQ_LVDS_RUNIN_ENABLE) ? 1 : 0;
+
+  rreg = c1725ReadReg(id, &r->acq_status);
+  bs->running = (rreg & C1725_ACQ_RUN) ? 1 : 0;
+  bs->event_ready = (rreg & C1725_ACQ_STATUS_EVENT_READY) ? 1 : 0;
+  bs->event_full = (rreg & C1725_ACQ_STATUS_EVENT_FULL) ? 1 : 0;
+  bs->clock_external = (rreg & C1725_ACQ_STATUS_CLK_EXTERNAL) ? 1 : 0;
+  bs->pll_locked = (rreg & C1725_ACQ_STATUS_PLL_LOCKED) ? 1 : 0;
+  bs->acq_ready = (rreg & C1725_ACQ_STATUS_ACQ_READY) ? 1 : 0;
+  bs->sin_level = (rreg & C1725_ACQ_STATUS_SINLEVEL) ? 1 : 0;
+  bs->trg_level = (rreg & C1725_ACQ_STATUS_TRGLEVEL) ? 1 : 0;
+  bs->shutdown = (rreg & C1725_ACQ_STATUS_SHUTDOWN) ? 1 : 0;
+  bs->temperature = (rreg & C1725_ACQ_STATUS_TEMP_MASK) >> 20;
+
+  rreg = c1725ReadReg(id, &r->readout_ctrl);
+  bs->intlevel = (rreg & C1725_READOUT_CTRL_INTLEVEL_MASK);
+  bs->optical_int = (rreg & C1725_READOUT_CTRL_OPTICAL_INT_ENABLE) ? 1 : 0;
+  bs->vme_berr = (rreg & C1725_READOUT_CTRL_BERR_ENABLE) ? 1 : 0;
+  bs->align64 = (rreg & C1725_READOUT_CTRL_ALIGN64_ENABLE) ? 1 : 0;
+  bs->address_relocate = (rreg & C1725_READOUT_CTRL_RELOC_ENABLE) ? 1 : 0;
+  bs->roak = (rreg & C1725_READOUT_CTRL_ROAK_ENABLE) ? 1 : 0;
+  bs->ext_blk_space = (rreg & C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE) ? 1 : 0;
+
+  rreg = c1725ReadReg(id, &r->readout_status);
+  bs->readout_event_ready = (rreg & C1725_READOUT_STATUS_EVENT_READY) ? 1 : 0;
+  bs->berr_occurred = (rreg & C1725_READOUT_STATUS_BERR_OCCURRED) ? 1 : 0;
+  bs->vme_fifo_empty = (rreg & C1725_READOUT_STATUS_VME_FIFO_EMPTY) ? 1 : 0;
+
+  bs->event_stored = c1725ReadReg(id, &r->event_stored);
+  bs->event_size = c1725ReadReg(id, &r->event_size);
+
+  rreg = c1725ReadReg(id, &r->board_failure_status);
+  bs->failure_pll = (rreg & C1725_BOARD_FAILURE_PLL_LOCK_LOST) ? 1 : 0;
+  bs->failure_temperature = (rreg & C1725_BOARD_FAILURE_OVER_TEMP) ? 1 : 0;
+  bs->failure_power = (rreg & C1725_BOARD_FAILURE_POWER_DOWN) ? 1 : 0;
+
+  rreg = c1725ReadReg(id, &r->global_trigger_mask);
+  bs->global_trg_channel_mask = rreg & C1725_GLOBAL_TRG_CHANNEL_MASK;
+  bs->global_trg_coinc_window = (rreg & C1725_GLOBAL_TRG_CHANNEL_COIN_WINDOW_MASK) >> 20;
+  bs->global_trg_majority = (rreg & C1725_GLOBAL_TRG_CHANNEL_MAJORITY_LEVEL_MASK) >> 24;
+  bs->global_trg_lvds = (rreg & C1725_GLOBAL_TRG_LVDS_ENABLE) ? 1 : 0;
+  bs->global_trg_external = (rreg & C1725_GLOBAL_TRG_EXTERNAL_ENABLE) ? 1 : 0;
+  bs->global_trg_software = (rreg & C1725_GLOBAL_TRG_SOFTWARE_ENABLE) ? 1 : 0;
+
+  rreg = c1725ReadReg(id, &r->fp_trg_out_enable_mask);
+  bs->fptrgout_channel_mask = rreg & C1725_FPTRGOUT_CHANNEL_MASK;
+  bs->fptrgout_channel_logic = (rreg & C1725_FPTRGOUT_CHANNEL_LOGIC_MASK) >> 8;
+  bs->fptrgout_majority = (rreg & C1725_FPTRGOUT_CHANNEL_MAJORITY_LEVEL_MASK) >> 10;
+  bs->fptrgout_lvds = (rreg & C1725_FPTRGOUT_LVDS_ENABLE) ? 1 : 0;
+  bs->fptrgout_external = (rreg & C1725_FPTRGOUT_EXTERNAL_ENABLE) ? 1 : 0;
+  bs->fptrgout_software = (rreg & C1725_FPTRGOUT_SOFTWARE_ENABLE) ? 1 : 0;
+
+  rreg = c1725ReadReg(id, &r->fp_io_ctrl);
+  bs->fpio_level = (rreg & C1725_FPIO_LEMO_LEVEL_TTL) ? 1 : 0;
+  bs->fpio_trgout_enable = (rreg & C1725_FPIO_TRGOUT_ENABLE) ? 1 : 0;
+  bs->fpio_lvds_mask = (rreg & C1725_FPIO_LVDS_MODE_MASK) >> 2;
+  bs->fpio_trg_in_mask = (rreg & C1725_FPIO_TRGIN_MODE_MASK) >> 10;
+  bs->fpio_trg_out_mask = (rreg & C1725_FPIO_TRGOUT_MODE_MASK) >> 14;
+
+  bs->channel_enable_mask = c1725ReadReg(id, &r->channel_enable_mask) & C1725_ENABLE_CHANNEL_MASK;
+  bs->run_delay = c1725ReadReg(id, &r->run_start_stop_delay) & C1725_RUNDELAY_MASK;
+  bs->veto_delay = c1725ReadReg(id, &r->extended_veto_delay) & C1725_EXTENDED_VETO_MASK;
+  bs->monitor_mode = c1725ReadReg(id, &r->analog_monitor_mode) & C1725_MONITOR_MODE_MASK;
+  bs->monitor_dac = c1725ReadReg(id, &r->voltage_level_mode_config) & C1725_MONITOR_DAC_MASK;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      volatile c1725_chan *c = &r->chan[ichan];
+      c1725ChannelStatus_t *cs = &bs->chan[ichan];
+
+      cs->record_length = c1725ReadReg(id, &c->minimum_record_length) & C1725_RECORD_LENGTH_MASK;
+      cs->dynamic_range = c1725ReadReg(id, &c->input_dynamic_range) & C1725_DYNAMIC_RANGE_MASK;
+      cs->input_delay = c1725ReadReg(id, &c->input_delay) & C1725_INPUT_DELAY_MASK;
+      cs->pre_trigger = c1725ReadReg(id, &c->pre_trigger) & C1725_PRE_TRIGGER_MASK;
+      cs->trigger_threshold = c1725ReadReg(id, &c->trigger_threshold) & C1725_TRIGGER_THRESHOLD_MASK;
+      cs->fixed_baseline = c1725ReadReg(id, &c->fixed_baseline) & C1725_FIXED_BASELINE_MASK;
+      cs->samples_under_threshold =
+	c1725ReadReg(id, &c->samples_under_threshold) & C1725_UNDER_THRESHOLD_MASK;
+      cs->maximum_tail = c1725ReadReg(id, &c->maximum_tail) & C1725_MAX_TAIL_MASK;
+
+      rreg = c1725ReadReg(id, &c->dpp_algorithm_ctrl) & C1725_DPP_CTRL_MASK;
+      cs->test_pulse_enable = (rreg & C1725_DPP_TEST_PULSE_ENABLE) ? 1 : 0;
+      cs->test_pulse_rate = (rreg & C1725_DPP_TEST_PULSE_RATE_MASK) >> 9;
+      cs->test_pulse_polarity = (rreg & C1725_DPP_TEST_PULSE_NEGATIVE) ? 1 : 0;
+      cs->self_trigger_enable = (rreg & C1725_DPP_SELF_TRIGGER_DISABLE) ? 0 : 1;
+
+      cs->dc_offset = c1725ReadReg(id, &c->dc_offset) & C1725_DC_OFFSET_MASK;
+
+      rreg = c1725ReadReg(id, &c->status);
+      cs->memory_full = (rreg & C1725_CHANNEL_STATUS_MEM_FULL) ? 1 : 0;
+      cs->memory_empty = (rreg & C1725_CHANNEL_STATUS_MEM_EMPY) ? 1 : 0;
+      cs->spi_busy = (rreg & C1725_CHANNEL_STATUS_SPI_BUSY) ? 1 : 0;
+      cs->calibration_done = (rreg & C1725_CHANNEL_STATUS_CALIB_DONE) ? 1 : 0;
+      cs->overtemp = (rreg & C1725_CHANNEL_STATUS_OVERTEMP) ? 1 : 0;
+
+      cs->adc_temperature = c1725ReadReg(id, &c->adc_temperature) & C1725_ADC_TEMP_MASK;
+    }
+}
+
+/**
+ * @brief Fill a status snapshot of all initialized modules.  Each module is read
+ *     in one locked pass: configuration registers from the shadow, status registers
+ *     from the module.
+ * @param[out] st Status snapshot
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GStatusSnapshot(c1725Status_t *st)
+{
+  struct timespec now;
+  int32_t ic, id;
+
+  if(st == NULL)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid st (NULL)\n", __func__);
+      return ERROR;
+    }
+
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  memset(st, 0, sizeof(c1725Status_t));
+  st->version = C1725_STATUS_VERSION;
+  st->nboards = Nc1725;
+  st->timestamp = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      id = c1725ID[ic];
+
+      C1725LOCK(id);
+      c1725BoardStatus(id, &st->board[ic]);
+      C1725UNLOCK(id);
+    }
+
+  return OK;
+}
+
+/* Append to buf at *len, as snprintf.  *len counts what did not fit too */
+static void
+c1725Append(char *buf, uint32_t size, uint32_t *len, const char *fmt, ...)
+{
+  va_list ap;
+  int32_t n;
+
+  va_start(ap, fmt);
+  n = vsnprintf((*len < size) ? &buf[*len] : NULL, (*len < size) ? size - *len : 0, fmt, ap);
+  va_end(ap);
+
+  if(n > 0)
+    *len += n;
+}
+
+/**
+ * @brief Write a status snapshot as JSON: {"version", "timestamp", "boards": [...]},
+ *     each board an object of its fields with "chan", an array of channel objects
+ * @param[in] st Status snapshot
+ * @param[out] buf Output, NUL terminated
+ * @param[in] size Size of buf
+ * @return Length of the JSON if successful, ERROR if buf is too small.
+ */
+int32_t
+c1725StatusSnapshotJSON(c1725Status_t *st, char *buf, uint32_t size)
+{
+  uint32_t len = 0, ib;
+  int32_t ifield, ichan;
+
+  if((st == NULL) || (buf == NULL) || (st->nboards > C1725_MAX_BOARDS))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid snapshot or buffer\n", __func__);
+      return ERROR;
+    }
+
+  c1725Append(buf, size, &len, "{\"version\":%u,\"timestamp\":%llu,\"boards\":[",
+	      st->version, (unsigned long long) st->timestamp);
+
+  for(ib = 0; ib < st->nboards; ib++)
+    {
+      c1725BoardStatus_t *bs = &st->board[ib];
+
+      c1725Append(buf, size, &len, "%s{", ib ? "," : "");
+      for(ifield = 0; ifield < NFIELDS(c1725BoardFields); ifield++)
+	c1725Append(buf, size, &len, "\"%s\":%u,", c1725BoardFields[ifield].name,
+		    *(uint32_t *) ((char *) bs + c1725BoardFields[ifield].offset));
+
+      c1725Append(buf, size, &len, "\"chan\":[");
+      for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	{
+	  c1725Append(buf, size, &len, "%s{", ichan ? "," : "");
+	  for(ifield = 0; ifield < NFIELDS(c1725ChannelFields); ifield++)
+	    c1725Append(buf, size, &len, "%s\"%s\":%u", ifield ? "," : "",
+			c1725ChannelFields[ifield].name,
+			*(uint32_t *) ((char *) &bs->chan[ichan] +
+				       c1725ChannelFields[ifield].offset));
+	  c1725Append(buf, size, &len, "}");
+	}
+      c1725Append(buf, size, &len, "]}");
+    }
+  c1725Append(buf, size, &len, "]}");
+
+  if(len >= size)
+    {
+      fprintf(stderr, "%s: ERROR: %u bytes needed, buffer is %u\n", __func__, len + 1, size);
+      return ERROR;
+    }
+
+  return len;
+}
+
+/* Header of a packed status snapshot, followed by nboards c1725BoardStatus_t.
+   Host byte order */
+typedef struct
+{
+  uint32_t magic;       /* C1725_STATUS_MAGIC */
+  uint32_t version;
+  uint32_t board_size;  /* sizeof(c1725BoardStatus_t) */
+  uint32_t nboards;
+  uint64_t timestamp;
+} c1725StatusPacked_t;
+
+/**
+ * @brief Pack a status snapshot into a compact binary: a header, then only the
+ *     boards in the snapshot
+ * @param[in] st Status snapshot
+ * @param[out] buf Output
+ * @param[in] size Size of buf
+ * @return Number of bytes if successful, ERROR otherwise.
+ */
+int32_t
+c1725StatusSnapshotPack(c1725Status_t *st, uint8_t *buf, uint32_t size)
+{
+  c1725StatusPacked_t hdr;
+  uint32_t nbytes;
+
+  if((st == NULL) || (buf == NULL) || (st->nboards > C1725_MAX_BOARDS))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid snapshot or buffer\n", __func__);
+      return ERROR;
+    }
+
+  nbytes = sizeof(hdr) + st->nboards * sizeof(c1725BoardStatus_t);
+  if(nbytes > size)
+    {
+      fprintf(stderr, "%s: ERROR: %u bytes needed, buffer is %u\n", __func__, nbytes, size);
+      return ERROR;
+    }
+
+  hdr.magic = C1725_STATUS_MAGIC;
+  hdr.version = st->version;
+  hdr.board_size = sizeof(c1725BoardStatus_t);
+  hdr.nboards = st->nboards;
+  hdr.timestamp = st->timestamp;
+
+  memcpy(buf, &hdr, sizeof(hdr));
+  memcpy(buf + sizeof(hdr), st->board, st->nboards * sizeof(c1725BoardStatus_t));
+
+  return nbytes;
+}
+
+/**
+ * @brief Unpack a status snapshot written by c1725StatusSnapshotPack
+ * @param[in] buf Packed snapshot
+ * @param[in] size Size of buf
+ * @param[out] st Status snapshot
+ * @return OK if successful, ERROR if buf is not a snapshot of this version.
+ */
+int32_t
+c1725StatusSnapshotUnpack(const uint8_t *buf, uint32_t size, c1725Status_t *st)
+{
+  c1725StatusPacked_t hdr;
+
+  if((buf == NULL) || (st == NULL) || (size < sizeof(hdr)))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid buffer or snapshot\n", __func__);
+      return ERROR;
+    }
+
+  memcpy(&hdr, buf, sizeof(hdr));
+  if((hdr.magic != C1725_STATUS_MAGIC) || (hdr.version != C1725_STATUS_VERSION) ||
+     (hdr.board_size != sizeof(c1725BoardStatus_t)) || (hdr.nboards > C1725_MAX_BOARDS) ||
+     (size < sizeof(hdr) + hdr.nboards * sizeof(c1725BoardStatus_t)))
+    {
+      fprintf(stderr, "%s: ERROR: Not a complete version %d status snapshot\n",
+	      __func__, C1725_STATUS_VERSION);
+      return ERROR;
+    }
+
+  memset(st, 0, sizeof(c1725Status_t));
+  st->version = hdr.version;
+  st->nboards = hdr.nboards;
+  st->timestamp = hdr.timestamp;
+  memcpy(st->board, buf + sizeof(hdr), hdr.nboards * sizeof(c1725BoardStatus_t));
+
+  return OK;
+}
+
 /**
  * @brief Set the BoardConfiguration
  * @param[in] id caen1725 slot ID
@@ -1015,13 +1747,13 @@ c1725SetBoardConfiguration(int32_t id, uint32_t trg_in_mode,
   else
     setbits |= C1725_CONFIG_FLAG_TRUNC_EVENT;
 
-  C1725LOCK;
+  C1725LOCK(id);
   if(setbits)
-    vmeWrite32(&c1725p[id]->config_bitset, setbits);
+    c1725WriteReg(id, &c1725p[id]->config_bitset, setbits);
 
   if(clearbits)
-    vmeWrite32(&c1725p[id]->config_bitclear, clearbits);
-  C1725UNLOCK;
+    c1725WriteReg(id, &c1725p[id]->config_bitclear, clearbits);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1042,19 +1774,19 @@ c1725GetBoardConfiguration(int32_t id, uint32_t *trg_in_mode,
   uint32_t rreg = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->config);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->config);
 
   *trg_in_mode = (rreg & C1725_CONFIG_TRG_IN_VETO) ? 1 : 0;
   *veto_polarity = (rreg & C1725_CONFIG_VETO_LEVEL_HI) ? 1 : 0;
   *flag_trunc_event = (rreg & C1725_CONFIG_FLAG_TRUNC_EVENT) ? 0 : 1;
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
 
 /**
- * @brief Perform ADC Calibration
+ * @brief Perform ADC Calibration, and wait for it to finish on every channel
  * @param[in] id caen1725 slot ID
  * @return OK if successful, ERROR otherwise.
  */
@@ -1062,29 +1794,117 @@ c1725GetBoardConfiguration(int32_t id, uint32_t *trg_in_mode,
 int32_t
 c1725ADCCalibration(int32_t id)
 {
-  int32_t iwait=0, maxwait=1000;
+  uint32_t donemask = 0;
+  struct timespec t0, poll = { 0, C1725_CALIB_POLL_NS };
   CHECKID(id);
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->channel_adc_calibration, 1);
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->channel_adc_calibration, 1);
+  C1725UNLOCK(id);
 
   /* Prescription from the manual */
-  while(iwait<maxwait)
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  while(c1725ElapsedUs(&t0) < C1725_CALIB_TIMEOUT_US)
+    {
+      c1725ADCCalibrationStatus(id, &donemask);
+      if(donemask == 0xFFFF)
+	return OK;
+      nanosleep(&poll, NULL);
+    }
+
+  fprintf(stderr, "%s(%d):: ERROR: Timeout in ADC Calibration (channels done 0x%04x)\n",
+	  __func__, id, donemask);
+  return ERROR;
+}
+
+/**
+ * @brief Start ADC Calibration of all initialized modules with a single write
+ *        to the multicast address.  Follow with c1725ADCCalibrationStatus or
+ *        c1725GADCCalibrationWait.
+ * @return OK if successful, ERROR otherwise.
+ */
+
+int32_t
+c1725GADCCalibrationStart()
+{
+  return c1725MCSTWrite(offsetof(c1725_address, channel_adc_calibration), 1);
+}
+
+/**
+ * @brief Get the ADC Calibration status of every channel, without waiting
+ * @param[in] id caen1725 slot ID
+ * @param[out] donemask Mask of channels with calibration done
+ * @return OK if successful, ERROR otherwise.
+ */
+
+int32_t
+c1725ADCCalibrationStatus(int32_t id, uint32_t *donemask)
+{
+  int32_t ichan;
+  CHECKID(id);
+
+  *donemask = 0;
+  C1725LOCK(id);
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    if(c1725ReadReg(id, &c1725p[id]->chan[ichan].status) & C1725_CHANNEL_STATUS_CALIB_DONE)
+      *donemask |= (1 << ichan);
+  C1725UNLOCK(id);
+
+  return OK;
+}
+
+/**
+ * @brief Wait for the ADC Calibration of all initialized modules to finish
+ * @param[in] timeout_us Longest wait, in microseconds
+ * @param[out] donemask Array, indexed by slot, of the channels with calibration done.
+ *                      May be NULL.
+ * @return OK if every channel finished, ERROR otherwise.
+ */
+
+int32_t
+c1725GADCCalibrationWait(uint32_t timeout_us, uint32_t *donemask)
+{
+  uint32_t done[MAX_VME_SLOTS+1];
+  int32_t ic, id, nleft = Nc1725, rval = OK;
+  struct timespec t0, poll = { 0, C1725_CALIB_POLL_NS };
+
+  memset(done, 0, sizeof(done));
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  while(nleft)
     {
-      if((vmeRead32(&c1725p[id]->chan[0].status) & C1725_CHANNEL_STATUS_CALIB_DONE)==1)
+      for(ic = 0, nleft = 0; ic < Nc1725; ic++)
+	{
+	  id = c1725ID[ic];
+	  if(done[id] == 0xFFFF)
+	    continue;
+
+	  c1725ADCCalibrationStatus(id, &done[id]);
+	  if(done[id] != 0xFFFF)
+	    nleft++;
+	}
+
+      if(nleft && (c1725ElapsedUs(&t0) >= timeout_us))
 	break;
-      iwait++;
+      if(nleft)
+	nanosleep(&poll, NULL);
     }
-  C1725UNLOCK;
 
-  if(iwait>=maxwait)
+  for(ic = 0; ic < Nc1725; ic++)
     {
-      fprintf(stderr, "%s(%d):: ERROR: Timeout in ADC Calibration\n",
-	      __func__, id);
-      return ERROR;
+      id = c1725ID[ic];
+      if(donemask)
+	donemask[id] = done[id];
+
+      if(done[id] != 0xFFFF)
+	{
+	  fprintf(stderr, "%s: ERROR: Slot %d: Timeout in ADC Calibration (channels done 0x%04x)\n",
+		  __func__, id, done[id]);
+	  rval = ERROR;
+	}
     }
 
-  return OK;
+  return rval;
 }
 
 /**
@@ -1122,19 +1942,55 @@ c1725SetAcquisitionControl(int32_t id, uint32_t mode, uint32_t arm, uint32_t clo
   wreg |= (lvds_veto_enable) ? C1725_ACQ_LVDS_VETO_ENABLE : 0;
   wreg |= (lvds_runin_enable) ? C1725_ACQ_LVDS_RUNIN_ENABLE : 0;
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->acq_ctrl, wreg);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->acq_ctrl, wreg);
+  C1725UNLOCK(id);
 
   return OK;
 }
 
 /**
- * @brief Get the acquisition control settings
- * @param[in] id caen1725 slot ID
- * @param[out] mode Start/Stop Mode (0: SW, 1: S-IN, 2: First Trigger, 3: LVDS)
- * @param[out] arm Start (1), Stop (0) acquisition
- * @param[out] clocksource Internal (0), External (1) clock source
+ * @brief Set the acquisition control of all initialized modules with a single
+ *        write to the multicast address (see c1725SetAcquisitionControl)
+ * @param[in] mode Start/Stop Mode (0: SW, 1: S-IN, 2: First Trigger, 3: LVDS)
+ * @param[in] arm Start (1), Stop (0) acquisition
+ * @param[in] clocksource Internal (0), External (1) clock source
+ * @param[in] lvds_busy_enable Enable busy LVDS i/o
+ * @param[in] lvds_veto_enable Enable veto LVDS i/o
+ * @param[in] lvds_runin_enable Enable RunIN LVDS i/o
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GSetAcquisitionControl(uint32_t mode, uint32_t arm, uint32_t clocksource,
+			    uint32_t lvds_busy_enable, uint32_t lvds_veto_enable,
+			    uint32_t lvds_runin_enable)
+{
+  uint32_t wreg = 0;
+
+  if(mode > C1725_ACQ_MODE_MASK)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid mode (%d)\n",
+	      __func__, mode);
+      return ERROR;
+    }
+
+  wreg = mode;
+
+  wreg |= (arm) ? C1725_ACQ_RUN : 0;
+  wreg |= (clocksource) ? C1725_ACQ_CLK_EXT : 0;
+  wreg |= (lvds_busy_enable) ? C1725_ACQ_LVDS_BUSY_ENABLE : 0;
+  wreg |= (lvds_veto_enable) ? C1725_ACQ_LVDS_VETO_ENABLE : 0;
+  wreg |= (lvds_runin_enable) ? C1725_ACQ_LVDS_RUNIN_ENABLE : 0;
+
+  return c1725MCSTWrite(offsetof(c1725_address, acq_ctrl), wreg);
+}
+
+/**
+ * @brief Get the acquisition control settings
+ * @param[in] id caen1725 slot ID
+ * @param[out] mode Start/Stop Mode (0: SW, 1: S-IN, 2: First Trigger, 3: LVDS)
+ * @param[out] arm Start (1), Stop (0) acquisition
+ * @param[out] clocksource Internal (0), External (1) clock source
  * @param[out] lvds_busy_enable Enable busy LVDS i/o
  * @param[out] lvds_veto_enable Enable veto LVDS i/o
  * @param[out] lvds_runin_enable Enable RunIN LVDS i/o
@@ -1150,8 +2006,8 @@ c1725GetAcquisitionControl(int32_t id, uint32_t *mode, uint32_t *arm, uint32_t *
   CHECKID(id);
 
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->acq_ctrl);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->acq_ctrl);
 
   *mode = (rreg & C1725_ACQ_MODE_MASK);
   *arm  = (rreg & C1725_ACQ_RUN) ? 1 : 0;
@@ -1160,7 +2016,7 @@ c1725GetAcquisitionControl(int32_t id, uint32_t *mode, uint32_t *arm, uint32_t *
   *lvds_veto_enable  = (rreg & C1725_ACQ_LVDS_VETO_ENABLE) ? 1 : 0;
   *lvds_runin_enable  = (rreg & C1725_ACQ_LVDS_RUNIN_ENABLE) ? 1 : 0;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1191,8 +2047,8 @@ c1725GetAcquisitionStatus(int32_t id, uint32_t *arm, uint32_t *eventready,
   CHECKID(id);
 
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->acq_status);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->acq_status);
 
   *arm  = (rreg & C1725_ACQ_RUN) ? 1 : 0;
   *eventready = (rreg & C1725_ACQ_STATUS_EVENT_READY) ? 1 : 0;
@@ -1204,7 +2060,7 @@ c1725GetAcquisitionStatus(int32_t id, uint32_t *arm, uint32_t *eventready,
   *shutdown =  (rreg & C1725_ACQ_STATUS_SHUTDOWN) ? 1 : 0;
   *temperature =  (rreg & C1725_ACQ_STATUS_TEMP_MASK) >> 20;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1220,9 +2076,9 @@ c1725SoftTrigger(int32_t id)
 {
 
   CHECKID(id);
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->sw_trigger, 1);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->sw_trigger, 1);
+  C1725UNLOCK(id);
 
   return OK;
 
@@ -1282,9 +2138,9 @@ c1725SetGlobalTrigger(int32_t id, uint32_t channel_enable,
 
 
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->global_trigger_mask, enablebits);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->global_trigger_mask, enablebits);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1310,8 +2166,8 @@ c1725GetGlobalTrigger(int32_t id, uint32_t *channel_enable,
   CHECKID(id);
 
 
-  C1725LOCK;
-  rval = vmeRead32(&c1725p[id]->global_trigger_mask);
+  C1725LOCK(id);
+  rval = c1725ReadReg(id, &c1725p[id]->global_trigger_mask);
 
   *channel_enable = rval & C1725_GLOBAL_TRG_CHANNEL_MASK;
   *majority_coincidence_window = (rval & C1725_GLOBAL_TRG_CHANNEL_COIN_WINDOW_MASK) >> 20;
@@ -1321,7 +2177,7 @@ c1725GetGlobalTrigger(int32_t id, uint32_t *channel_enable,
   *external_trigger_enable  = (rval & C1725_GLOBAL_TRG_EXTERNAL_ENABLE) ? 1 : 0;
   *software_trigger_enable = (rval & C1725_GLOBAL_TRG_SOFTWARE_ENABLE) ? 1 : 0;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1378,9 +2234,9 @@ c1725SetFPTrigOut(int32_t id, uint32_t channel_enable, uint32_t channel_logic,
   enablebits |= external_trigger_enable ? C1725_FPTRGOUT_EXTERNAL_ENABLE : 0;
   enablebits |= software_trigger_enable ? C1725_FPTRGOUT_SOFTWARE_ENABLE : 0;
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->fp_trg_out_enable_mask, enablebits);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->fp_trg_out_enable_mask, enablebits);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1404,8 +2260,8 @@ c1725GetFPTrigOut(int32_t id, uint32_t *channel_enable, uint32_t *channel_logic,
   uint32_t rval = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rval = vmeRead32(&c1725p[id]->fp_trg_out_enable_mask);
+  C1725LOCK(id);
+  rval = c1725ReadReg(id, &c1725p[id]->fp_trg_out_enable_mask);
 
   *channel_enable = rval & C1725_FPTRGOUT_CHANNEL_MASK;
   *channel_logic = (rval & C1725_FPTRGOUT_CHANNEL_LOGIC_MASK) >> 8;
@@ -1414,7 +2270,7 @@ c1725GetFPTrigOut(int32_t id, uint32_t *channel_enable, uint32_t *channel_logic,
   *lvds_trigger_enable = (rval & C1725_FPTRGOUT_LVDS_ENABLE) ? 1 : 0;
   *external_trigger_enable  = (rval & C1725_FPTRGOUT_EXTERNAL_ENABLE) ? 1 : 0;
   *software_trigger_enable = (rval & C1725_FPTRGOUT_SOFTWARE_ENABLE) ? 1 : 0;
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1466,9 +2322,9 @@ c1725SetFPIO(int32_t id, uint32_t lemo_level, uint32_t lemo_enable,
 
   enablebits |= (trg_out_mask << 14);
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->fp_io_ctrl, enablebits);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->fp_io_ctrl, enablebits);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1490,8 +2346,8 @@ c1725GetFPIO(int32_t id, uint32_t *lemo_level, uint32_t *lemo_enable,
   uint32_t rval = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rval = vmeRead32(&c1725p[id]->fp_io_ctrl);
+  C1725LOCK(id);
+  rval = c1725ReadReg(id, &c1725p[id]->fp_io_ctrl);
 
   *lemo_level = (rval & C1725_FPIO_LEMO_LEVEL_TTL) ? 1 : 0;
   *lemo_enable = (rval & C1725_FPIO_TRGOUT_ENABLE) ? 1 : 0;
@@ -1500,7 +2356,7 @@ c1725GetFPIO(int32_t id, uint32_t *lemo_level, uint32_t *lemo_enable,
   *trg_in_mask = (rval & C1725_FPIO_TRGIN_MODE_MASK) >> 10;
   *trg_out_mask = (rval & C1725_FPIO_TRGOUT_MODE_MASK) >> 14;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1520,14 +2376,14 @@ c1725GetROCFimwareRevision(int32_t id, uint32_t *major, uint32_t *minor, uint32_
   uint32_t rreg = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->roc_firmware_revision);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->roc_firmware_revision);
 
   *major = (rreg & C1725_ROC_FIRMWARE_MAJOR_MASK) >> 8;
   *minor = (rreg & C1725_ROC_FIRMWARE_MINOR_MASK);
   *date = (rreg & C1725_ROC_FIRMWARE_DATE_MASK) >> 16;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1551,9 +2407,9 @@ c1725SetEnableChannelMask(int32_t id, uint32_t chanmask)
       return ERROR;
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->channel_enable_mask,chanmask);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->channel_enable_mask,chanmask);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1570,9 +2426,9 @@ c1725GetEnableChannelMask(int32_t id, uint32_t *chanmask)
 {
   CHECKID(id);
 
-  C1725LOCK;
-  *chanmask = vmeRead32(&c1725p[id]->channel_enable_mask) & C1725_ENABLE_CHANNEL_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *chanmask = c1725ReadReg(id, &c1725p[id]->channel_enable_mask) & C1725_ENABLE_CHANNEL_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1596,9 +2452,9 @@ c1725SetRunDelay(int32_t id, uint32_t run_delay)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->run_start_stop_delay, run_delay);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->run_start_stop_delay, run_delay);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1614,9 +2470,9 @@ c1725GetRunDelay(int32_t id, uint32_t *run_delay)
 {
   CHECKID(id);
 
-  C1725LOCK;
-  *run_delay = vmeRead32(&c1725p[id]->run_start_stop_delay) & C1725_RUNDELAY_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *run_delay = c1725ReadReg(id, &c1725p[id]->run_start_stop_delay) & C1725_RUNDELAY_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1640,9 +2496,9 @@ c1725SetExtendedVetoDelay(int32_t id, uint32_t veto_delay)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->extended_veto_delay, veto_delay);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->extended_veto_delay, veto_delay);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1658,9 +2514,9 @@ c1725GetExtendedVetoDelay(int32_t id, uint32_t *veto_delay)
 {
   CHECKID(id);
 
-  C1725LOCK;
-  *veto_delay = vmeRead32(&c1725p[id]->extended_veto_delay) & C1725_EXTENDED_VETO_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *veto_delay = c1725ReadReg(id, &c1725p[id]->extended_veto_delay) & C1725_EXTENDED_VETO_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1676,9 +2532,9 @@ c1725GetEventSize(int32_t id, uint32_t *eventsize)
 {
   CHECKID(id);
 
-  C1725LOCK;
-  *eventsize = vmeRead32(&c1725p[id]->event_size);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *eventsize = c1725ReadReg(id, &c1725p[id]->event_size);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1695,9 +2551,9 @@ c1725GetEvStored(int32_t id, uint32_t *evstored)
 {
   CHECKID(id);
 
-  C1725LOCK;
-  *evstored = vmeRead32(&c1725p[id]->event_stored);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *evstored = c1725ReadReg(id, &c1725p[id]->event_stored);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1722,9 +2578,9 @@ c1725SetMonitorDAC(int32_t id, int32_t dac)
       return ERROR;
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->voltage_level_mode_config, dac);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->voltage_level_mode_config, dac);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1755,9 +2611,9 @@ c1725SetMonitorMode(int32_t id, int32_t mode)
       return ERROR;
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->analog_monitor_mode, mode);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->analog_monitor_mode, mode);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1779,13 +2635,13 @@ c1725GetBoardFailureStatus(int32_t id, uint32_t *pll, uint32_t *temperature, uin
   uint32_t rreg = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->board_failure_status);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->board_failure_status);
 
   *pll = (rreg & C1725_BOARD_FAILURE_PLL_LOCK_LOST) ? 1 : 0;
   *temperature = (rreg & C1725_BOARD_FAILURE_OVER_TEMP) ? 1 : 0;
   *powerdown = (rreg & C1725_BOARD_FAILURE_POWER_DOWN) ? 1 : 0 ;
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1793,7 +2649,8 @@ c1725GetBoardFailureStatus(int32_t id, uint32_t *pll, uint32_t *temperature, uin
 /**
  * @brief Set the Readout Control
  * @param[in] id caen1725 slot ID
- * @param[in] intlevel VME Interrupt Level
+ * @param[in] intlevel VME Interrupt Level.  Kept as c1725IntConnect set it while
+ *                     the interrupts are connected.
  * @param[in] optical_int Optical Link Interrupt Enable
  * @param[in] vme_berr VME Bus Error / Event Aligned Readout Enable
  * @param[in] align64 64-bit aligned readout mode Enable
@@ -1826,9 +2683,14 @@ c1725SetReadoutControl(int32_t id, uint32_t intlevel, uint32_t optical_int,
   wreg |= roak ? C1725_READOUT_CTRL_ROAK_ENABLE : 0;
   wreg |= ext_blk_space ? C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE : 0;
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->readout_ctrl, wreg);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  if(c1725IntRunning)
+    wreg = (wreg & ~C1725_READOUT_CTRL_INTLEVEL_MASK) |
+      (c1725ReadReg(id, &c1725p[id]->readout_ctrl) & C1725_READOUT_CTRL_INTLEVEL_MASK);
+  c1725WriteReg(id, &c1725p[id]->readout_ctrl, wreg);
+  if(c1725WriteMode != C1725_WRITE_DRYRUN)
+    c1725ExtBlkSpace[id] = ext_blk_space ? 1 : 0;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1854,8 +2716,8 @@ c1725GetReadoutControl(int32_t id, uint32_t *intlevel, uint32_t *optical_int,
   uint32_t rreg = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->readout_ctrl);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->readout_ctrl);
 
   *intlevel = (rreg & C1725_READOUT_CTRL_INTLEVEL_MASK);
   *optical_int = (rreg & C1725_READOUT_CTRL_OPTICAL_INT_ENABLE) ? 1 : 0;
@@ -1865,7 +2727,7 @@ c1725GetReadoutControl(int32_t id, uint32_t *intlevel, uint32_t *optical_int,
   *roak = (rreg & C1725_READOUT_CTRL_ROAK_ENABLE) ? 1 : 0;
   *ext_blk_space = (rreg & C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE) ? 1 : 0;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1884,13 +2746,13 @@ c1725GetReadoutStatus(int32_t id, uint32_t *event_ready, uint32_t *berr, uint32_
   uint32_t rreg = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->readout_status);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->readout_status);
 
   *event_ready = (rreg & C1725_READOUT_STATUS_EVENT_READY) ? 1 : 0;
   *berr = (rreg & C1725_READOUT_STATUS_BERR_OCCURRED) ? 1 : 0;
   *vme_fifo_empty = (rreg & C1725_READOUT_STATUS_VME_FIFO_EMPTY) ? 1 : 0;
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -1966,9 +2828,9 @@ c1725SetMulticast(uint32_t baseaddr)
 	  printf("\tMiddle board at 0x%08lx\n",(unsigned long)c1725p[id] - c1725AddrOffset);
 	}
 
-      C1725LOCK;
-      vmeWrite32(&c1725p[id]->multicast_address, wreg);
-      C1725UNLOCK;
+      C1725LOCK(id);
+      c1725WriteReg(id, &c1725p[id]->multicast_address, wreg);
+      C1725UNLOCK(id);
 
     }
 
@@ -1989,9 +2851,9 @@ c1725DisableMulticast()
     {
       id = c1725ID[ii];
 
-      C1725LOCK;
-      vmeWrite32(&c1725p[id]->multicast_address, 0);
-      C1725UNLOCK;
+      C1725LOCK(id);
+      c1725WriteReg(id, &c1725p[id]->multicast_address, 0);
+      C1725UNLOCK(id);
 
     }
 
@@ -2012,12 +2874,12 @@ c1725GetMulticast(int32_t id, uint32_t *addr, uint32_t *position)
   uint32_t rreg = 0;
   CHECKID(id);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->multicast_address);
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->multicast_address);
 
   *addr = (rreg & C1725_MCST_ADDR_MASK) << 24;
   *position = (rreg & C1725_MCST_SLOT_MASK) >> 8;
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2042,9 +2904,9 @@ c1725SetMaxEventsPerBLT(int32_t id, uint32_t max_events)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->max_events_per_blt, max_events);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->max_events_per_blt, max_events);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2061,9 +2923,9 @@ c1725GetMaxEventsPerBLT(int32_t id, uint32_t *max_events)
 {
   CHECKID(id);
 
-  C1725LOCK;
-  *max_events = vmeRead32(&c1725p[id]->max_events_per_blt) & C1725_MAX_EVT_BLT_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *max_events = c1725ReadReg(id, &c1725p[id]->max_events_per_blt) & C1725_MAX_EVT_BLT_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2075,6 +2937,7 @@ c1725GetMaxEventsPerBLT(int32_t id, uint32_t *max_events)
  *      and performs a FPGAs global reset to restore FPGAs to
  *      their default config.  Also initializes counters to
  *      their initial state and clears all error conditions.
+ *      The register shadow is cleared.
  *
  * RETURNS: OK if successful, ERROR otherwise.
  *
@@ -2084,11 +2947,13 @@ int32_t
 c1725Reset(int32_t id)
 {
   CHECKID(id);
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->software_reset, 1);
-  vmeWrite32(&c1725p[id]->readout_ctrl, 0x10);
-  vmeWrite32(&c1725p[id]->channel_enable_mask, 0xff);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->software_reset, 1);
+  c1725WriteReg(id, &c1725p[id]->readout_ctrl, 0x10);
+  if(c1725WriteMode != C1725_WRITE_DRYRUN)
+    c1725ExtBlkSpace[id] = 0;
+  c1725WriteReg(id, &c1725p[id]->channel_enable_mask, 0xff);
+  C1725UNLOCK(id);
 
   return OK;
 
@@ -2096,7 +2961,8 @@ c1725Reset(int32_t id)
 
 /**************************************************************************************
  *
- * c1725Clear  - Clear the output buffer
+ * c1725Clear  - Clear the output buffer.  The configuration registers, and so
+ *      the register shadow, are kept.
  *
  * RETURNS: OK if successful, ERROR otherwise.
  *
@@ -2106,12 +2972,272 @@ int32_t
 c1725Clear(int32_t id)
 {
   CHECKID(id);
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->software_clear, 1);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->software_clear, 1);
+  C1725UNLOCK(id);
+
+  return OK;
+
+}
+
+/**
+ * @brief Clear the data of all initialized modules with a single write to the
+ *        multicast address
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GClear()
+{
+  return c1725MCSTWrite(offsetof(c1725_address, software_clear), 1);
+}
+
+/**
+ * @brief Set how the Get routines read configuration registers.  The default is
+ *        C1725_SHADOW_ENABLE.  The shadow only knows the writes of this library: it is
+ *        cleared by c1725Reset (a data clear keeps it), but after a module is reset or
+ *        written any other way (another process, a power cycle) call
+ *        c1725ShadowInvalidate or c1725ShadowRefresh, or the Get routines return the
+ *        values it last wrote.
+ * @param[in] mode
+ *     C1725_SHADOW_DISABLE - always read the module
+ *     C1725_SHADOW_ENABLE  - read the module once, then the shadow kept by the Set routines
+ *     C1725_SHADOW_CHECK   - always read the module, and report differences from the shadow
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725SetShadowMode(int32_t mode)
+{
+  if((mode < C1725_SHADOW_DISABLE) || (mode > C1725_SHADOW_CHECK))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid mode (%d)\n", __func__, mode);
+      return ERROR;
+    }
+
+  c1725ShadowMode = mode;
+
+  return OK;
+}
+
+/**
+ * @brief Get the shadow mode
+ * @return shadow mode (see c1725SetShadowMode)
+ */
+int32_t
+c1725GetShadowMode()
+{
+  return c1725ShadowMode;
+}
+
+/**
+ * @brief Forget the shadow of a module, so that the Get routines read it again
+ * @param[in] id caen1725 slot ID
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725ShadowInvalidate(int32_t id)
+{
+  CHECKID(id);
+
+  C1725LOCK(id);
+  memset(c1725ShadowValid[id], 0, sizeof(c1725ShadowValid[id]));
+  C1725UNLOCK(id);
+
+  return OK;
+}
+
+/**
+ * @brief Read all configuration registers of a module into its shadow
+ * @param[in] id caen1725 slot ID
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725ShadowRefresh(int32_t id)
+{
+  int32_t ireg;
+  CHECKID(id);
+
+  C1725LOCK(id);
+  for(ireg = 0; ireg < C1725_SHADOW_NREG; ireg++)
+    {
+      unsigned long offset = c1725ShadowOffset(ireg);
+
+      if(c1725ShadowIndex(offset) != ireg)
+	continue;
+
+      c1725Shadow[id][ireg] =
+	vmeRead32((volatile uint32_t *) ((unsigned long) c1725p[id] + offset));
+      c1725ShadowValid[id][ireg] = 1;
+    }
+  C1725UNLOCK(id);
+
+  return OK;
+}
+
+/**
+ * @brief Compare the shadow of a module with its configuration registers
+ * @param[in] id caen1725 slot ID
+ * @param[in] pflag Print each difference if not 0
+ * @return Number of registers that differ, or ERROR.
+ */
+int32_t
+c1725ShadowCheck(int32_t id, int32_t pflag)
+{
+  int32_t ireg, nbad = 0;
+  uint32_t rval;
+  CHECKID(id);
+
+  C1725LOCK(id);
+  for(ireg = 0; ireg < C1725_SHADOW_NREG; ireg++)
+    {
+      unsigned long offset = c1725ShadowOffset(ireg);
+
+      if(!c1725ShadowValid[id][ireg])
+	continue;
+
+      rval = vmeRead32((volatile uint32_t *) ((unsigned long) c1725p[id] + offset));
+      if(rval != c1725Shadow[id][ireg])
+	{
+	  if(pflag)
+	    printf("%s: slot %d register 0x%04lx = 0x%08x, shadow 0x%08x\n",
+		   __func__, id, offset, rval, c1725Shadow[id][ireg]);
+	  c1725ShadowMismatch[id]++;
+	  nbad++;
+	}
+    }
+  C1725UNLOCK(id);
+
+  return nbad;
+}
+
+/**
+ * @brief Read a list of registers from a module in one locked pass, bypassing the
+ *     shadow, and compare them with the values they should hold.  The shadow of the
+ *     configuration registers is updated with what was read, so that a later write
+ *     in C1725_WRITE_CHANGED mode restores a register that differs.
+ * @param[in] id caen1725 slot ID
+ * @param[in,out] regs Registers to read.  readback is filled for each
+ * @param[in] nregs Number of registers in regs
+ * @return Number of registers where (readback ^ expected) & mask is not 0, or ERROR.
+ */
+int32_t
+c1725Readback(int32_t id, c1725Readback_t *regs, int32_t nregs)
+{
+  int32_t ir, ireg, nbad = 0;
+  uint32_t rval;
+  CHECKID(id);
+
+  if((regs == NULL) || (nregs < 0))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid regs (%p, %d)\n", __func__, regs, nregs);
+      return ERROR;
+    }
+
+  for(ir = 0; ir < nregs; ir++)
+    {
+      if((regs[ir].offset & 0x3) || (regs[ir].offset >= sizeof(c1725_address)))
+	{
+	  fprintf(stderr, "%s: ERROR: Invalid offset (0x%x) for %s\n",
+		  __func__, regs[ir].offset, regs[ir].name ? regs[ir].name : "register");
+	  return ERROR;
+	}
+    }
+
+  C1725LOCK(id);
+  for(ir = 0; ir < nregs; ir++)
+    {
+      rval = vmeRead32((volatile uint32_t *) ((unsigned long) c1725p[id] + regs[ir].offset));
+      regs[ir].readback = rval;
+
+      if((rval ^ regs[ir].expected) & regs[ir].mask)
+	nbad++;
+
+      ireg = c1725ShadowIndex(regs[ir].offset);
+      if(ireg < 0)
+	continue;
+
+      if(c1725ShadowValid[id][ireg] && (rval != c1725Shadow[id][ireg]))
+	c1725ShadowMismatch[id]++;
+      c1725Shadow[id][ireg] = rval;
+      c1725ShadowValid[id][ireg] = 1;
+    }
+  C1725UNLOCK(id);
+
+  return nbad;
+}
+
+/**
+ * @brief Get the shadow counters of a module
+ * @param[in] id caen1725 slot ID
+ * @param[out] hits Reads served from the shadow
+ * @param[out] misses Configuration register reads from the module
+ * @param[out] mismatches Differences found between the shadow and the module
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GetShadowStats(int32_t id, uint32_t *hits, uint32_t *misses, uint32_t *mismatches)
+{
+  CHECKID(id);
+
+  C1725LOCK(id);
+  *hits = c1725ShadowHits[id];
+  *misses = c1725ShadowMisses[id];
+  *mismatches = c1725ShadowMismatch[id];
+  C1725UNLOCK(id);
+
+  return OK;
+}
+
+/**
+ * @brief Set what the Set routines do with a configuration register write
+ * @param[in] mode
+ *     C1725_WRITE_ALL     - write every register
+ *     C1725_WRITE_CHANGED - skip writes of the value the shadow shows the register holds
+ *     C1725_WRITE_DRYRUN  - as C1725_WRITE_CHANGED, but print the writes instead of
+ *                           making them
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725SetWriteMode(int32_t mode)
+{
+  if((mode < C1725_WRITE_ALL) || (mode > C1725_WRITE_DRYRUN))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid mode (%d)\n", __func__, mode);
+      return ERROR;
+    }
+
+  c1725WriteMode = mode;
 
   return OK;
+}
+
+/**
+ * @brief Get the write mode
+ * @return write mode (see c1725SetWriteMode)
+ */
+int32_t
+c1725GetWriteMode()
+{
+  return c1725WriteMode;
+}
+
+/**
+ * @brief Get the register write counts of a module
+ * @param[in] id caen1725 slot ID
+ * @param[out] writes Writes made, or printed in a dry run
+ * @param[out] skipped Writes skipped because the register held the value
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GetWriteStats(int32_t id, uint32_t *writes, uint32_t *skipped)
+{
+  CHECKID(id);
+
+  C1725LOCK(id);
+  *writes = c1725Writes[id];
+  *skipped = c1725WritesSkipped[id];
+  C1725UNLOCK(id);
 
+  return OK;
 }
 
 /**
@@ -2136,9 +3262,9 @@ c1725SetRecordLength(int32_t id, int32_t chan, uint32_t min_record_length)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].minimum_record_length, min_record_length);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].minimum_record_length, min_record_length);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2157,9 +3283,9 @@ c1725GetRecordLength(int32_t id, int32_t chan, uint32_t *min_record_length)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *min_record_length = vmeRead32(&c1725p[id]->chan[chan].minimum_record_length) & C1725_RECORD_LENGTH_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *min_record_length = c1725ReadReg(id, &c1725p[id]->chan[chan].minimum_record_length) & C1725_RECORD_LENGTH_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2186,9 +3312,9 @@ c1725SetDynamicRange(int32_t id, int32_t chan, uint32_t range)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].input_dynamic_range, range);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].input_dynamic_range, range);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2207,9 +3333,9 @@ c1725GetDynamicRange(int32_t id, int32_t chan, uint32_t *range)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *range = vmeRead32(&c1725p[id]->chan[chan].input_dynamic_range) & C1725_DYNAMIC_RANGE_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *range = c1725ReadReg(id, &c1725p[id]->chan[chan].input_dynamic_range) & C1725_DYNAMIC_RANGE_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2236,9 +3362,9 @@ c1725SetInputDelay(int32_t id, int32_t chan, uint32_t delay)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].input_delay, delay);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].input_delay, delay);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2257,9 +3383,9 @@ c1725GetInputDelay(int32_t id, int32_t chan, uint32_t *delay)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *delay = vmeRead32(&c1725p[id]->chan[chan].input_delay) & C1725_INPUT_DELAY_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *delay = c1725ReadReg(id, &c1725p[id]->chan[chan].input_delay) & C1725_INPUT_DELAY_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2286,9 +3412,9 @@ c1725SetPreTrigger(int32_t id, int32_t chan, uint32_t pretrigger)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].pre_trigger, pretrigger);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].pre_trigger, pretrigger);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2307,9 +3433,9 @@ c1725GetPreTrigger(int32_t id, int32_t chan, uint32_t *pretrigger)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *pretrigger = vmeRead32(&c1725p[id]->chan[chan].pre_trigger) & C1725_PRE_TRIGGER_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *pretrigger = c1725ReadReg(id, &c1725p[id]->chan[chan].pre_trigger) & C1725_PRE_TRIGGER_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2337,13 +3463,44 @@ c1725SetTriggerThreshold(int32_t id, int32_t chan, uint32_t thres)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].trigger_threshold, thres);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].trigger_threshold, thres);
+  C1725UNLOCK(id);
 
   return OK;
 }
 
+/**
+ * @brief Set the TriggerThreshold of all initialized modules with a single
+ *        write to the multicast address
+ * @param[in] chan Channel Number, or -1 for every channel
+ * @param[in] thres
+ * @return OK if successful, ERROR otherwise.
+ */
+
+int32_t
+c1725GSetTriggerThreshold(int32_t chan, uint32_t thres)
+{
+  if(chan != -1)
+    {
+      CHECKCHAN(chan);
+    }
+
+  if(thres > C1725_TRIGGER_THRESHOLD_MASK)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid thres (%d)\n",
+	      __func__, thres);
+      return ERROR;
+
+    }
+
+  if(chan == -1)
+    return c1725MCSTWrite(offsetof(c1725_address, all_trigger_threshold), thres);
+
+  return c1725MCSTWrite(offsetof(c1725_address, chan[0].trigger_threshold) +
+			chan * sizeof(c1725_chan), thres);
+}
+
 /**
  * @brief Get the TriggerThreshold for the specified channel
  * @param[in] id caen1725 slot ID
@@ -2358,9 +3515,9 @@ c1725GetTriggerThreshold(int32_t id, int32_t chan, uint32_t *thres)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *thres = vmeRead32(&c1725p[id]->chan[chan].trigger_threshold) & C1725_TRIGGER_THRESHOLD_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *thres = c1725ReadReg(id, &c1725p[id]->chan[chan].trigger_threshold) & C1725_TRIGGER_THRESHOLD_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2387,9 +3544,9 @@ c1725SetFixedBaseline(int32_t id, int32_t chan, uint32_t baseline)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].fixed_baseline, baseline);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].fixed_baseline, baseline);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2408,9 +3565,9 @@ c1725GetFixedBaseline(int32_t id, int32_t chan, uint32_t *baseline)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *baseline = vmeRead32(&c1725p[id]->chan[chan].fixed_baseline) & C1725_FIXED_BASELINE_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *baseline = c1725ReadReg(id, &c1725p[id]->chan[chan].fixed_baseline) & C1725_FIXED_BASELINE_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2437,9 +3594,9 @@ c1725SetCoupleTriggerLogic(int32_t id, int32_t chan, uint32_t logic)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].couple_trigger_logic, logic);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].couple_trigger_logic, logic);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2458,9 +3615,9 @@ c1725GetCoupleTriggerLogic(int32_t id, int32_t chan, uint32_t *logic)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *logic = vmeRead32(&c1725p[id]->chan[chan].couple_trigger_logic) & C1725_COUPLE_TRIGGER_LOGIC_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *logic = c1725ReadReg(id, &c1725p[id]->chan[chan].couple_trigger_logic) & C1725_COUPLE_TRIGGER_LOGIC_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2487,9 +3644,9 @@ c1725SetSamplesUnderThreshold(int32_t id, int32_t chan, uint32_t thres)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].samples_under_threshold, thres);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].samples_under_threshold, thres);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2508,9 +3665,9 @@ c1725GetSamplesUnderThreshold(int32_t id, int32_t chan, uint32_t *thres)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *thres = vmeRead32(&c1725p[id]->chan[chan].samples_under_threshold) & C1725_UNDER_THRESHOLD_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *thres = c1725ReadReg(id, &c1725p[id]->chan[chan].samples_under_threshold) & C1725_UNDER_THRESHOLD_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2537,9 +3694,9 @@ c1725SetMaxmimumTail(int32_t id, int32_t chan, uint32_t maxtail)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].maximum_tail, maxtail);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].maximum_tail, maxtail);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2558,9 +3715,9 @@ c1725GetMaxmimumTail(int32_t id, int32_t chan, uint32_t *maxtail)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *maxtail = vmeRead32(&c1725p[id]->chan[chan].maximum_tail) & C1725_MAX_TAIL_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *maxtail = c1725ReadReg(id, &c1725p[id]->chan[chan].maximum_tail) & C1725_MAX_TAIL_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2599,9 +3756,9 @@ c1725SetDPPControl(int32_t id, int32_t chan,
 
   wreg |= self_trigger_enable ? 0 : C1725_DPP_SELF_TRIGGER_DISABLE;
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].dpp_algorithm_ctrl, wreg);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].dpp_algorithm_ctrl, wreg);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2625,15 +3782,15 @@ c1725GetDPPControl(int32_t id, int32_t chan,
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->chan[chan].dpp_algorithm_ctrl) & C1725_DPP_CTRL_MASK;
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->chan[chan].dpp_algorithm_ctrl) & C1725_DPP_CTRL_MASK;
 
   *test_pulse_enable = (rreg & C1725_DPP_TEST_PULSE_ENABLE) ? 1 : 0;
   *test_pulse_rate = (rreg & C1725_DPP_TEST_PULSE_RATE_MASK) >> 9;
   *test_pulse_polarity = (rreg & C1725_DPP_TEST_PULSE_NEGATIVE) ? 1 : 0;
   *self_trigger_enable = (rreg & C1725_DPP_SELF_TRIGGER_DISABLE) ? 0 : 1;
 
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2660,9 +3817,9 @@ c1725SetCoupleOverTriggerLogic(int32_t id, int32_t chan, uint32_t logic)
 
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].couple_trigger_logic, logic);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].couple_trigger_logic, logic);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2681,9 +3838,9 @@ c1725GetCoupleOverTriggerLogic(int32_t id, int32_t chan, uint32_t *logic)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *logic = vmeRead32(&c1725p[id]->chan[chan].couple_trigger_logic);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *logic = c1725ReadReg(id, &c1725p[id]->chan[chan].couple_trigger_logic);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2705,13 +3862,13 @@ c1725GetChannelStatus(int32_t id, uint32_t chan, uint32_t *memory, uint32_t *spi
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  rreg = vmeRead32(&c1725p[id]->chan[chan].status) & C1725_CHANNEL_STATUS_MASK;
+  C1725LOCK(id);
+  rreg = c1725ReadReg(id, &c1725p[id]->chan[chan].status) & C1725_CHANNEL_STATUS_MASK;
   *memory = rreg & C1725_CHANNEL_STATUS_MEM_MASK;
   *spi_busy = (rreg & C1725_CHANNEL_STATUS_SPI_BUSY) ? 1 : 0;
   *calibration = (rreg & C1725_CHANNEL_STATUS_CALIB_DONE) ? 1 : 0;
   *overtemp = (rreg & C1725_CHANNEL_STATUS_OVERTEMP) ? 1 : 0;
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2729,9 +3886,9 @@ c1725GetADCTemperature(int32_t id, uint32_t chan, uint32_t *temperature)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *temperature = vmeRead32(&c1725p[id]->chan[chan].adc_temperature) & C1725_ADC_TEMP_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *temperature = c1725ReadReg(id, &c1725p[id]->chan[chan].adc_temperature) & C1725_ADC_TEMP_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2759,15 +3916,15 @@ c1725SetDCOffset(int32_t id, int32_t chan, uint32_t offset)
 
     }
 
-  C1725LOCK;
+  C1725LOCK(id);
   /* Prescription from the manual */
   while(iwait<maxwait)
     {
-      if((vmeRead32(&c1725p[id]->chan[chan].status) & C1725_CHANNEL_STATUS_SPI_BUSY)==0)
+      if((c1725ReadReg(id, &c1725p[id]->chan[chan].status) & C1725_CHANNEL_STATUS_SPI_BUSY)==0)
 	break;
       iwait++;
     }
-  C1725UNLOCK;
+  C1725UNLOCK(id);
 
   if(iwait>=maxwait)
     {
@@ -2776,9 +3933,9 @@ c1725SetDCOffset(int32_t id, int32_t chan, uint32_t offset)
       return ERROR;
     }
 
-  C1725LOCK;
-  vmeWrite32(&c1725p[id]->chan[chan].dc_offset, offset);
-  C1725UNLOCK;
+  C1725LOCK(id);
+  c1725WriteReg(id, &c1725p[id]->chan[chan].dc_offset, offset);
+  C1725UNLOCK(id);
 
   return OK;
 }
@@ -2797,395 +3954,1680 @@ c1725GetDCOffset(int32_t id, int32_t chan, uint32_t *offset)
   CHECKID(id);
   CHECKCHAN(chan);
 
-  C1725LOCK;
-  *offset = vmeRead32(&c1725p[id]->chan[chan].dc_offset) & C1725_DC_OFFSET_MASK;
-  C1725UNLOCK;
+  C1725LOCK(id);
+  *offset = c1725ReadReg(id, &c1725p[id]->chan[chan].dc_offset) & C1725_DC_OFFSET_MASK;
+  C1725UNLOCK(id);
 
   return OK;
 }
 
+/* DC offset loader: channels queued by c1725DACLoadQueue are written by
+   c1725DACLoadThread, which goes on to other channels and boards while a
+   channel's SPI is busy.  Masks guarded by mutex */
+#define C1725_DACLOAD_BACKOFF_NS  10000 /* pause after a pass with every SPI busy */
+static struct
+{
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  int32_t         running;
+  uint32_t        timeout_us;
+  uint32_t        pending[MAX_VME_SLOTS+1]; /* channels to write */
+  uint32_t        written[MAX_VME_SLOTS+1]; /* channels written, SPI not yet idle */
+  uint32_t        failed[MAX_VME_SLOTS+1];  /* channels that timed out */
+  uint32_t        offset[MAX_VME_SLOTS+1][C1725_MAX_ADC_CHANNELS];
+} c1725DacLoad = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+static void *
+c1725DACLoadThread(void *arg)
+{
+  uint32_t todo[MAX_VME_SLOTS+1], done, written, chmask;
+  struct timespec t0, backoff = { 0, C1725_DACLOAD_BACKOFF_NS };
+  int32_t id, ichan, ntodo = 1, nprogress;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  while(ntodo)
+    {
+      pthread_mutex_lock(&c1725DacLoad.mutex);
+      for(id = 0, ntodo = 0; id <= MAX_VME_SLOTS; id++)
+	{
+	  todo[id] = c1725DacLoad.pending[id] | c1725DacLoad.written[id];
+	  ntodo += (todo[id] != 0);
+	}
+      pthread_mutex_unlock(&c1725DacLoad.mutex);
+
+      /* One status read for each unfinished channel of every board */
+      nprogress = 0;
+      for(id = 0; id <= MAX_VME_SLOTS; id++)
+	{
+	  if(todo[id] == 0)
+	    continue;
+
+	  done = 0;
+	  written = 0;
+	  C1725LOCK(id);
+	  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	    {
+	      chmask = 1 << ichan;
+	      if(((todo[id] & chmask) == 0) ||
+		 (c1725ReadReg(id, &c1725p[id]->chan[ichan].status) & C1725_CHANNEL_STATUS_SPI_BUSY))
+		continue;
+
+	      if(c1725DacLoad.written[id] & chmask)
+		done |= chmask;
+	      else
+		{ /* The write mode was applied by c1725DACLoadQueue */
+		  vmeWrite32(&c1725p[id]->chan[ichan].dc_offset, c1725DacLoad.offset[id][ichan]);
+		  c1725ShadowWrite(id, (unsigned long) &c1725p[id]->chan[ichan].dc_offset -
+				   (unsigned long) c1725p[id], c1725DacLoad.offset[id][ichan]);
+		  written |= chmask;
+		}
+	    }
+	  C1725UNLOCK(id);
+	  nprogress += (done | written) != 0;
+
+	  pthread_mutex_lock(&c1725DacLoad.mutex);
+	  c1725DacLoad.pending[id] &= ~written;
+	  c1725DacLoad.written[id] = (c1725DacLoad.written[id] | written) & ~done;
+	  pthread_mutex_unlock(&c1725DacLoad.mutex);
+	}
+
+      if(c1725ElapsedUs(&t0) > c1725DacLoad.timeout_us)
+	break;
+
+      /* Leave the bus and the CPU to others while every SPI is busy */
+      if(ntodo && (nprogress == 0))
+	nanosleep(&backoff, NULL);
+    }
+
+  pthread_mutex_lock(&c1725DacLoad.mutex);
+  for(id = 0; id <= MAX_VME_SLOTS; id++)
+    {
+      c1725DacLoad.failed[id] |= c1725DacLoad.pending[id] | c1725DacLoad.written[id];
+      c1725DacLoad.pending[id] = 0;
+      c1725DacLoad.written[id] = 0;
+    }
+  c1725DacLoad.running = 0;
+  pthread_cond_broadcast(&c1725DacLoad.cond);
+  pthread_mutex_unlock(&c1725DacLoad.mutex);
+
+  return NULL;
+}
+
 /**
- * @brief General Data readout routine
+ * @brief Queue DC offsets for the specified channels, to be written by c1725DACLoadStart.
+ *        The write mode (c1725SetWriteMode) applies now: channels that already hold
+ *        their offset are not queued, and a dry run lists the writes without queueing.
  * @param[in] id caen1725 slot ID
- * @param[out] data local memory address to place data
- * @param[in] nwrds Max number of words to transfer
- * @param[in] rflag Readout Flag
- *              0 - programmed I/O from the specified board
- *              1 - DMA transfer using Universe/Tempe DMA Engine
- *                    (DMA VME transfer Mode must be setup prior)
- * @return If successful, number of 4byte words added to data.  Otherwise ERROR.
+ * @param[in] chanmask Mask of channels to load
+ * @param[in] offset Array of C1725_MAX_ADC_CHANNELS offsets, indexed by channel
+ * @return OK if successful, ERROR otherwise.
  */
 int32_t
-c1725ReadEvent(int32_t id, volatile uint32_t *data, int32_t nwrds, int32_t rflag)
+c1725DACLoadQueue(int32_t id, uint32_t chanmask, uint32_t *offset)
 {
-  int32_t dCnt=0;
-  uint32_t tmpData=0, evLen=0;
+  int32_t ichan, rval = OK;
   CHECKID(id);
-  if(data==NULL)
+
+  if(chanmask > 0xFFFF)
     {
-      logMsg("c1725ReadEvent: ERROR: Invalid Destination address\n",0,0,0,0,0,0);
+      fprintf(stderr, "%s: ERROR: Invalid chanmask (0x%x)\n",
+	      __func__, chanmask);
       return ERROR;
     }
 
-  C1725LOCK;
-  if(rflag==0)
-    { /* Programmed I/O */
-      /* First word should be the header */
-      tmpData = vmeRead32(&c1725p[id]->readout_buffer[0]);
-      if( (tmpData & C1725_HEADER_TYPE_MASK) != 0xA0000000)
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      if((chanmask & (1 << ichan)) && (offset[ichan] > C1725_DC_OFFSET_MASK))
 	{
-	  logMsg("c1725ReadEvent: ERROR: Invalid Header Word (0x%08x) for id = %d\n",
-		 tmpData,id,3,4,5,6);
-	  C1725UNLOCK;
+	  fprintf(stderr, "%s: ERROR: Invalid offset (0x%x) for channel %d\n",
+		  __func__, offset[ichan], ichan);
 	  return ERROR;
 	}
+    }
 
-      evLen = tmpData & C1725_HEADER_EVENTSIZE_MASK;
-#ifdef VXWORKS
-      data[dCnt++] = tmpData;
-#else
-      data[dCnt++] = LSWAP(tmpData);
-#endif
-      while(dCnt<evLen)
+  pthread_mutex_lock(&c1725DacLoad.mutex);
+  if(c1725DacLoad.running)
+    {
+      fprintf(stderr, "%s: ERROR: DAC load in progress\n", __func__);
+      rval = ERROR;
+    }
+  else
+    {
+      C1725LOCK(id);
+      for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
 	{
-	  /* Do not byteswap here (Linux), to make it consistent with DMA */
-	  data[dCnt] = c1725p[id]->readout_buffer[0];
-	  dCnt++;
-	  if(dCnt>=nwrds)
-	    {
-	      logMsg("c1725ReadEvent: WARN: Transfer limit reached.  nwrds = %d, evLen = %d, dCnt = %d\n",
-		     nwrds, evLen, dCnt,4,5,6);
-	      C1725UNLOCK;
-	      return dCnt;
-	    }
+	  if((chanmask & (1 << ichan)) == 0)
+	    continue;
+
+	  c1725DacLoad.failed[id] &= ~(1 << ichan);
+	  if(c1725WriteFilter(id, C1725_CHAN_OFFSET(ichan, offsetof(c1725_chan, dc_offset)),
+			      offset[ichan]))
+	    continue;
+
+	  c1725DacLoad.offset[id][ichan] = offset[ichan];
+	  c1725DacLoad.pending[id] |= (1 << ichan);
 	}
+      C1725UNLOCK(id);
+    }
+  pthread_mutex_unlock(&c1725DacLoad.mutex);
 
-      C1725UNLOCK;
-      return dCnt;
-    } /* rflag == 0 */
-  else if(rflag ==1)
+  return rval;
+}
+
+/**
+ * @brief Start writing the queued DC offsets in the background.  Channels are
+ *        written as soon as their SPI is idle, boards interleaved.
+ * @param[in] timeout_us Time allowed for all channels to load, in microseconds
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725DACLoadStart(uint32_t timeout_us)
+{
+  int32_t rval = OK;
+
+  pthread_mutex_lock(&c1725DacLoad.mutex);
+  if(c1725DacLoad.running)
+    {
+      fprintf(stderr, "%s: ERROR: DAC load in progress\n", __func__);
+      rval = ERROR;
+    }
+  else
     {
-      int32_t dummy = 0, retVal = 0, xferCount = 0;
-      volatile uint32_t *laddr;
-      uint32_t readout_status = 0, berr = 0;
-      unsigned long vmeAdr;
-      int32_t nwrds_leftover=0;
-      int32_t dmas=0;
-      /* Check for 8 byte boundary for address - insert dummy word */
-      if((unsigned long) (data)&0x7)
+      c1725DacLoad.timeout_us = timeout_us;
+      c1725DacLoad.running = 1;
+      if(pthread_create(&c1725DacLoad.thread, NULL, c1725DACLoadThread, NULL) != 0)
 	{
-	  *data = LSWAP(0xcebaf111);
-	  dummy = 1;
-	  laddr = (data + 1);
-	  xferCount = 1;
+	  perror("pthread_create");
+	  c1725DacLoad.running = 0;
+	  rval = ERROR;
 	}
       else
-	{
-	  dummy = 0;
-	  laddr = data;
-	  xferCount = 0;
-	}
+	pthread_detach(c1725DacLoad.thread);
+    }
+  pthread_mutex_unlock(&c1725DacLoad.mutex);
+
+  return rval;
+}
 
-      vmeAdr = (unsigned long)(&c1725p[id]->readout_buffer[0]) - c1725AddrOffset;
+/**
+ * @brief Get the progress of the DC offset load of the specified module
+ * @param[in] id caen1725 slot ID
+ * @param[out] pending Mask of channels not yet loaded
+ * @param[out] failed Mask of channels whose SPI stayed busy past the timeout
+ * @return 1 if the load is in progress, 0 if not, ERROR on invalid id.
+ */
+int32_t
+c1725DACLoadStatus(int32_t id, uint32_t *pending, uint32_t *failed)
+{
+  int32_t rval;
+  CHECKID(id);
 
-    DMASTART: /* Here's our Start of the CBLT, in case it needs to be repeated */
+  pthread_mutex_lock(&c1725DacLoad.mutex);
+  *pending = c1725DacLoad.pending[id] | c1725DacLoad.written[id];
+  *failed = c1725DacLoad.failed[id];
+  rval = c1725DacLoad.running;
+  pthread_mutex_unlock(&c1725DacLoad.mutex);
 
-      dmas++;
+  return rval;
+}
 
-      if(nwrds > (0x1000 >> 2))
-	{ /* Limit the DMA Transfer to less than the readout space */
-	  nwrds_leftover = nwrds - (0x1000 >> 2);
-	  nwrds = (0x1000 >> 2);
-#define DEBUGDMA
-#ifdef DEBUGDMA
-	  printf("%s: May need retries.  nwrds = %d  nwrds_leftover = %d\n",
-		 __FUNCTION__,
-		 nwrds, nwrds_leftover);
-#endif
-	}
-#ifdef DEBUGDMA
-      printf("%s: DMAs = %d\n",__FUNCTION__,dmas);
-      printf("    laddr = 0x%lx   vmeAdr = 0x%08lx  nwrds<<2 = %d\n",
-	     (unsigned long) laddr, vmeAdr, nwrds<<2);
-#endif
+/**
+ * @brief Wait for the DC offset load started by c1725DACLoadStart to finish
+ * @param[in] timeout_us Longest wait, in microseconds
+ * @return OK if every channel loaded, ERROR on timeout or failed channels.
+ */
+int32_t
+c1725DACLoadWait(uint32_t timeout_us)
+{
+  struct timespec deadline;
+  int32_t id, stat = 0, rval = OK;
+
+  c1725Deadline(&deadline, timeout_us);
 
-      retVal = vmeDmaSend((unsigned long)laddr, vmeAdr, (nwrds<<2));
+  pthread_mutex_lock(&c1725DacLoad.mutex);
+  while(c1725DacLoad.running && (stat != ETIMEDOUT))
+    stat = pthread_cond_timedwait(&c1725DacLoad.cond, &c1725DacLoad.mutex, &deadline);
+
+  if(c1725DacLoad.running)
+    {
+      fprintf(stderr, "%s: ERROR: Timeout waiting for DAC load\n", __func__);
+      rval = ERROR;
+    }
 
-      if(retVal != 0)
+  for(id = 0; id <= MAX_VME_SLOTS; id++)
+    {
+      if(c1725DacLoad.failed[id])
 	{
-	  fprintf(stderr, "%s: ERROR in DMA transfer Initialization 0x%x\n",
-		  __func__, retVal);
-	  C1725UNLOCK;
-	  return(retVal);
+	  fprintf(stderr, "%s: ERROR: Slot %d: Timeout in setting the DAC of channels 0x%04x\n",
+		  __func__, id, c1725DacLoad.failed[id]);
+	  rval = ERROR;
 	}
+    }
+  pthread_mutex_unlock(&c1725DacLoad.mutex);
 
-      /* Wait until Done or Error */
-      retVal = vmeDmaDone();
+  return rval;
+}
 
-      /* Check for BERR from last module */
-      readout_status = vmeRead32(&c1725p[id]->readout_status);
-      berr = (readout_status & C1725_READOUT_STATUS_BERR_OCCURRED) ? 1 : 0;
+/* Channel registers written by c1725SetChannelBlock, in the order they are written */
+static const struct
+{
+  uint32_t chan_off;		/* offset in c1725_chan */
+  uint32_t all_off;		/* offset of the all channel register */
+  uint32_t mask;
+  const char *name;
+} c1725ChanBlockReg[C1725_CHANBLOCK_NREG] =
+  {
+    { offsetof(c1725_chan, minimum_record_length),
+      offsetof(c1725_address, all_minimum_record_length),
+      C1725_RECORD_LENGTH_MASK, "record_length" },
+    { offsetof(c1725_chan, input_dynamic_range),
+      offsetof(c1725_address, all_input_dynamic_range),
+      C1725_DYNAMIC_RANGE_MASK, "dynamic_range" },
+    { offsetof(c1725_chan, input_delay),
+      offsetof(c1725_address, all_input_delay),
+      C1725_INPUT_DELAY_MASK, "input_delay" },
+    { offsetof(c1725_chan, pre_trigger),
+      offsetof(c1725_address, all_pre_trigger),
+      C1725_PRE_TRIGGER_MASK, "pre_trigger" },
+    { offsetof(c1725_chan, trigger_threshold),
+      offsetof(c1725_address, all_trigger_threshold),
+      C1725_TRIGGER_THRESHOLD_MASK, "trigger_threshold" },
+    { offsetof(c1725_chan, fixed_baseline),
+      offsetof(c1725_address, all_fixed_baseline),
+      C1725_FIXED_BASELINE_MASK, "fixed_baseline" },
+    { offsetof(c1725_chan, samples_under_threshold),
+      offsetof(c1725_address, all_samples_under_threshold),
+      C1725_UNDER_THRESHOLD_MASK, "samples_under_threshold" },
+    { offsetof(c1725_chan, maximum_tail),
+      offsetof(c1725_address, all_maximum_tail),
+      C1725_MAX_TAIL_MASK, "maximum_tail" },
+    { offsetof(c1725_chan, dpp_algorithm_ctrl),
+      offsetof(c1725_address, all_dpp_algorithm_ctrl),
+      C1725_DPP_CTRL_MASK, "dpp_algorithm_ctrl" },
+    { offsetof(c1725_chan, dc_offset),
+      offsetof(c1725_address, all_dc_offset),
+      C1725_DC_OFFSET_MASK, "dc_offset" },
+  };
+
+/* Wait for the DAC of the channels in chanmask to be ready.  Slot lock held */
+static int32_t
+c1725ChanBlockDACWait(int32_t id, uint32_t chanmask)
+{
+  int32_t ichan, iwait, maxwait = 1000;
 
-#ifdef DEBUGDMA
-      printf("%s: retVal = %d\n",
-	     __func__, retVal);
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      if((chanmask & (1 << ichan)) == 0)
+	continue;
 
-      printf("%s: %d.readout_status  0x%08x   berr  %d\n",
-	     __func__, id, readout_status, berr);
-#endif
-      if (retVal == 0)
+      for(iwait = 0; iwait < maxwait; iwait++)
+	if((c1725ReadReg(id, &c1725p[id]->chan[ichan].status) & C1725_CHANNEL_STATUS_SPI_BUSY) == 0)
+	  break;
+
+      if(iwait >= maxwait)
 	{
-	  if((xferCount - dummy) == 0)
-	    fprintf(stderr, "%s: WARN: DMA transfer returned zero word count 0x%x berr = %d\n",
-		    __func__, nwrds, berr);
-	  C1725UNLOCK;
-	  return(xferCount);
-	}
-      else if(retVal < 0)
-	{  /* Error in DMA */
-	  fprintf(stderr, "%s: ERROR: vmeDmaDone returned an Error\n", __func__);
-	  C1725UNLOCK;
-	  return(retVal);
+	  fprintf(stderr, "%s(%d, %d): ERROR: Timeout in setting the DAC\n",
+		  __func__, id, ichan);
+	  return ERROR;
 	}
+    }
 
-      if(berr)
+  return OK;
+}
+
+/* Write one register of the channels in chanmask, using the all channel
+   register for the most common value when that saves writes.  Slot lock held */
+static int32_t
+c1725ChanBlockWrite(int32_t id, int32_t ireg, uint32_t chanmask, uint32_t *val)
+{
+  uint32_t chan_off = c1725ChanBlockReg[ireg].chan_off, bval = 0, nbest = 0, n, wmask = 0;
+  int32_t ichan, jchan, isdac = (chan_off == offsetof(c1725_chan, dc_offset));
+  volatile uint32_t *reg;
+
+  /* Skip channels that already hold their value, as c1725WriteReg does */
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    if((chanmask & (1 << ichan)) &&
+       !c1725WriteSkip(id, C1725_CHAN_OFFSET(ichan, chan_off), val[ichan]))
+      wmask |= (1 << ichan);
+
+  if(wmask == 0)
+    return OK;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      if((wmask & (1 << ichan)) == 0)
+	continue;
+
+      for(jchan = ichan, n = 0; jchan < C1725_MAX_ADC_CHANNELS; jchan++)
+	if((wmask & (1 << jchan)) && (val[jchan] == val[ichan]))
+	  n++;
+      if(n > nbest)
 	{
-	  xferCount += (retVal >> 2);  /* Number of 4byte words transfered */
-	  C1725UNLOCK;
-#ifdef DEBUGDMA
-	  printf("%s: Done. xferCount = %d  nwrds = %d  nwrds_leftover = %d\n",
-		 __FUNCTION__,
-		 xferCount, nwrds, nwrds_leftover);
-#endif
-	  return(xferCount); /* Return number of data words transfered */
+	  nbest = n;
+	  bval = val[ichan];
 	}
-      else
+    }
+
+  /* The all channel write must leave the other channels as they are */
+  if(nbest >= 2)
+    {
+      for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	if(((wmask & (1 << ichan)) == 0) &&
+	   !c1725ShadowHolds(id, C1725_CHAN_OFFSET(ichan, chan_off), bval))
+	  break;
+
+      if(ichan == C1725_MAX_ADC_CHANNELS)
 	{
-	  if(nwrds_leftover > 0)
-	    { /* Do it again to get the data left in the modules */
-	      xferCount += nwrds;
-	      laddr += nwrds;
-	      nwrds = nwrds_leftover;
-#ifdef DEBUGDMA
-	      printf("%s: Retry... nwrds = %d  nwrds_leftover = %d\n",
-		     __FUNCTION__,
-		     nwrds, nwrds_leftover);
-#endif
-	      nwrds_leftover = 0;
-	      goto DMASTART;
-	    }
-	  xferCount += (retVal>>2);  /* Number of Longwords transfered */
-	  fprintf(stderr,
-		  "%s: DMA transfer terminated by unknown BUS Error (readout_status=0x%x xferCount=%d)\n",
-		  __func__, readout_status, xferCount);
-	  C1725UNLOCK;
-	  return(xferCount);
+	  if(isdac && (c1725ChanBlockDACWait(id, 0xFFFF) != OK))
+	    return ERROR;
+
+	  reg = (volatile uint32_t *) ((uintptr_t) c1725p[id] + c1725ChanBlockReg[ireg].all_off);
+	  c1725WriteReg(id, reg, bval);
+
+	  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	    if((wmask & (1 << ichan)) && (val[ichan] == bval))
+	      wmask &= ~(1 << ichan);
 	}
+    }
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      if((wmask & (1 << ichan)) == 0)
+	continue;
 
+      if(isdac && (c1725ChanBlockDACWait(id, 1 << ichan) != OK))
+	return ERROR;
+
+      reg = (volatile uint32_t *) ((uintptr_t) &c1725p[id]->chan[ichan] + chan_off);
+      c1725WriteReg(id, reg, val[ichan]);
     }
-  else /* rflag == ? */
+
+  return OK;
+}
+
+/* Register values of the channels in chanmask from cfg, and the mask of channels
+   to write for each register of c1725ChanBlockReg */
+static int32_t
+c1725ChanBlockValues(uint32_t chanmask, c1725ChannelConfig_t *cfg,
+		     uint32_t val[C1725_CHANBLOCK_NREG][C1725_MAX_ADC_CHANNELS],
+		     uint32_t wmask[C1725_CHANBLOCK_NREG])
+{
+  int32_t ichan, ireg;
+
+  if((chanmask == 0) || (chanmask > 0xFFFF))
     {
-      fprintf(stderr,"%s: ERROR: Unsupported readout flag (%d)\n",
-	      __func__, rflag);
-      C1725UNLOCK;
+      fprintf(stderr, "%s: ERROR: Invalid chanmask (0x%x)\n",
+	      __func__, chanmask);
+      return ERROR;
+    }
+
+  if(cfg == NULL)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid cfg (NULL)\n", __func__);
       return ERROR;
     }
 
+  for(ireg = 0; ireg < C1725_CHANBLOCK_NREG; ireg++)
+    wmask[ireg] = chanmask;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    {
+      c1725ChannelConfig_t *c = &cfg[ichan];
+
+      if((chanmask & (1 << ichan)) == 0)
+	continue;
+
+      if(c->test_pulse_rate > 0x3)
+	{
+	  fprintf(stderr, "%s: ERROR: Invalid test_pulse_rate (0x%x) for channel %d\n",
+		  __func__, c->test_pulse_rate, ichan);
+	  return ERROR;
+	}
+
+      /* Same order as c1725ChanBlockReg */
+      ireg = 0;
+      val[ireg++][ichan] = c->record_length;
+      val[ireg++][ichan] = c->dynamic_range;
+      val[ireg++][ichan] = c->input_delay;
+      val[ireg++][ichan] = c->pre_trigger;
+      val[ireg++][ichan] = c->trigger_threshold;
+      if(!c->fixed_baseline_enable)
+	wmask[ireg] &= ~(1 << ichan);
+      val[ireg++][ichan] = c->fixed_baseline;
+      val[ireg++][ichan] = c->samples_under_threshold;
+      val[ireg++][ichan] = c->maximum_tail;
+      val[ireg++][ichan] =
+	(c->test_pulse_enable ? C1725_DPP_TEST_PULSE_ENABLE : 0) |
+	(c->test_pulse_rate << 9) |
+	(c->test_pulse_polarity ? C1725_DPP_TEST_PULSE_NEGATIVE : 0) |
+	(c->self_trigger_enable ? 0 : C1725_DPP_SELF_TRIGGER_DISABLE);
+      if(c->dc_offset_queued)
+	wmask[ireg] &= ~(1 << ichan);
+      val[ireg++][ichan] = c->dc_offset;
+
+      for(ireg = 0; ireg < C1725_CHANBLOCK_NREG; ireg++)
+	{
+	  if((wmask[ireg] & (1 << ichan)) && (val[ireg][ichan] & ~c1725ChanBlockReg[ireg].mask))
+	    {
+	      fprintf(stderr, "%s: ERROR: Invalid %s (0x%x) for channel %d\n",
+		      __func__, c1725ChanBlockReg[ireg].name, val[ireg][ichan], ichan);
+	      return ERROR;
+	    }
+	}
+    }
+
   return OK;
 }
 
 /**
- * @brief General Data readout routine
+ * @brief Program the channel registers of the specified channels in one locked pass.
+ *     Values shared by several channels are written with the all channel registers,
+ *     and registers the shadow shows already hold their value are not written.
  * @param[in] id caen1725 slot ID
- * @param[out] data local memory address to place data
- * @param[in] nwrds Max number of words to transfer
- * @param[in] rflag Readout Flag
- *              0 - programmed I/O from the specified board
- *              1 - DMA transfer using Universe/Tempe DMA Engine
- *                    (DMA VME transfer Mode must be setup prior)
- * @return If successful, number of 4byte words added to data.  Otherwise ERROR.
+ * @param[in] chanmask Mask of channels to program
+ * @param[in] cfg Array of C1725_MAX_ADC_CHANNELS channel settings, indexed by channel
+ * @return OK if successful, ERROR otherwise.
  */
+int32_t
+c1725SetChannelBlock(int32_t id, uint32_t chanmask, c1725ChannelConfig_t *cfg)
+{
+  uint32_t val[C1725_CHANBLOCK_NREG][C1725_MAX_ADC_CHANNELS];
+  uint32_t wmask[C1725_CHANBLOCK_NREG];
+  int32_t ireg, rval = OK;
+  CHECKID(id);
+
+  if(c1725ChanBlockValues(chanmask, cfg, val, wmask) != OK)
+    return ERROR;
+
+  C1725LOCK(id);
+  for(ireg = 0; ireg < C1725_CHANBLOCK_NREG; ireg++)
+    {
+      if(wmask[ireg] == 0)
+	continue;
+
+      rval = c1725ChanBlockWrite(id, ireg, wmask[ireg], val[ireg]);
+      if(rval != OK)
+	break;
+    }
+  C1725UNLOCK(id);
+
+  return rval;
+}
 
+/**
+ * @brief Update the settings that are safe to change during acquisition (trigger
+ *     threshold, fixed baseline and DC offset) of the specified channels of an armed
+ *     module.  Holds the DMA lock, so the update falls between readouts (and is
+ *     refused during one started by this thread), but waits for the DACs before
+ *     taking it.  Other settings in cfg are ignored.
+ * @param[in] id caen1725 slot ID
+ * @param[in] chanmask Mask of channels to update
+ * @param[in] cfg Array of C1725_MAX_ADC_CHANNELS channel settings, indexed by channel
+ * @return OK if successful, ERROR otherwise.
+ */
 int32_t
-c1725CBLTReadBlock(volatile uint32_t *data, uint32_t nwrds, int32_t rflag)
+c1725UpdateChannelBlock(int32_t id, uint32_t chanmask, c1725ChannelConfig_t *cfg)
 {
-  int32_t stat, retVal, xferCount;
-  int32_t dummy = 0;
-  volatile uint32_t *laddr;
-  uint32_t readout_status = 0, berr = 0;
-  unsigned long vmeAdr;
-  int32_t nwrds_leftover=0;
-  int32_t dmas=0;
+  uint32_t val[C1725_CHANBLOCK_NREG][C1725_MAX_ADC_CHANNELS];
+  uint32_t wmask[C1725_CHANBLOCK_NREG];
+  int32_t ireg, idac = 0, ichan, rval = OK;
+  CHECKID(id);
 
-  if(c1725MCSTp == NULL)
+  CHECKREADSTARTED;
+
+  if(c1725ChanBlockValues(chanmask, cfg, val, wmask) != OK)
+    return ERROR;
+
+  for(ireg = 0; ireg < C1725_CHANBLOCK_NREG; ireg++)
+    if(c1725ChanBlockReg[ireg].chan_off == offsetof(c1725_chan, dc_offset))
+      idac = ireg;
+
+  /* The readout is not held up while the SPI of a channel is busy */
+  if(wmask[idac])
     {
-      fprintf(stderr, "%s: ERROR: MCST/CBLT Address not initialized!\n",
-	     __func__);
-      return ERROR;
+      C1725LOCK(id);
+      rval = c1725ChanBlockDACWait(id, wmask[idac]);
+      C1725UNLOCK(id);
+      if(rval != OK)
+	return ERROR;
     }
 
-  C1725LOCK;
-  /*Assume that the DMA programming is already setup. */
-  /* Don't Bother checking if there is valid data - that should be done prior
-     to calling the read routine */
+  C1725DMALOCK;
+  C1725LOCK(id);
+  for(ireg = 0; ireg < C1725_CHANBLOCK_NREG; ireg++)
+    {
+      uint32_t chan_off = c1725ChanBlockReg[ireg].chan_off;
 
-  /* Check for 8 byte boundary for address - insert dummy word */
-  if((unsigned long) (data)&0x7)
+      if((wmask[ireg] == 0) ||
+	 ((chan_off != offsetof(c1725_chan, trigger_threshold)) &&
+	  (chan_off != offsetof(c1725_chan, fixed_baseline)) &&
+	  (chan_off != offsetof(c1725_chan, dc_offset))))
+	continue;
+
+      /* One channel at a time: the all channel register would make every SPI
+	 busy, and leave the next write to wait for it */
+      if(ireg == idac)
+	{
+	  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	    if(wmask[idac] & (1 << ichan))
+	      c1725WriteReg(id, &c1725p[id]->chan[ichan].dc_offset, val[idac][ichan]);
+	  continue;
+	}
+
+      rval = c1725ChanBlockWrite(id, ireg, wmask[ireg], val[ireg]);
+      if(rval != OK)
+	break;
+    }
+  C1725UNLOCK(id);
+  C1725DMAUNLOCK;
+
+  return rval;
+}
+
+/**
+ * @brief List the channel registers c1725SetChannelBlock programs from cfg, with the
+ *     values they should hold, for c1725Readback
+ * @param[in] chanmask Mask of channels
+ * @param[in] cfg Array of C1725_MAX_ADC_CHANNELS channel settings, indexed by channel
+ * @param[out] regs Registers to read back, at most C1725_CHANBLOCK_NREG per channel
+ * @param[in] nmax Size of regs
+ * @return Number of registers in regs if successful, ERROR otherwise.
+ */
+int32_t
+c1725ChannelBlockReadback(uint32_t chanmask, c1725ChannelConfig_t *cfg,
+			  c1725Readback_t *regs, int32_t nmax)
+{
+  uint32_t val[C1725_CHANBLOCK_NREG][C1725_MAX_ADC_CHANNELS];
+  uint32_t wmask[C1725_CHANBLOCK_NREG];
+  int32_t ichan, ireg, nregs = 0;
+
+  if(regs == NULL)
     {
-      *data = LSWAP(0xcebaf111);
-      dummy = 1;
-      laddr = (data + 1);
-      xferCount = 1;
+      fprintf(stderr, "%s: ERROR: Invalid regs (NULL)\n", __func__);
+      return ERROR;
     }
-  else
+
+  if(c1725ChanBlockValues(chanmask, cfg, val, wmask) != OK)
+    return ERROR;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
     {
-      dummy = 0;
-      laddr = data;
-      xferCount = 0;
+      for(ireg = 0; ireg < C1725_CHANBLOCK_NREG; ireg++)
+	{
+	  if((wmask[ireg] & (1 << ichan)) == 0)
+	    continue;
+
+	  if(nregs >= nmax)
+	    {
+	      fprintf(stderr, "%s: ERROR: More than %d registers\n", __func__, nmax);
+	      return ERROR;
+	    }
+
+	  regs[nregs].offset = offsetof(c1725_address, chan[ichan]) +
+	    c1725ChanBlockReg[ireg].chan_off;
+	  regs[nregs].mask = c1725ChanBlockReg[ireg].mask;
+	  regs[nregs].expected = val[ireg][ichan];
+	  regs[nregs].readback = 0;
+	  regs[nregs].name = c1725ChanBlockReg[ireg].name;
+	  nregs++;
+	}
     }
 
+  return nregs;
+}
+
+/* Whether every board in the CBLT chain has the extended block transfer space */
+static int32_t
+c1725CBLTExtBlkSpace()
+{
+  int32_t ic;
 
-  vmeAdr = (unsigned long)(c1725MCSTp) - c1725MCSTOffset;
+  for(ic = 0; ic < Nc1725; ic++)
+    if(!c1725ExtBlkSpace[c1725ID[ic]])
+      return 0;
 
- DMASTART: /* Here's our Start of the CBLT, in case it needs to be repeated */
+  return 1;
+}
 
-  dmas++;
+/* Send the next DMA of the readout in c1725Dma. Limited to the readout space */
+static int32_t
+c1725DmaSend()
+{
+  int32_t retVal;
 
-  if(nwrds > (0x1000 >> 2))
+  if(c1725Dma.nwrds > c1725Dma.maxchunk)
     { /* Limit the DMA Transfer to less than the readout space */
-      nwrds_leftover = nwrds - (0x1000 >> 2);
-      nwrds = (0x1000 >> 2);
-#ifdef DEBUGCBLT
+      c1725Dma.nwrds_leftover = c1725Dma.nwrds - c1725Dma.maxchunk;
+      c1725Dma.nwrds = c1725Dma.maxchunk;
+#ifdef DEBUGDMA
       printf("%s: May need retries.  nwrds = %d  nwrds_leftover = %d\n",
-	     __FUNCTION__,
-	     nwrds, nwrds_leftover);
+	     __func__, c1725Dma.nwrds, c1725Dma.nwrds_leftover);
 #endif
     }
-#ifdef DEBUGCBLT
-  printf("%s: DMAs = %d\n",__FUNCTION__,dmas);
-  printf("    laddr = 0x%08x   vmeAdr = 0x%08x  nwrds<<2 = %d\n",
-	 laddr, vmeAdr, nwrds<<2);
+#ifdef DEBUGDMA
+  printf("    laddr = 0x%lx   vmeAdr = 0x%08lx  nwrds<<2 = %d\n",
+	 (unsigned long) c1725Dma.laddr, c1725Dma.vmeAdr, c1725Dma.nwrds<<2);
 #endif
 
-  retVal = vmeDmaSend((unsigned long)laddr, vmeAdr, (nwrds<<2));
+  c1725DMATransfers++;
+  c1725Dma.dmas++;
+  C1725COUNT(c1725Dma.id, dma_calls, 1);
+  retVal = vmeDmaSend((unsigned long)c1725Dma.laddr, c1725Dma.vmeAdr, (c1725Dma.nwrds<<2));
 
   if(retVal != 0)
     {
       fprintf(stderr, "%s: ERROR in DMA transfer Initialization 0x%x\n",
 	      __func__, retVal);
-      C1725UNLOCK;
-      return(retVal);
+      c1725Dma.active = 0;
     }
 
-  /* Wait until Done or Error */
-  retVal = vmeDmaDone();
-
-  /* Check for BERR from last module */
-  readout_status = vmeRead32(&c1725p[c1725Slot(Nc1725-1)]->readout_status);
-  berr = (readout_status & C1725_READOUT_STATUS_BERR_OCCURRED) ? 1 : 0;
-
-#ifdef DEBUGCBLT
-  printf("%s: retVal = %d\n",
-	 __func__, retVal);
-
-  printf("%s: %d.readout_status  0x%08x   berr  %d\n",
-	 __func__, c1725Slot(Nc1725-1), readout_status, berr);
-#endif
+  return retVal;
+}
 
-  if (retVal == 0)
+/**
+ * Start a DMA readout from vmeAdr, ending at a bus error from board id.
+ * ext: all boards read have the extended block transfer space enabled, so
+ * one DMA can cover the whole readout instead of 4 KB at a time.
+ * Caller holds the DMA lock and the lock of id, that c1725DmaFinish does not need.
+ */
+static int32_t
+c1725DmaStart(int32_t id, unsigned long vmeAdr, volatile uint32_t *data, int32_t nwrds,
+	      int32_t ext)
+{
+  if(c1725Dma.active)
     {
-      if((xferCount - dummy) == 0)
-	fprintf(stderr, "%s: WARN: DMA transfer returned zero word count 0x%x berr = %d\n",
-		__func__, nwrds, berr);
-      C1725UNLOCK;
-      return(xferCount);
-    }
-  else if(retVal < 0)
-    {  /* Error in DMA */
-      fprintf(stderr, "%s: ERROR: vmeDmaDone returned an Error\n", __func__);
-      C1725UNLOCK;
-      return(retVal);
+      fprintf(stderr, "%s: ERROR: Readout already in progress\n", __func__);
+      return ERROR;
     }
 
-  if(berr)
+  c1725Dma.id = id;
+  c1725Dma.vmeAdr = vmeAdr;
+  c1725Dma.nwrds = nwrds;
+  c1725Dma.nwrds_leftover = 0;
+  c1725Dma.maxchunk = ext ? (C1725_EXT_BLK_SPACE_NBYTES >> 2) : (C1725_BLK_SPACE_NBYTES >> 2);
+  c1725Dma.dmas = 0;
+  c1725Dma.data = data;
+
+  /* Check for 8 byte boundary for address - insert dummy word */
+  if((unsigned long) (data)&0x7)
     {
-      xferCount += (retVal >> 2);  /* Number of 4byte words transfered */
-      C1725UNLOCK;
-#ifdef DEBUGCBLT
-      printf("%s: Done. xferCount = %d  nwrds = %d  nwrds_leftover = %d\n",
-	     __FUNCTION__,
-	     xferCount, nwrds, nwrds_leftover);
-#endif
-      return(xferCount); /* Return number of data words transfered */
+      *data = LSWAP(0xcebaf111);
+      c1725Dma.dummy = 1;
+      c1725Dma.laddr = (data + 1);
+      c1725Dma.xferCount = 1;
     }
   else
     {
-      if(nwrds_leftover > 0)
-	{ /* Do it again to get the data left in the modules */
-	  xferCount += nwrds;
-	  laddr += nwrds;
-	  nwrds = nwrds_leftover;
-#ifdef DEBUGCBLT
-	  printf("%s: Retry... nwrds = %d  nwrds_leftover = %d\n",
-		 __FUNCTION__,
-		 nwrds, nwrds_leftover);
-#endif
-	  nwrds_leftover = 0;
-	  goto DMASTART;
-	}
-      xferCount += (retVal>>2);  /* Number of Longwords transfered */
-      fprintf(stderr,
-	      "%s: DMA transfer terminated by unknown BUS Error (readout_status=0x%x xferCount=%d)\n",
-	      __func__, readout_status, xferCount);
-      C1725UNLOCK;
-      return(xferCount);
+      c1725Dma.dummy = 0;
+      c1725Dma.laddr = data;
+      c1725Dma.xferCount = 0;
     }
 
-  C1725UNLOCK;
-  return(OK);
+  c1725Dma.active = 1;
+
+  return c1725DmaSend();
 }
 
 /**
- * @brief Return a Block Ready status mask for C1725s indicated in supplied slotmask
- * @param[in] scanmask Slotmask of C1725s to scan for block ready
- * @param[in] max_scans Number of times to iterate through scanmask
- * @param[in] blocklevel Number of events in a block
- * @return block ready mask
+ * Count the events and words of a readout, for the module that sent each
+ * event (from the board ID of its header), or id if it is not one of ours.
  */
-uint32_t
-c1725GBlockReady(uint32_t scanmask, uint32_t max_scans, uint32_t blocklevel)
+static void
+c1725CountEvents(int32_t id, volatile uint32_t *data, int32_t nwrds)
 {
-  int32_t iscan, ic, stat=0;
-  uint32_t rmask=0;
+  uint32_t word, evlen;
+  int32_t iword = 0, slot;
 
-  C1725LOCK;
-  for(iscan = 0; iscan < max_scans; iscan++)
+  while(iword < nwrds)
     {
-      for(ic = 2; ic < 21; ic++)
-	{
-	  if((ic < 0) || (ic >= MAX_VME_SLOTS) || (c1725p[ic] == NULL)) continue;
+#ifdef VXWORKS
+      word = data[iword];
+#else
+      word = LSWAP(data[iword]);
+#endif
+      if((word & C1725_HEADER_TYPE_MASK) != C1725_HEADER_TYPE_ID)
+	{ /* Filler */
+	  iword++;
+	  continue;
+	}
 
-	  if(scanmask & (1 << ic))
-	    { /* slot used */
+      evlen = word & C1725_HEADER_EVENTSIZE_MASK;
+      if(evlen == 0)
+	break;
 
-	      if(!(rmask & (1 << ic)))
-		{ /* No block ready yet. */
-		  stat = (vmeRead32(&c1725p[ic]->event_stored) == blocklevel);
+      slot = id;
+      if(iword + 1 < nwrds)
+	{
+#ifdef VXWORKS
+	  word = data[iword + 1];
+#else
+	  word = LSWAP(data[iword + 1]);
+#endif
+	  slot = (word & C1725_HEADER_BOARDID_MASK) >> 27;
+	  if((slot > MAX_VME_SLOTS) || (c1725p[slot] == NULL))
+	    slot = id;
+	}
 
-		  if(stat)
-		    rmask |= (1 << ic);
+      C1725COUNT(slot, events, 1);
+      C1725COUNT(slot, words, evlen);
+      iword += evlen;
+    }
+}
 
-		  if(rmask == scanmask)
-		    { /* Blockready mask matches user scanmask */
-		      C1725UNLOCK;
-		      return(rmask);
-		    }
+/**
+ * Wait for the readout started with c1725DmaStart, repeating the DMA until the
+ * board signals the end of data.  Return number of words, or an error.
+ * Caller holds the DMA lock.  The board is locked only to read its status.
+ */
+static int32_t
+c1725DmaFinish()
+{
+  int32_t retVal, nfixed;
+  uint32_t readout_status = 0, berr = 0;
+
+  while(1)
+    {
+      /* Wait until Done or Error */
+      retVal = vmeDmaDone();
+
+      /* Check for BERR from last module */
+      C1725LOCK(c1725Dma.id);
+      readout_status = vmeRead32(&c1725p[c1725Dma.id]->readout_status);
+      C1725UNLOCK(c1725Dma.id);
+      berr = (readout_status & C1725_READOUT_STATUS_BERR_OCCURRED) ? 1 : 0;
+
+#ifdef DEBUGDMA
+      printf("%s: retVal = %d\n", __func__, retVal);
+      printf("%s: %d.readout_status  0x%08x   berr  %d\n",
+	     __func__, c1725Dma.id, readout_status, berr);
+#endif
+
+      if(retVal == 0)
+	{
+	  if((c1725Dma.xferCount - c1725Dma.dummy) == 0)
+	    {
+	      C1725COUNT(c1725Dma.id, zero_words, 1);
+#ifdef DEBUGDMA
+	      printf("%s: DMA transfer returned zero word count 0x%x berr = %d\n",
+		     __func__, c1725Dma.nwrds, berr);
+#endif
+	    }
+	  break;
+	}
+      else if(retVal < 0)
+	{  /* Error in DMA */
+	  fprintf(stderr, "%s: ERROR: vmeDmaDone returned an Error\n", __func__);
+	  c1725Dma.active = 0;
+	  return retVal;
+	}
+
+      if(berr)
+	{
+	  C1725COUNT(c1725Dma.id, berr_terms, 1);
+	  c1725Dma.xferCount += (retVal >> 2);  /* Number of 4byte words transfered */
+#ifdef DEBUGDMA
+	  printf("%s: Done. xferCount = %d  nwrds = %d  nwrds_leftover = %d\n",
+		 __func__, c1725Dma.xferCount, c1725Dma.nwrds, c1725Dma.nwrds_leftover);
+#endif
+	  break;
+	}
+
+      if(c1725Dma.nwrds_leftover > 0)
+	{ /* Do it again to get the data left in the modules */
+	  c1725Dma.xferCount += c1725Dma.nwrds;
+	  c1725Dma.laddr += c1725Dma.nwrds;
+	  c1725Dma.nwrds = c1725Dma.nwrds_leftover;
+	  c1725Dma.nwrds_leftover = 0;
+#ifdef DEBUGDMA
+	  printf("%s: Retry... nwrds = %d\n", __func__, c1725Dma.nwrds);
+#endif
+	  c1725DMARetries++;
+	  C1725COUNT(c1725Dma.id, dma_retries, 1);
+	  retVal = c1725DmaSend();
+	  if(retVal != 0)
+	    return retVal;
+	  continue;
+	}
+
+      c1725Dma.xferCount += (retVal>>2);  /* Number of Longwords transfered */
+      fprintf(stderr,
+	      "%s: DMA transfer terminated by unknown BUS Error (readout_status=0x%x xferCount=%d)\n",
+	      __func__, readout_status, c1725Dma.xferCount);
+      break;
+    }
+
+  /* Fixed 4 KB transfers would have ended with a short one */
+  c1725DMAReadouts++;
+  nfixed = (c1725Dma.xferCount - c1725Dma.dummy) / (C1725_BLK_SPACE_NBYTES >> 2) + 1;
+  if(nfixed > c1725Dma.dmas)
+    c1725DMASaved += nfixed - c1725Dma.dmas;
+
+  c1725CountEvents(c1725Dma.id, c1725Dma.data, c1725Dma.xferCount);
+  c1725Dma.active = 0;
+
+  return c1725Dma.xferCount;
+}
+
+/**
+ * @brief General Data readout routine
+ * @param[in] id caen1725 slot ID
+ * @param[out] data local memory address to place data
+ * @param[in] nwrds Max number of words to transfer
+ * @param[in] rflag Readout Flag
+ *              0 - programmed I/O from the specified board
+ *              1 - DMA transfer using Universe/Tempe DMA Engine
+ *                    (DMA VME transfer Mode must be setup prior)
+ * @return If successful, number of 4byte words added to data.  Otherwise ERROR.
+ */
+int32_t
+c1725ReadEvent(int32_t id, volatile uint32_t *data, int32_t nwrds, int32_t rflag)
+{
+  int32_t dCnt=0;
+  uint32_t tmpData=0, evLen=0;
+  CHECKID(id);
+  if(data==NULL)
+    {
+      logMsg("c1725ReadEvent: ERROR: Invalid Destination address\n",0,0,0,0,0,0);
+      return ERROR;
+    }
+
+  if(rflag==0)
+    { /* Programmed I/O */
+      C1725LOCK(id);
+      /* First word should be the header */
+      tmpData = vmeRead32(&c1725p[id]->readout_buffer[0]);
+      if( (tmpData & C1725_HEADER_TYPE_MASK) != 0xA0000000)
+	{
+	  logMsg("c1725ReadEvent: ERROR: Invalid Header Word (0x%08x) for id = %d\n",
+		 tmpData,id,3,4,5,6);
+	  C1725UNLOCK(id);
+	  return ERROR;
+	}
+
+      evLen = tmpData & C1725_HEADER_EVENTSIZE_MASK;
+#ifdef VXWORKS
+      data[dCnt++] = tmpData;
+#else
+      data[dCnt++] = LSWAP(tmpData);
+#endif
+      while(dCnt<evLen)
+	{
+	  /* Do not byteswap here (Linux), to make it consistent with DMA */
+	  data[dCnt] = c1725p[id]->readout_buffer[0];
+	  dCnt++;
+	  if(dCnt>=nwrds)
+	    {
+	      logMsg("c1725ReadEvent: WARN: Transfer limit reached.  nwrds = %d, evLen = %d, dCnt = %d\n",
+		     nwrds, evLen, dCnt,4,5,6);
+	      C1725UNLOCK(id);
+	      C1725COUNT(id, events, 1);
+	      C1725COUNT(id, words, dCnt);
+	      return dCnt;
+	    }
+	}
+
+      C1725UNLOCK(id);
+      C1725COUNT(id, events, 1);
+      C1725COUNT(id, words, dCnt);
+      return dCnt;
+    } /* rflag == 0 */
+  else if(rflag ==1)
+    {
+      int32_t rval;
+
+      CHECKREADSTARTED;
+
+      C1725DMALOCKID(id);
+      C1725LOCK(id);
+      rval = c1725DmaStart(id, (unsigned long)(&c1725p[id]->readout_buffer[0]) - c1725AddrOffset,
+			   data, nwrds, c1725ExtBlkSpace[id]);
+      C1725UNLOCK(id);
+      if(rval == OK)
+	rval = c1725DmaFinish();
+      C1725DMAUNLOCK;
+
+      return rval;
+    }
+  else /* rflag == ? */
+    {
+      fprintf(stderr,"%s: ERROR: Unsupported readout flag (%d)\n",
+	      __func__, rflag);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/**
+ * @brief General Data readout routine
+ * @param[in] id caen1725 slot ID
+ * @param[out] data local memory address to place data
+ * @param[in] nwrds Max number of words to transfer
+ * @param[in] rflag Readout Flag
+ *              0 - programmed I/O from the specified board
+ *              1 - DMA transfer using Universe/Tempe DMA Engine
+ *                    (DMA VME transfer Mode must be setup prior)
+ * @return If successful, number of 4byte words added to data.  Otherwise ERROR.
+ */
+
+int32_t
+c1725CBLTReadBlock(volatile uint32_t *data, uint32_t nwrds, int32_t rflag)
+{
+  int32_t rval, lastid;
+
+  if(c1725MCSTp == NULL)
+    {
+      fprintf(stderr, "%s: ERROR: MCST/CBLT Address not initialized!\n",
+	     __func__);
+      return ERROR;
+    }
+  if(Nc1725 <= 0)
+    {
+      fprintf(stderr, "%s: ERROR: No modules initialized\n", __func__);
+      return ERROR;
+    }
+  CHECKREADSTARTED;
+
+  lastid = c1725ID[Nc1725-1];
+  C1725DMALOCKID(lastid);
+  C1725LOCK(lastid);
+  /*Assume that the DMA programming is already setup. */
+  /* Don't Bother checking if there is valid data - that should be done prior
+     to calling the read routine */
+  rval = c1725DmaStart(lastid, (unsigned long)(c1725MCSTp) - c1725MCSTOffset, data, nwrds,
+		       c1725CBLTExtBlkSpace());
+  C1725UNLOCK(lastid);
+  if(rval == OK)
+    rval = c1725DmaFinish();
+  C1725DMAUNLOCK;
+
+  return rval;
+}
+
+/**
+ * @brief Start a DMA readout from one board, and return without waiting for it.
+ *        Complete it with c1725ReadComplete, from the same thread.  The DMA engine
+ *        stays locked until then: from this thread, other DMA readouts, the c1725G*
+ *        multicast writes, c1725UpdateChannelBlock and the DMA stats are refused.
+ *        The module routines are not.
+ * @param[in] id caen1725 slot ID
+ * @param[out] data local memory address to place data
+ * @param[in] nwrds Max number of words to transfer
+ * @return OK if successful, otherwise ERROR or the vmeDmaSend status.
+ */
+int32_t
+c1725ReadEventStart(int32_t id, volatile uint32_t *data, int32_t nwrds)
+{
+  int32_t rval;
+  CHECKID(id);
+  if(data==NULL)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid Destination address\n", __func__);
+      return ERROR;
+    }
+  CHECKREADSTARTED;
+
+  C1725DMALOCKID(id);
+  C1725LOCK(id);
+  rval = c1725DmaStart(id, (unsigned long)(&c1725p[id]->readout_buffer[0]) - c1725AddrOffset,
+		       data, nwrds, c1725ExtBlkSpace[id]);
+  C1725UNLOCK(id);
+  if(rval != OK)
+    {
+      C1725DMAUNLOCK;
+      return rval;
+    }
+
+  c1725ReadOwner = pthread_self();
+  __atomic_store_n(&c1725ReadStarted, 1, __ATOMIC_RELEASE);
+
+  return rval;
+}
+
+/**
+ * @brief Start a CBLT readout of a block, and return without waiting for it.
+ *        Complete it with c1725ReadComplete, from the same thread.  The DMA engine
+ *        stays locked until then: from this thread, other DMA readouts, the c1725G*
+ *        multicast writes, c1725UpdateChannelBlock and the DMA stats are refused.
+ *        The module routines are not.
+ *
+ *        With two buffers, the next block can be transferred into one while the
+ *        previous is processed from the other:
+ *
+ *          c1725CBLTReadStart(bufB, n);
+ *          (format bufA)
+ *          nB = c1725ReadComplete();
+ *
+ * @param[out] data local memory address to place data
+ * @param[in] nwrds Max number of words to transfer
+ * @return OK if successful, otherwise ERROR or the vmeDmaSend status.
+ */
+int32_t
+c1725CBLTReadStart(volatile uint32_t *data, uint32_t nwrds)
+{
+  int32_t rval, lastid;
+
+  if(c1725MCSTp == NULL)
+    {
+      fprintf(stderr, "%s: ERROR: MCST/CBLT Address not initialized!\n",
+	     __func__);
+      return ERROR;
+    }
+  if(Nc1725 <= 0)
+    {
+      fprintf(stderr, "%s: ERROR: No modules initialized\n", __func__);
+      return ERROR;
+    }
+  CHECKREADSTARTED;
+
+  lastid = c1725ID[Nc1725-1];
+  C1725DMALOCKID(lastid);
+  C1725LOCK(lastid);
+  rval = c1725DmaStart(lastid, (unsigned long)(c1725MCSTp) - c1725MCSTOffset, data, nwrds,
+		       c1725CBLTExtBlkSpace());
+  C1725UNLOCK(lastid);
+  if(rval != OK)
+    {
+      C1725DMAUNLOCK;
+      return rval;
+    }
+
+  c1725ReadOwner = pthread_self();
+  __atomic_store_n(&c1725ReadStarted, 1, __ATOMIC_RELEASE);
+
+  return rval;
+}
+
+/**
+ * @brief Wait for the readout started by c1725ReadEventStart or c1725CBLTReadStart,
+ *        continue it if needed, and release the DMA lock.
+ * @return If successful, number of 4byte words added to data.  Otherwise ERROR.
+ */
+int32_t
+c1725ReadComplete()
+{
+  int32_t rval;
+
+  if(!c1725ReadStartedHere())
+    {
+      fprintf(stderr, "%s: ERROR: No readout started by this thread\n", __func__);
+      return ERROR;
+    }
+
+  /* The lock is released whether the readout succeeded or not */
+  rval = c1725DmaFinish();
+  __atomic_store_n(&c1725ReadStarted, 0, __ATOMIC_RELEASE);
+  C1725DMAUNLOCK;
+
+  return rval;
+}
+
+/**
+ * @brief Get the number of DMAs started by c1725ReadEvent and c1725CBLTReadBlock
+ * @param[out] transfers Number of DMAs started
+ * @param[out] retries Number of those that continued a readout past the 4 KB limit
+ * @return OK, or ERROR during a readout started by this thread
+ */
+int32_t
+c1725GetDMAStats(uint32_t *transfers, uint32_t *retries)
+{
+  CHECKREADSTARTED;
+
+  C1725DMALOCK;
+  *transfers = c1725DMATransfers;
+  *retries = c1725DMARetries;
+  C1725DMAUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Get the number of DMA readouts, and the DMAs saved by the extended block
+ *        transfer space compared to transfers of at most 4 KB
+ * @param[out] readouts Number of readouts done by DMA (or CBLT)
+ * @param[out] saved Number of DMAs not needed
+ * @return OK, or ERROR during a readout started by this thread
+ */
+int32_t
+c1725GetDMAChunkStats(uint32_t *readouts, uint32_t *saved)
+{
+  CHECKREADSTARTED;
+
+  C1725DMALOCK;
+  *readouts = c1725DMAReadouts;
+  *saved = c1725DMASaved;
+  C1725DMAUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Reset the DMA counters
+ * @return OK, or ERROR during a readout started by this thread
+ */
+int32_t
+c1725ResetDMAStats()
+{
+  CHECKREADSTARTED;
+
+  C1725DMALOCK;
+  c1725DMATransfers = 0;
+  c1725DMARetries = 0;
+  c1725DMAReadouts = 0;
+  c1725DMASaved = 0;
+  C1725DMAUNLOCK;
+
+  return OK;
+}
+
+/**
+ * @brief Get the readout counters of a module: events and words read, DMAs,
+ *        block ready scans, and time spent waiting for the module and DMA locks.
+ *        Counted since the last c1725ResetCounters (called at Prestart by the ROL).
+ * @param[in] id caen1725 slot ID
+ * @param[out] cnt Counters
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725CountersSnapshot(int32_t id, c1725Counters_t *cnt)
+{
+  uint64_t *src, *dst;
+  int32_t i;
+  CHECKID(id);
+
+  if(cnt == NULL)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid destination\n", __func__);
+      return ERROR;
+    }
+
+  /* Every field is a uint64_t counter */
+  src = (uint64_t *) &c1725Counters[id];
+  dst = (uint64_t *) cnt;
+  for(i = 0; i < sizeof(c1725Counters_t) / sizeof(uint64_t); i++)
+    dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+
+  return OK;
+}
+
+/**
+ * @brief Reset the readout counters of all modules
+ * @return OK
+ */
+int32_t
+c1725ResetCounters()
+{
+  uint64_t *cnt;
+  int32_t islot, i;
+
+  for(islot = 0; islot <= MAX_VME_SLOTS; islot++)
+    {
+      cnt = (uint64_t *) &c1725Counters[islot];
+      for(i = 0; i < sizeof(c1725Counters_t) / sizeof(uint64_t); i++)
+	__atomic_store_n(&cnt[i], 0, __ATOMIC_RELAXED);
+    }
+
+  return OK;
+}
+
+/**
+ * @brief Words in a block of events from one module, from the programmed channel
+ *        enable mask, record lengths, pre-triggers and maximum tails.
+ *        A record is at least the minimum record length, and a signal over
+ *        threshold can extend it by up to the pre-trigger and maximum tail.
+ * @param[in] id caen1725 slot ID
+ * @param[in] blocklevel Number of events in a block
+ * @param[out] maxwords Largest possible block, including the 64-bit alignment filler
+ * @param[out] expwords Block with every record at its minimum length
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GetBlockWords(int32_t id, uint32_t blocklevel, uint32_t *maxwords, uint32_t *expwords)
+{
+  uint32_t chanmask, reclen, pretrig, maxtail, maxev, expev;
+  int32_t chan;
+  CHECKID(id);
+
+  maxev = expev = C1725_HEADER_NWORDS;
+
+  C1725LOCK(id);
+  chanmask = c1725ReadReg(id, &c1725p[id]->channel_enable_mask) & C1725_ENABLE_CHANNEL_MASK;
+  for(chan = 0; chan < C1725_MAX_ADC_CHANNELS; chan++)
+    {
+      if(!(chanmask & (1 << chan)))
+	continue;
+
+      reclen = (c1725ReadReg(id, &c1725p[id]->chan[chan].minimum_record_length) &
+		C1725_RECORD_LENGTH_MASK) * C1725_RECORD_LENGTH_SAMPLES;
+      pretrig = (c1725ReadReg(id, &c1725p[id]->chan[chan].pre_trigger) &
+		 C1725_PRE_TRIGGER_MASK) * C1725_PRE_TRIGGER_SAMPLES;
+      maxtail = (c1725ReadReg(id, &c1725p[id]->chan[chan].maximum_tail) &
+		 C1725_MAX_TAIL_MASK) * C1725_MAX_TAIL_SAMPLES;
+
+      /* Two samples per word */
+      expev += C1725_CHANNEL_HEADER_NWORDS + (reclen + 1) / 2;
+      maxev += C1725_CHANNEL_HEADER_NWORDS + (reclen + pretrig + maxtail + 1) / 2;
+    }
+  C1725UNLOCK(id);
+
+  *maxwords = blocklevel * maxev + 1;
+  *expwords = blocklevel * expev;
+
+  return OK;
+}
+
+/**
+ * @brief Words in a block of events from all initialized modules, as read by
+ *        c1725CBLTReadBlock into a DMA buffer (see c1725GetBlockWords)
+ * @param[in] blocklevel Number of events in a block
+ * @param[out] maxwords Largest possible block, including DMA alignment words
+ * @param[out] expwords Block with every record at its minimum length
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725GBlockWords(uint32_t blocklevel, uint32_t *maxwords, uint32_t *expwords)
+{
+  uint32_t max, exp;
+  int32_t ic;
+
+  /* DMA destination alignment word */
+  *maxwords = 1;
+  *expwords = 0;
+
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      if(c1725GetBlockWords(c1725ID[ic], blocklevel, &max, &exp) != OK)
+	return ERROR;
+
+      *maxwords += max;
+      *expwords += exp;
+    }
+
+  return OK;
+}
+
+/**
+ * @brief Return a Block Ready status mask for C1725s indicated in supplied slotmask.
+ *        A module is ready when it holds at least blocklevel events.
+ * @param[in] scanmask Slotmask of C1725s to scan for block ready
+ * @param[in] max_scans Number of times to iterate through scanmask
+ * @param[in] blocklevel Number of events in a block
+ * @return block ready mask
+ */
+uint32_t
+c1725GBlockReady(uint32_t scanmask, uint32_t max_scans, uint32_t blocklevel)
+{
+  int32_t iscan, ic, id, stat=0;
+  uint32_t rmask=0;
+
+  for(iscan = 0; iscan < max_scans; iscan++)
+    {
+      for(ic = 0; ic < Nc1725; ic++)
+	{
+	  id = c1725ID[ic];
+
+	  if(scanmask & (1 << id))
+	    { /* slot used */
+
+	      if(!(rmask & (1 << id)))
+		{ /* No block ready yet. */
+		  C1725LOCK(id);
+		  stat = (vmeRead32(&c1725p[id]->event_stored) >= blocklevel);
+		  C1725UNLOCK(id);
+		  C1725COUNT(id, scan_polls, 1);
+
+		  if(stat)
+		    rmask |= (1 << id);
+
+		  if(rmask == scanmask)
+		    { /* Blockready mask matches user scanmask */
+		      return(rmask);
+		    }
 		}
 	    }
 	}
     }
-  C1725UNLOCK;
+
+  /* Modules not ready */
+  for(ic = 0; ic < Nc1725; ic++)
+    if(scanmask & ~rmask & (1 << c1725ID[ic]))
+      C1725COUNT(c1725ID[ic], scan_timeouts, 1);
 
   return(rmask);
 
 }
+
+/**
+ * @brief Return a Block Ready status mask for C1725s indicated in supplied slotmask.
+ *        Like c1725GBlockReady, but event_stored of the modules not yet ready is
+ *        read back to back, without taking the module locks, and the number of
+ *        scans and the time taken are returned to tune max_scans.
+ *        Each module is read with its own single cycle: a CBLT through the MCST
+ *        address only chains the readout buffers, not the status registers.
+ * @param[in] scanmask Slotmask of C1725s to scan for block ready
+ * @param[in] max_scans Number of times to iterate through scanmask
+ * @param[in] blocklevel Number of events in a block
+ * @param[out] nscans Number of scans done (may be NULL)
+ * @param[out] elapsed_ns Time spent scanning, in nanoseconds (may be NULL)
+ * @return block ready mask
+ */
+uint32_t
+c1725GBlockReadyScan(uint32_t scanmask, uint32_t max_scans, uint32_t blocklevel,
+		     uint32_t *nscans, uint64_t *elapsed_ns)
+{
+  volatile uint32_t *evstored[MAX_VME_SLOTS+1];
+  int32_t slot[MAX_VME_SLOTS+1];
+  int32_t iscan = 0, ic, nwait = 0;
+  uint32_t rmask = 0;
+  struct timespec t0, t1;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  /* Registers to read, in slot order */
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      if(scanmask & (1 << c1725ID[ic]))
+	{
+	  slot[nwait] = c1725ID[ic];
+	  evstored[nwait++] = &c1725p[c1725ID[ic]]->event_stored;
+	}
+    }
+
+  for(iscan = 0; (iscan < max_scans) && (nwait > 0); iscan++)
+    {
+      for(ic = 0; ic < nwait; ic++)
+	{
+	  C1725COUNT(slot[ic], scan_polls, 1);
+	  if(vmeRead32(evstored[ic]) >= blocklevel)
+	    {
+	      rmask |= (1 << slot[ic]);
+
+	      /* Drop it from the scan */
+	      nwait--;
+	      slot[ic] = slot[nwait];
+	      evstored[ic] = evstored[nwait];
+	      ic--;
+	    }
+	}
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  /* Modules not ready */
+  for(ic = 0; ic < nwait; ic++)
+    C1725COUNT(slot[ic], scan_timeouts, 1);
+
+  if(nscans)
+    *nscans = iscan;
+  if(elapsed_ns)
+    *elapsed_ns = (uint64_t) (t1.tv_sec - t0.tv_sec) * 1000000000 + (t1.tv_nsec - t0.tv_nsec);
+
+  return(rmask);
+}
+
+/**
+ * Interrupt service routine.  Counts the interrupt and wakes up
+ * c1725WaitBlockReady
+ */
+static void
+c1725Isr(int arg)
+{
+#ifdef VXWORKS
+  /* Interrupt level: the only writer of the count, and semGive does not block */
+  c1725IntCount++;
+  semGive(c1725IntSem);
+#else
+  pthread_mutex_lock(&c1725IntMutex);
+  c1725IntCount++;
+  pthread_cond_broadcast(&c1725IntCond);
+  pthread_mutex_unlock(&c1725IntMutex);
+#endif
+}
+
+/**
+ * @brief Enable interrupts from all initialized modules when they hold nevents
+ *        events, and connect the library interrupt service routine.
+ *        Interrupts are released on acknowledge (ROAK).
+ * @param[in] vector VME Interrupt vector (0: use default, 0xa8)
+ * @param[in] level VME Interrupt level (0: use default, 5)
+ * @param[in] nevents Number of stored events that raise the interrupt (e.g. the blocklevel)
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725IntConnect(uint32_t vector, uint32_t level, uint32_t nevents)
+{
+  int32_t ic, id;
+  uint32_t rreg;
+
+  if(Nc1725 <= 0)
+    {
+      fprintf(stderr, "%s: ERROR: No modules initialized\n", __func__);
+      return ERROR;
+    }
+
+  if(vector > C1725_INTERRUPT_ID_MASK)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid vector (0x%x)\n", __func__, vector);
+      return ERROR;
+    }
+
+  if(level > C1725_READOUT_CTRL_INTLEVEL_MASK)
+    {
+      fprintf(stderr, "%s: ERROR: Invalid level (%d)\n", __func__, level);
+      return ERROR;
+    }
+
+  if((nevents == 0) || (nevents > C1725_INTERRUPT_NUM_MASK))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid nevents (%d)\n", __func__, nevents);
+      return ERROR;
+    }
+
+  if(c1725IntRunning)
+    {
+      fprintf(stderr, "%s: ERROR: Interrupts already connected\n", __func__);
+      return ERROR;
+    }
+
+  if(vector)
+    c1725IntVector = vector;
+  if(level)
+    c1725IntLevel = level;
+
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      id = c1725ID[ic];
+
+      C1725LOCK(id);
+      rreg = c1725ReadReg(id, &c1725p[id]->readout_ctrl) & ~C1725_READOUT_CTRL_INTLEVEL_MASK;
+      c1725WriteReg(id, &c1725p[id]->interrupt_id, c1725IntVector);
+      c1725WriteReg(id, &c1725p[id]->interrupt_num, nevents);
+      c1725WriteReg(id, &c1725p[id]->readout_ctrl,
+		 rreg | c1725IntLevel | C1725_READOUT_CTRL_ROAK_ENABLE);
+      C1725UNLOCK(id);
+    }
+
+#ifdef VXWORKS
+  if((c1725IntSem == NULL) &&
+     ((c1725IntSem = semBCreate(SEM_Q_FIFO, SEM_EMPTY)) == NULL))
+    {
+      fprintf(stderr, "%s: ERROR: semBCreate failed\n", __func__);
+      return ERROR;
+    }
+  c1725IntCount = 0;
+#else
+  pthread_mutex_lock(&c1725IntMutex);
+  c1725IntCount = 0;
+  pthread_mutex_unlock(&c1725IntMutex);
+#endif
+
+  if(vmeIntConnect(c1725IntVector, c1725IntLevel, c1725Isr, 0) != OK)
+    {
+      fprintf(stderr, "%s: ERROR: vmeIntConnect failed\n", __func__);
+      return ERROR;
+    }
+  c1725IntRunning = 1;
+
+  return OK;
+}
+
+/**
+ * @brief Disable interrupts from all initialized modules and disconnect the
+ *        interrupt service routine.
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725IntDisconnect()
+{
+  int32_t ic, id, rval = OK;
+  uint32_t rreg;
+
+  if(!c1725IntRunning)
+    {
+      fprintf(stderr, "%s: ERROR: Interrupts not connected\n", __func__);
+      return ERROR;
+    }
+
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      id = c1725ID[ic];
+
+      C1725LOCK(id);
+      rreg = c1725ReadReg(id, &c1725p[id]->readout_ctrl) & ~C1725_READOUT_CTRL_INTLEVEL_MASK;
+      c1725WriteReg(id, &c1725p[id]->readout_ctrl, rreg);
+      c1725WriteReg(id, &c1725p[id]->interrupt_num, 0);
+      C1725UNLOCK(id);
+    }
+
+  if(vmeIntDisconnect(c1725IntLevel) != OK)
+    {
+      fprintf(stderr, "%s: ERROR: vmeIntDisconnect failed\n", __func__);
+      rval = ERROR;
+    }
+  c1725IntRunning = 0;
+
+  /* Release any waiters */
+#ifdef VXWORKS
+  semFlush(c1725IntSem);
+#else
+  pthread_mutex_lock(&c1725IntMutex);
+  pthread_cond_broadcast(&c1725IntCond);
+  pthread_mutex_unlock(&c1725IntMutex);
+#endif
+
+  return rval;
+}
+
+/* Add to rmask the modules of scanmask holding at least a block */
+static uint32_t
+c1725WaitBlockScan(uint32_t scanmask, uint32_t blocklevel, uint32_t rmask)
+{
+  int32_t ic, id;
+
+  for(ic = 0; ic < Nc1725; ic++)
+    {
+      id = c1725ID[ic];
+      if(!(scanmask & (1 << id)) || (rmask & (1 << id)))
+	continue;
+
+      C1725LOCK(id);
+      if(vmeRead32(&c1725p[id]->event_stored) >= blocklevel)
+	rmask |= (1 << id);
+      C1725UNLOCK(id);
+    }
+
+  return rmask;
+}
+
+/**
+ * @brief Wait for a block of events in the modules indicated in scanmask.
+ *        Event counts are read once, then again only after each interrupt,
+ *        instead of continuously as with c1725GBlockReady.  A module is ready
+ *        when it holds at least blocklevel events.
+ *        Requires c1725IntConnect.
+ * @param[in] scanmask Slotmask of C1725s to wait for
+ * @param[in] blocklevel Number of events in a block
+ * @param[in] timeout_us Maximum time to wait, in microseconds
+ * @return block ready mask (equal to scanmask unless timed out)
+ */
+uint32_t
+c1725WaitBlockReady(uint32_t scanmask, uint32_t blocklevel, uint32_t timeout_us)
+{
+  uint32_t rmask = 0;
+#ifdef VXWORKS
+  ULONG end;
+  int32_t left;
+#else
+  uint32_t seen;
+  struct timespec deadline;
+  int32_t stat = 0;
+#endif
+
+  if(!c1725IntRunning)
+    {
+      fprintf(stderr, "%s: ERROR: Interrupts not connected\n", __func__);
+      return 0;
+    }
+
+#ifdef VXWORKS
+  end = tickGet() + ((uint64_t) timeout_us * sysClkRateGet()) / 1000000 + 1;
+
+  /* Interrupts before this scan are not needed: the semaphore is taken
+     after each scan, and given by any interrupt during it */
+  semTake(c1725IntSem, NO_WAIT);
+  while(1)
+    {
+      rmask = c1725WaitBlockScan(scanmask, blocklevel, rmask);
+
+      left = (int32_t) (end - tickGet());
+      if((rmask == scanmask) || (left <= 0) || !c1725IntRunning)
+	break;
+
+      semTake(c1725IntSem, left);
+    }
+#else
+  c1725Deadline(&deadline, timeout_us);
+
+  pthread_mutex_lock(&c1725IntMutex);
+  while(1)
+    {
+      /* Interrupts after this are caught by the wait below */
+      seen = c1725IntCount;
+      pthread_mutex_unlock(&c1725IntMutex);
+
+      rmask = c1725WaitBlockScan(scanmask, blocklevel, rmask);
+
+      pthread_mutex_lock(&c1725IntMutex);
+      if((rmask == scanmask) || (stat == ETIMEDOUT) || !c1725IntRunning)
+	break;
+
+      while((c1725IntCount == seen) && c1725IntRunning && (stat != ETIMEDOUT))
+	stat = pthread_cond_timedwait(&c1725IntCond, &c1725IntMutex, &deadline);
+    }
+  pthread_mutex_unlock(&c1725IntMutex);
+#endif
+
+  return rmask;
+}
+
+/**
+ * @brief Number of interrupts received since c1725IntConnect
+ * @return interrupt count
+ */
+uint32_t
+c1725GetIntCount()
+{
+  uint32_t rval;
+
+#ifdef VXWORKS
+  rval = c1725IntCount;
+#else
+  pthread_mutex_lock(&c1725IntMutex);
+  rval = c1725IntCount;
+  pthread_mutex_unlock(&c1725IntMutex);
+#endif
+
+  return rval;
+}
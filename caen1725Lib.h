@@ -73,6 +73,7 @@ typedef struct
 }  c1725_chan;
 
 #define C1725_RECORD_LENGTH_MASK          0x001FFFFF
+#define C1725_RECORD_LENGTH_SAMPLES       10 /* samples per unit of minimum_record_length */
 
 #define C1725_DYNAMIC_RANGE_MASK          0x00000001
 #define C1725_DYNAMIC_RANGE_2V            0
@@ -80,11 +81,13 @@ typedef struct
 
 #define C1725_INPUT_DELAY_MASK            0x000001FF
 #define C1725_PRE_TRIGGER_MASK            0x000001FF
+#define C1725_PRE_TRIGGER_SAMPLES         4  /* samples per unit of pre_trigger */
 #define C1725_TRIGGER_THRESHOLD_MASK      0x00003FFF
 #define C1725_FIXED_BASELINE_MASK         0x00003FFF
 #define C1725_COUPLE_TRIGGER_LOGIC_MASK   0x00000003
 #define C1725_UNDER_THRESHOLD_MASK        0x001FFFFF
 #define C1725_MAX_TAIL_MASK               0x001FFFFF
+#define C1725_MAX_TAIL_SAMPLES            4  /* samples per unit of maximum_tail */
 
 #define C1725_DPP_CTRL_MASK               0x01010700
 #define C1725_DPP_TEST_PULSE_ENABLE       (1 << 8)
@@ -110,6 +113,39 @@ typedef struct
 #define C1725_DC_OFFSET_MASK              0x0000FFFF
 #define C1725_ADC_TEMP_MASK               0x000000FF
 
+/* Channel settings written by c1725SetChannelBlock */
+typedef struct
+{
+  uint32_t record_length;
+  uint32_t dynamic_range;
+  uint32_t input_delay;
+  uint32_t pre_trigger;
+  uint32_t trigger_threshold;
+  uint32_t fixed_baseline_enable;   /* 0: fixed_baseline is not written */
+  uint32_t fixed_baseline;
+  uint32_t samples_under_threshold;
+  uint32_t maximum_tail;
+  uint32_t test_pulse_enable;
+  uint32_t test_pulse_rate;
+  uint32_t test_pulse_polarity;
+  uint32_t self_trigger_enable;
+  uint32_t dc_offset;
+  uint32_t dc_offset_queued;        /* 1: dc_offset is not written, see c1725DACLoadQueue */
+} c1725ChannelConfig_t;
+
+/* Registers written by c1725SetChannelBlock, for each channel */
+#define C1725_CHANBLOCK_NREG 10
+
+/* A register to read back from a module with c1725Readback */
+typedef struct
+{
+  uint32_t offset;     /* from the module base address */
+  uint32_t mask;       /* bits to compare */
+  uint32_t expected;
+  uint32_t readback;   /* filled by c1725Readback */
+  const char *name;
+} c1725Readback_t;
+
 
 /* Configuration ROM  (in address map below) */
 typedef struct
@@ -158,7 +194,26 @@ typedef struct
   /* 0x8000 */ volatile uint32_t config;
   /* 0x8004 */ volatile uint32_t config_bitset;
   /* 0x8008 */ volatile uint32_t config_bitclear;
-  /* 0x800C          */ uint32_t _BLANK[(0x809C-0x800C)/4];
+  /* 0x800C          */ uint32_t _BLANK[(0x8020-0x800C)/4];
+
+  /* Writes to 0x80nn go to register 0x1Xnn of every channel */
+  /* 0x8020 */ volatile uint32_t all_minimum_record_length;
+  /* 0x8024          */ uint32_t _BLANK;
+  /* 0x8028 */ volatile uint32_t all_input_dynamic_range;
+  /* 0x802C          */ uint32_t _BLANK[(0x8034-0x802C)/4];
+  /* 0x8034 */ volatile uint32_t all_input_delay;
+  /* 0x8038 */ volatile uint32_t all_pre_trigger;
+  /* 0x803C          */ uint32_t _BLANK[(0x8060-0x803C)/4];
+  /* 0x8060 */ volatile uint32_t all_trigger_threshold;
+  /* 0x8064 */ volatile uint32_t all_fixed_baseline;
+  /* 0x8068 */ volatile uint32_t all_couple_trigger_logic;
+  /* 0x806C          */ uint32_t _BLANK[(0x8078-0x806C)/4];
+  /* 0x8078 */ volatile uint32_t all_samples_under_threshold;
+  /* 0x807C */ volatile uint32_t all_maximum_tail;
+  /* 0x8080 */ volatile uint32_t all_dpp_algorithm_ctrl;
+  /* 0x8084 */ volatile uint32_t all_couple_over_threshold_trigger;
+  /* 0x8088          */ uint32_t _BLANK[(0x8098-0x8088)/4];
+  /* 0x8098 */ volatile uint32_t all_dc_offset;
 
   /* 0x809C */ volatile uint32_t channel_adc_calibration;
   /* 0x80A0          */ uint32_t _BLANK[(0x8100-0x80A0)/4];
@@ -298,6 +353,12 @@ typedef struct
 #define C1725_BOARDID_GEO_MASK  0x0000001F
 
 
+/* 0xEF14 interrupt_id */
+#define C1725_INTERRUPT_ID_MASK  0x000000FF
+
+/* 0xEF18 interrupt_num */
+#define C1725_INTERRUPT_NUM_MASK 0x000003FF
+
 /* 0xEF1C max_events_per_blt */
 #define C1725_MAX_EVT_BLT_MASK 0x000003FF
 
@@ -330,6 +391,21 @@ typedef struct
 #define C1725_READOUT_CTRL_ROAK_ENABLE          (1 << 7)
 #define C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE (1 << 8)
 
+/* c1725SetShadowMode modes.  The shadow holds the configuration registers as
+   written by this library; see c1725SetShadowMode for when it goes stale */
+#define C1725_SHADOW_DISABLE  0
+#define C1725_SHADOW_ENABLE   1
+#define C1725_SHADOW_CHECK    2
+
+/* c1725SetWriteMode modes */
+#define C1725_WRITE_ALL       0
+#define C1725_WRITE_CHANGED   1
+#define C1725_WRITE_DRYRUN    2
+
+/* Block transfer address space, without and with EXT_BLK_SPACE */
+#define C1725_BLK_SPACE_NBYTES      0x1000
+#define C1725_EXT_BLK_SPACE_NBYTES  0x1000000
+
 /* vme_status Masks and bits */
 #define C1725_READOUT_STATUS_EVENT_READY        (1 << 0)
 #define C1725_READOUT_STATUS_BERR_OCCURRED      (1 << 2)
@@ -362,9 +438,159 @@ typedef struct
 #define C1725_HEADER_BIT_PATTERN_MASK 0x00FFFF00
 #define C1725_HEADER_CHANNEL_MASK     0x000000FF
 /* Header: 3rd word */
+#define C1725_HEADER_CHANNEL_MASK_HI  0xFF000000
 #define C1725_HEADER_EVENT_CNT_MASK   0x00FFFFFF
 /* Header: 4th word */
 #define C1725_HEADER_TRIGTIME_MASK    0xFFFFFFFF
+#define C1725_HEADER_NWORDS           4
+
+/* Channel data, one block per enabled channel following the header */
+/* Channel: 1st word */
+#define C1725_CHANNEL_SIZE_MASK       0x003FFFFF
+/* Channel: 2nd word */
+#define C1725_CHANNEL_TRIGTIME_MASK   0xFFFFFFFF
+#define C1725_CHANNEL_HEADER_NWORDS   2
+/* Channel: samples, two 14bit samples per word */
+#define C1725_CHANNEL_SAMPLE_MASK     0x00003FFF
+#define C1725_CHANNEL_SAMPLE_SHIFT    16
+
+/* Filler words */
+#define C1725_FILLER_WORD             0xFFFFFFFF
+#define C1725_DMA_FILLER_WORD         0xcebaf111
+
+/* Status snapshot (c1725GStatusSnapshot): the fields printed by c1725GStatus and
+   c1725ChannelsStatus, decoded.  Status and read only registers are read from the
+   modules.  Configuration fields come from the register shadow (see
+   c1725SetShadowMode), so they hold what the library last wrote, not a fresh read.
+   Plain data: the board arrays of two snapshots compare with memcmp (the
+   timestamps differ).  Bump the version when a structure changes */
+#define C1725_STATUS_VERSION 1
+#define C1725_STATUS_MAGIC   0x43313753 /* "C17S" */
+
+typedef struct
+{
+  uint32_t record_length;
+  uint32_t dynamic_range;
+  uint32_t input_delay;
+  uint32_t pre_trigger;
+  uint32_t trigger_threshold;
+  uint32_t fixed_baseline;
+  uint32_t samples_under_threshold;
+  uint32_t maximum_tail;
+  uint32_t test_pulse_enable;
+  uint32_t test_pulse_rate;
+  uint32_t test_pulse_polarity;
+  uint32_t self_trigger_enable;
+  uint32_t dc_offset;
+  /* status */
+  uint32_t memory_full;
+  uint32_t memory_empty;
+  uint32_t spi_busy;
+  uint32_t calibration_done;
+  uint32_t overtemp;
+  uint32_t adc_temperature;
+} c1725ChannelStatus_t;
+
+typedef struct
+{
+  uint32_t slot;
+  uint32_t a24;
+  uint32_t firmware_major;
+  uint32_t firmware_minor;
+  uint32_t firmware_date;
+  uint32_t mcst_addr;
+  uint32_t mcst_position;
+  uint32_t max_events_per_blt;
+  /* board configuration */
+  uint32_t trg_in_mode;
+  uint32_t veto_polarity;
+  uint32_t flag_trunc_event;
+  /* acquisition control */
+  uint32_t acq_mode;
+  uint32_t acq_arm;
+  uint32_t acq_clock_external;
+  uint32_t lvds_busy_enable;
+  uint32_t lvds_veto_enable;
+  uint32_t lvds_runin_enable;
+  /* acquisition status */
+  uint32_t running;
+  uint32_t event_ready;
+  uint32_t event_full;
+  uint32_t clock_external;
+  uint32_t pll_locked;
+  uint32_t acq_ready;
+  uint32_t sin_level;
+  uint32_t trg_level;
+  uint32_t shutdown;
+  uint32_t temperature;
+  /* readout control */
+  uint32_t intlevel;
+  uint32_t optical_int;
+  uint32_t vme_berr;
+  uint32_t align64;
+  uint32_t address_relocate;
+  uint32_t roak;
+  uint32_t ext_blk_space;
+  /* readout status */
+  uint32_t readout_event_ready;
+  uint32_t berr_occurred;
+  uint32_t vme_fifo_empty;
+  uint32_t event_stored;
+  uint32_t event_size;
+  uint32_t failure_pll;
+  uint32_t failure_temperature;
+  uint32_t failure_power;
+  /* global trigger */
+  uint32_t global_trg_channel_mask;
+  uint32_t global_trg_coinc_window;
+  uint32_t global_trg_majority;
+  uint32_t global_trg_lvds;
+  uint32_t global_trg_external;
+  uint32_t global_trg_software;
+  /* front panel TRG-OUT */
+  uint32_t fptrgout_channel_mask;
+  uint32_t fptrgout_channel_logic;
+  uint32_t fptrgout_majority;
+  uint32_t fptrgout_lvds;
+  uint32_t fptrgout_external;
+  uint32_t fptrgout_software;
+  /* front panel IO */
+  uint32_t fpio_level;
+  uint32_t fpio_trgout_enable;
+  uint32_t fpio_lvds_mask;
+  uint32_t fpio_trg_in_mask;
+  uint32_t fpio_trg_out_mask;
+  uint32_t channel_enable_mask;
+  uint32_t run_delay;
+  uint32_t veto_delay;
+  uint32_t monitor_mode;
+  uint32_t monitor_dac;
+  c1725ChannelStatus_t chan[C1725_MAX_ADC_CHANNELS];
+} c1725BoardStatus_t;
+
+typedef struct
+{
+  uint32_t version;     /* C1725_STATUS_VERSION */
+  uint32_t nboards;
+  uint64_t timestamp;   /* CLOCK_REALTIME, ns */
+  c1725BoardStatus_t board[C1725_MAX_BOARDS];  /* in the order of c1725Slot */
+} c1725Status_t;
+
+/* Readout counters of one module (c1725CountersSnapshot).  Updated without
+   locks by the readout routines, and cleared by c1725ResetCounters */
+typedef struct
+{
+  uint64_t events;         /* events read */
+  uint64_t words;          /* words in those events */
+  uint64_t dma_calls;      /* DMAs started */
+  uint64_t dma_retries;    /* DMAs continuing a readout past the readout window */
+  uint64_t berr_terms;     /* readouts ended by the bus error of the module */
+  uint64_t zero_words;     /* DMAs that transferred no words */
+  uint64_t scan_polls;     /* event_stored reads by c1725GBlockReady(Scan) */
+  uint64_t scan_timeouts;  /* scans that ended with the module not ready */
+  uint64_t lock_waits;     /* lock requests that found the lock held */
+  uint64_t lock_wait_ns;   /* time spent waiting for those locks */
+} c1725Counters_t;
 
 
 #ifdef __cplusplus
@@ -381,16 +607,26 @@ int32_t c1725N();
 
 void c1725GStatus(int32_t sflag);
 int32_t c1725ChannelsStatus(int32_t id, int32_t sflag);
+int32_t c1725GStatusSnapshot(c1725Status_t *st);
+int32_t c1725StatusSnapshotJSON(c1725Status_t *st, char *buf, uint32_t size);
+int32_t c1725StatusSnapshotPack(c1725Status_t *st, uint8_t *buf, uint32_t size);
+int32_t c1725StatusSnapshotUnpack(const uint8_t *buf, uint32_t size, c1725Status_t *st);
 
 int32_t c1725SetBoardConfiguration(int32_t id, uint32_t trg_in_mode,
 				   uint32_t veto_polarity, uint32_t frag_trunc_event);
 int32_t c1725GetBoardConfiguration(int32_t id, uint32_t *trg_in_mode,
 				   uint32_t *veto_polarity, uint32_t *frag_trunc_event);
 int32_t c1725ADCCalibration(int32_t id);
+int32_t c1725GADCCalibrationStart();
+int32_t c1725ADCCalibrationStatus(int32_t id, uint32_t *donemask);
+int32_t c1725GADCCalibrationWait(uint32_t timeout_us, uint32_t *donemask);
 
 int32_t c1725SetAcquisitionControl(int32_t id, uint32_t mode, uint32_t arm, uint32_t clocksource,
 				   uint32_t lvds_busy_enable, uint32_t lvds_veto_enable,
 				   uint32_t lvds_runin_enable);
+int32_t c1725GSetAcquisitionControl(uint32_t mode, uint32_t arm, uint32_t clocksource,
+				    uint32_t lvds_busy_enable, uint32_t lvds_veto_enable,
+				    uint32_t lvds_runin_enable);
 
 int32_t c1725GetAcquisitionControl(int32_t id, uint32_t *mode, uint32_t *arm, uint32_t *clocksource,
 				   uint32_t *lvds_busy_enable, uint32_t *lvds_veto_enable,
@@ -460,7 +696,18 @@ int32_t c1725SetMaxEventsPerBLT(int32_t id, uint32_t max_events);
 int32_t c1725GetMaxEventsPerBLT(int32_t id, uint32_t *max_events);
 
 int32_t c1725Reset(int32_t id);
+int32_t c1725SetShadowMode(int32_t mode);
+int32_t c1725GetShadowMode();
+int32_t c1725ShadowInvalidate(int32_t id);
+int32_t c1725ShadowRefresh(int32_t id);
+int32_t c1725ShadowCheck(int32_t id, int32_t pflag);
+int32_t c1725Readback(int32_t id, c1725Readback_t *regs, int32_t nregs);
+int32_t c1725GetShadowStats(int32_t id, uint32_t *hits, uint32_t *misses, uint32_t *mismatches);
+int32_t c1725SetWriteMode(int32_t mode);
+int32_t c1725GetWriteMode();
+int32_t c1725GetWriteStats(int32_t id, uint32_t *writes, uint32_t *skipped);
 int32_t c1725Clear(int32_t id);
+int32_t c1725GClear();
 
 int32_t c1725SetRecordLength(int32_t id, int32_t chan, uint32_t min_record_length);
 int32_t c1725GetRecordLength(int32_t id, int32_t chan, uint32_t *min_record_length);
@@ -472,6 +719,7 @@ int32_t c1725SetPreTrigger(int32_t id, int32_t chan, uint32_t pretrigger);
 int32_t c1725GetPreTrigger(int32_t id, int32_t chan, uint32_t *pretrigger);
 int32_t c1725SetTriggerThreshold(int32_t id, int32_t chan, uint32_t thres);
 int32_t c1725GetTriggerThreshold(int32_t id, int32_t chan, uint32_t *thres);
+int32_t c1725GSetTriggerThreshold(int32_t chan, uint32_t thres);
 int32_t c1725SetFixedBaseline(int32_t id, int32_t chan, uint32_t baseline);
 int32_t c1725GetFixedBaseline(int32_t id, int32_t chan, uint32_t *baseline);
 int32_t c1725SetCoupleTriggerLogic(int32_t id, int32_t chan, uint32_t logic);
@@ -494,10 +742,34 @@ int32_t c1725GetADCTemperature(int32_t id, uint32_t chan, uint32_t *temperature)
 
 int32_t c1725SetDCOffset(int32_t id, int32_t chan, uint32_t offset);
 int32_t c1725GetDCOffset(int32_t id, int32_t chan, uint32_t *offset);
+int32_t c1725DACLoadQueue(int32_t id, uint32_t chanmask, uint32_t *offset);
+int32_t c1725DACLoadStart(uint32_t timeout_us);
+int32_t c1725DACLoadStatus(int32_t id, uint32_t *pending, uint32_t *failed);
+int32_t c1725DACLoadWait(uint32_t timeout_us);
+int32_t c1725SetChannelBlock(int32_t id, uint32_t chanmask, c1725ChannelConfig_t *cfg);
+int32_t c1725UpdateChannelBlock(int32_t id, uint32_t chanmask, c1725ChannelConfig_t *cfg);
+int32_t c1725ChannelBlockReadback(uint32_t chanmask, c1725ChannelConfig_t *cfg,
+				  c1725Readback_t *regs, int32_t nmax);
 
 int32_t c1725ReadEvent(int32_t id, volatile uint32_t *data, int32_t nwrds, int32_t rflag);
 int32_t c1725CBLTReadBlock(volatile uint32_t *data, uint32_t nwrds, int32_t rflag);
+int32_t c1725ReadEventStart(int32_t id, volatile uint32_t *data, int32_t nwrds);
+int32_t c1725CBLTReadStart(volatile uint32_t *data, uint32_t nwrds);
+int32_t c1725ReadComplete();
+int32_t c1725GetDMAStats(uint32_t *transfers, uint32_t *retries);
+int32_t c1725GetDMAChunkStats(uint32_t *readouts, uint32_t *saved);
+int32_t c1725GetBlockWords(int32_t id, uint32_t blocklevel, uint32_t *maxwords, uint32_t *expwords);
+int32_t c1725GBlockWords(uint32_t blocklevel, uint32_t *maxwords, uint32_t *expwords);
+int32_t c1725ResetDMAStats();
+int32_t c1725CountersSnapshot(int32_t id, c1725Counters_t *cnt);
+int32_t c1725ResetCounters();
 uint32_t c1725GBlockReady(uint32_t scanmask, uint32_t max_scans, uint32_t blocklevel);
+uint32_t c1725GBlockReadyScan(uint32_t scanmask, uint32_t max_scans, uint32_t blocklevel,
+			      uint32_t *nscans, uint64_t *elapsed_ns);
+int32_t  c1725IntConnect(uint32_t vector, uint32_t level, uint32_t nevents);
+int32_t  c1725IntDisconnect();
+uint32_t c1725WaitBlockReady(uint32_t scanmask, uint32_t blocklevel, uint32_t timeout_us);
+uint32_t c1725GetIntCount();
 
 #ifdef __cplusplus
 }
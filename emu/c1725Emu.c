@@ -0,0 +1,1044 @@
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      c1725Emu.c
+ * @brief     In-memory model of the CAEN 1725 (DPP-DAW) register map and
+ *            output buffer, used by the jvme stand-in in jvmeEmu.c
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <time.h>
+#include "jvme.h"
+#include "caen1725Lib.h"
+#include "c1725Emu.h"
+#include "c1725EmuPriv.h"
+
+/* Register offsets in the c1725_address map */
+#define OFF(_reg)        ((uint32_t) offsetof(c1725_address, _reg))
+#define CHOFF(_ch, _reg) (OFF(chan[0]._reg) + ((_ch) << 8))
+#define REG(_b, _off)    ((_b)->reg[(_off) >> 2])
+
+#define EMU_FIRMWARE_REVISION  0x1A140411  /* 4.17, 2021-04-20 */
+#define EMU_CHAN_FIRMWARE      0x1A148B05
+#define EMU_BOARD_INFO         0x0000100E
+#define EMU_TRIGTIME_TICKS     125         /* trigger time tag ticks per trigger */
+
+struct emuBoard
+{
+  int32_t   slot;
+  uint32_t  reg[C1725EMU_REGSPACE >> 2];
+
+  /* Output buffer (host order), events are contiguous */
+  uint32_t *words;
+  uint32_t  wcap, whead, wtail;
+  uint32_t  evsize[C1725EMU_MAX_EVENTS + 1];
+  uint32_t  evhead, evtail;
+  uint32_t  nev;        /* complete events not yet started */
+  uint32_t  cur_left;   /* words left in the event being read out */
+  uint32_t  blt_events; /* events started in the current block transfer */
+
+  uint64_t  trig_seen;  /* crate trigger count this board has caught up to */
+  uint32_t  evcount;
+  uint32_t  berr;
+  uint32_t  irq_acked;  /* ROAK: interrupt acknowledged, not raised again until re-armed */
+  uint32_t  spi_busy[C1725_MAX_ADC_CHANNELS];
+  uint64_t  spi_until[C1725_MAX_ADC_CHANNELS]; /* SPI busy until this time */
+  uint32_t  calib_busy[C1725_MAX_ADC_CHANNELS];
+
+  /* Event template, rebuilt when the configuration changes */
+  int32_t   dirty;
+  uint32_t *tmpl;
+  uint32_t  tmpl_words, tmpl_cap;
+  uint32_t  tmpl_nchan;
+  uint32_t  tmpl_chan[C1725_MAX_ADC_CHANNELS]; /* index of each channel header */
+};
+
+static pthread_mutex_t emuMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct
+{
+  int32_t   init;
+  emuBoard *board[MAX_VME_SLOTS + 1];
+  int32_t   nboards;
+
+  /* crate trigger generator */
+  double    rate;
+  uint64_t  rate_t0;
+  uint64_t  rate_base;
+  uint64_t  manual;
+
+  double    dma_mbps;
+  uint32_t  sct_ns;
+  uint32_t  dma_setup_ns;
+  uint32_t  spi_reads;
+  uint32_t  spi_ns;
+  uint32_t  calib_reads;
+  int32_t   verbose;
+
+  int32_t   cblt_pos;
+
+  c1725EmuStats_t stats;
+} emu;
+
+/* Broadcast (all channel) register offsets, 0x80XX writes 0x1nXX */
+static const uint32_t emuBroadcast[] =
+  { 0x20, 0x28, 0x34, 0x38, 0x60, 0x64, 0x68, 0x78, 0x7C, 0x80, 0x84, 0x98 };
+
+void
+emuLock()
+{
+  pthread_mutex_lock(&emuMutex);
+}
+
+void
+emuUnlock()
+{
+  pthread_mutex_unlock(&emuMutex);
+}
+
+static uint64_t
+emuNow()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Number of triggers delivered to the crate so far */
+static uint64_t
+emuCrateTriggers()
+{
+  uint64_t ntrig = emu.manual + emu.rate_base;
+
+  if(emu.rate > 0)
+    ntrig += (uint64_t) ((double) (emuNow() - emu.rate_t0) * 1e-9 * emu.rate);
+
+  return ntrig;
+}
+
+static void
+emuBoardClear(emuBoard *b)
+{
+  b->whead = b->wtail = 0;
+  b->evhead = b->evtail = 0;
+  b->nev = 0;
+  b->cur_left = 0;
+  b->blt_events = 0;
+  b->berr = 0;
+  b->evcount = 0;
+  b->irq_acked = 0;
+}
+
+static void
+emuBoardReset(emuBoard *b)
+{
+  int32_t ich;
+
+  memset(b->reg, 0, sizeof(b->reg));
+
+  REG(b, OFF(readout_ctrl)) = C1725_READOUT_CTRL_BERR_ENABLE;
+  REG(b, OFF(board_id)) = b->slot;
+  REG(b, OFF(channel_enable_mask)) = C1725_ENABLE_CHANNEL_MASK;
+  REG(b, OFF(roc_firmware_revision)) = EMU_FIRMWARE_REVISION;
+  REG(b, OFF(board_info)) = EMU_BOARD_INFO;
+  REG(b, OFF(rom.board0)) = C1725_ROM_BOARD_ID & 0xFF;
+  REG(b, OFF(rom.board1)) = (C1725_ROM_BOARD_ID >> 8) & 0xFF;
+
+  for(ich = 0; ich < C1725_MAX_ADC_CHANNELS; ich++)
+    {
+      REG(b, CHOFF(ich, firmware_revision)) = EMU_CHAN_FIRMWARE;
+      REG(b, CHOFF(ich, adc_temperature)) = 40 + ich;
+      b->spi_busy[ich] = 0;
+      b->spi_until[ich] = 0;
+      b->calib_busy[ich] = 0;
+    }
+
+  emuBoardClear(b);
+  b->trig_seen = emuCrateTriggers();
+  b->dirty = 1;
+}
+
+/* Build the event template from the programmed channel registers */
+static void
+emuBuildTemplate(emuBoard *b)
+{
+  uint32_t mask = REG(b, OFF(channel_enable_mask)) & C1725_ENABLE_CHANNEL_MASK;
+  uint32_t nwords = C1725_HEADER_NWORDS, iw, ich, is;
+  uint32_t baseline, pretrig;
+
+  for(ich = 0; ich < C1725_MAX_ADC_CHANNELS; ich++)
+    {
+      if(mask & (1 << ich))
+	{
+	  uint32_t nsamples = (REG(b, CHOFF(ich, minimum_record_length)) & C1725_RECORD_LENGTH_MASK)
+	    * C1725_RECORD_LENGTH_SAMPLES;
+	  nwords += C1725_CHANNEL_HEADER_NWORDS + ((nsamples + 1) >> 1);
+	}
+    }
+
+  if(nwords > b->tmpl_cap)
+    {
+      b->tmpl = realloc(b->tmpl, nwords * sizeof(uint32_t));
+      b->tmpl_cap = nwords;
+    }
+
+  b->tmpl[0] = C1725_HEADER_TYPE_ID | nwords;
+  b->tmpl[1] = ((REG(b, OFF(board_id)) & C1725_BOARDID_GEO_MASK) << 27) | (mask & 0xFF);
+  b->tmpl[2] = ((mask >> 8) & 0xFF) << 24;
+  b->tmpl[3] = 0;
+
+  iw = C1725_HEADER_NWORDS;
+  b->tmpl_nchan = 0;
+  for(ich = 0; ich < C1725_MAX_ADC_CHANNELS; ich++)
+    {
+      if(!(mask & (1 << ich)))
+	continue;
+
+      uint32_t nsamples = (REG(b, CHOFF(ich, minimum_record_length)) & C1725_RECORD_LENGTH_MASK)
+	* C1725_RECORD_LENGTH_SAMPLES;
+      uint32_t nsw = (nsamples + 1) >> 1;
+
+      baseline = REG(b, CHOFF(ich, fixed_baseline)) & C1725_FIXED_BASELINE_MASK;
+      if(baseline == 0)
+	baseline = 8192;
+      pretrig = (REG(b, CHOFF(ich, pre_trigger)) & C1725_PRE_TRIGGER_MASK)
+	* C1725_PRE_TRIGGER_SAMPLES;
+
+      b->tmpl_chan[b->tmpl_nchan++] = iw;
+      b->tmpl[iw++] = C1725_CHANNEL_HEADER_NWORDS + nsw;
+      b->tmpl[iw++] = 0;
+
+      for(is = 0; is < 2 * nsw; is += 2)
+	{
+	  uint32_t s[2], k;
+	  for(k = 0; k < 2; k++)
+	    {
+	      uint32_t isamp = is + k, pulse = 0;
+	      if(isamp >= pretrig && (isamp - pretrig) < 64)
+		pulse = 2000 >> ((isamp - pretrig) >> 3);
+	      s[k] = (baseline + ((isamp * 3 + ich * 11) & 0x3F) + pulse)
+		& C1725_CHANNEL_SAMPLE_MASK;
+	    }
+	  b->tmpl[iw++] = s[0] | (s[1] << C1725_CHANNEL_SAMPLE_SHIFT);
+	}
+    }
+
+  b->tmpl_words = nwords;
+  b->dirty = 0;
+}
+
+/* Append one event for crate trigger trigno to the output buffer */
+static void
+emuGenerate(emuBoard *b, uint64_t trigno)
+{
+  uint32_t ich, *ev, trigtime = (uint32_t) (trigno * EMU_TRIGTIME_TICKS);
+
+  if(b->dirty)
+    emuBuildTemplate(b);
+
+  if(b->wtail + b->tmpl_words > b->wcap)
+    {
+      uint32_t live = b->wtail - b->whead;
+      if(b->whead > 0)
+	{
+	  memmove(b->words, &b->words[b->whead], live * sizeof(uint32_t));
+	  b->whead = 0;
+	  b->wtail = live;
+	}
+      if(live + b->tmpl_words > b->wcap)
+	{
+	  b->wcap = 2 * (live + b->tmpl_words) + 1024;
+	  b->words = realloc(b->words, b->wcap * sizeof(uint32_t));
+	}
+    }
+
+  ev = &b->words[b->wtail];
+  memcpy(ev, b->tmpl, b->tmpl_words * sizeof(uint32_t));
+  ev[2] |= b->evcount & C1725_HEADER_EVENT_CNT_MASK;
+  ev[3] = trigtime;
+  for(ich = 0; ich < b->tmpl_nchan; ich++)
+    ev[b->tmpl_chan[ich] + 1] = trigtime;
+
+  b->wtail += b->tmpl_words;
+  b->evsize[b->evtail] = b->tmpl_words;
+  b->evtail = (b->evtail + 1) % (C1725EMU_MAX_EVENTS + 1);
+  b->nev++;
+  b->evcount++;
+}
+
+static uint32_t
+emuStored(emuBoard *b)
+{
+  return b->nev + ((b->cur_left > 0) ? 1 : 0);
+}
+
+/* Catch up with the crate triggers while armed */
+static void
+emuAdvance(emuBoard *b)
+{
+  uint64_t total = emuCrateTriggers();
+
+  if(REG(b, OFF(acq_ctrl)) & C1725_ACQ_RUN)
+    {
+      for(; b->trig_seen < total; b->trig_seen++)
+	{
+	  if(emuStored(b) >= C1725EMU_MAX_EVENTS)
+	    {
+	      emu.stats.events_lost += total - b->trig_seen;
+	      break;
+	    }
+	  emuGenerate(b, b->trig_seen);
+	}
+    }
+
+  b->trig_seen = total;
+}
+
+/* Start reading out the next stored event, 0 if none */
+static int32_t
+emuStartEvent(emuBoard *b)
+{
+  if(b->nev == 0)
+    return 0;
+
+  b->cur_left = b->evsize[b->evhead];
+  b->evhead = (b->evhead + 1) % (C1725EMU_MAX_EVENTS + 1);
+  b->nev--;
+  b->blt_events++;
+
+  return 1;
+}
+
+static void
+emuConsumed(emuBoard *b, uint32_t nwords)
+{
+  b->whead += nwords;
+  b->cur_left -= nwords;
+  if(b->whead == b->wtail)
+    b->whead = b->wtail = 0;
+}
+
+static uint32_t
+emuPopWord(emuBoard *b)
+{
+  uint32_t word;
+
+  if((b->cur_left == 0) && (emuStartEvent(b) == 0))
+    return C1725_FILLER_WORD;
+
+  word = b->words[b->whead];
+  emuConsumed(b, 1);
+
+  if(b->cur_left == 0)
+    b->blt_events = 0;
+
+  return word;
+}
+
+/**
+ * Move up to limit words of the current block transfer into dst (VME byte order).
+ * *done is set when the board has no more data for this block transfer
+ */
+static uint32_t
+emuBoardTake(emuBoard *b, volatile uint32_t *dst, uint32_t limit, int32_t *done)
+{
+  uint32_t n = 0, quota, chunk, iw;
+
+  quota = REG(b, OFF(max_events_per_blt)) & C1725_MAX_EVT_BLT_MASK;
+  if(quota == 0)
+    quota = 1;
+
+  *done = 0;
+  emuAdvance(b);
+
+  while(n < limit)
+    {
+      if(b->cur_left == 0)
+	{
+	  if((b->blt_events >= quota) || (emuStartEvent(b) == 0))
+	    {
+	      *done = 1;
+	      b->blt_events = 0;
+	      break;
+	    }
+	}
+
+      chunk = limit - n;
+      if(chunk > b->cur_left)
+	chunk = b->cur_left;
+
+      for(iw = 0; iw < chunk; iw++)
+	dst[n + iw] = LSWAP(b->words[b->whead + iw]);
+
+      n += chunk;
+      emuConsumed(b, chunk);
+    }
+
+  return n;
+}
+
+static uint32_t
+emuBltLimit(emuBoard *b, uint32_t maxwords)
+{
+  if(!(REG(b, OFF(readout_ctrl)) & C1725_READOUT_CTRL_EXT_BLK_SPACE_ENABLE) &&
+     (maxwords > (C1725EMU_BLT_SPACE >> 2)))
+    return C1725EMU_BLT_SPACE >> 2; /* address wraps into the register space */
+
+  return maxwords;
+}
+
+/* Terminate a block transfer of n words: align, then BERR or filler */
+static uint32_t
+emuBltEnd(emuBoard *b, volatile uint32_t *dst, uint32_t n, uint32_t limit)
+{
+  uint32_t ctrl = REG(b, OFF(readout_ctrl));
+
+  if((ctrl & C1725_READOUT_CTRL_ALIGN64_ENABLE) && (n & 1) && (n < limit))
+    dst[n++] = LSWAP(C1725_FILLER_WORD);
+
+  if(ctrl & C1725_READOUT_CTRL_BERR_ENABLE)
+    {
+      b->berr = 1;
+      emu.stats.berr++;
+      return n;
+    }
+
+  while(n < limit)
+    dst[n++] = LSWAP(C1725_FILLER_WORD);
+
+  return n;
+}
+
+int32_t
+emuBoardDma(emuBoard *b, volatile uint32_t *dst, uint32_t maxwords)
+{
+  uint32_t n, limit = emuBltLimit(b, maxwords);
+  int32_t done = 0;
+
+  n = emuBoardTake(b, dst, limit, &done);
+  if(done)
+    n = emuBltEnd(b, dst, n, limit);
+
+  emu.stats.dma_transfers++;
+  emu.stats.dma_bytes += n << 2;
+
+  return n;
+}
+
+static int32_t
+emuInChain(emuBoard *b, uint32_t mcst)
+{
+  uint32_t rreg = REG(b, OFF(multicast_address));
+
+  return ((rreg & C1725_MCST_ADDR_MASK) == mcst) &&
+    ((rreg & C1725_MCST_SLOT_MASK) != C1725_MCST_SLOT_DISABLED);
+}
+
+int32_t
+emuMcstPresent(uint32_t mcst)
+{
+  int32_t slot;
+
+  for(slot = 0; slot <= MAX_VME_SLOTS; slot++)
+    if(emu.board[slot] && emuInChain(emu.board[slot], mcst))
+      return 1;
+
+  return 0;
+}
+
+int32_t
+emuCbltDma(uint32_t mcst, volatile uint32_t *dst, uint32_t maxwords)
+{
+  emuBoard *chain[MAX_VME_SLOTS + 1];
+  uint32_t n = 0, limit = maxwords;
+  int32_t nchain = 0, slot, done = 0;
+
+  for(slot = 0; slot <= MAX_VME_SLOTS; slot++)
+    if(emu.board[slot] && emuInChain(emu.board[slot], mcst))
+      chain[nchain++] = emu.board[slot];
+
+  emu.stats.dma_transfers++;
+  if(nchain == 0)
+    return 0;
+
+  limit = emuBltLimit(chain[0], maxwords);
+
+  if(emu.cblt_pos < 0)
+    emu.cblt_pos = 0;
+
+  while(emu.cblt_pos < nchain)
+    {
+      n += emuBoardTake(chain[emu.cblt_pos], &dst[n], limit - n, &done);
+      if(!done)
+	break;
+      emu.cblt_pos++;
+    }
+
+  if(emu.cblt_pos >= nchain)
+    { /* Token passed the last board */
+      n = emuBltEnd(chain[nchain - 1], dst, n, limit);
+      emu.cblt_pos = -1;
+    }
+
+  emu.stats.dma_bytes += n << 2;
+
+  return n;
+}
+
+uint32_t
+emuBoardRead(emuBoard *b, uint32_t offset)
+{
+  uint32_t rval = 0, ich;
+
+  emu.stats.sct_reads++;
+
+  if(offset < C1725EMU_BLT_SPACE)
+    {
+      emuAdvance(b);
+      return emuPopWord(b);
+    }
+
+  if((offset >= OFF(chan[0])) && (offset < OFF(chan[C1725_MAX_ADC_CHANNELS])) &&
+     ((offset & 0xFF) == (CHOFF(0, status) & 0xFF)))
+    {
+      ich = (offset >> 8) & 0xF;
+      emuAdvance(b);
+      if(emuStored(b) == 0)
+	rval |= C1725_CHANNEL_STATUS_MEM_EMPY;
+      if(emuStored(b) >= C1725EMU_MAX_EVENTS)
+	rval |= C1725_CHANNEL_STATUS_MEM_FULL;
+      if(b->spi_busy[ich])
+	{
+	  rval |= C1725_CHANNEL_STATUS_SPI_BUSY;
+	  b->spi_busy[ich]--;
+	}
+      else if(b->spi_until[ich] > emuNow())
+	rval |= C1725_CHANNEL_STATUS_SPI_BUSY;
+      if(b->calib_busy[ich])
+	b->calib_busy[ich]--;
+      else
+	rval |= C1725_CHANNEL_STATUS_CALIB_DONE;
+      return rval;
+    }
+
+  if(offset == OFF(acq_status))
+    {
+      emuAdvance(b);
+      rval = REG(b, OFF(acq_ctrl)) & C1725_ACQ_RUN;
+      rval |= (emuStored(b) > 0) ? C1725_ACQ_STATUS_EVENT_READY : 0;
+      rval |= (emuStored(b) >= C1725EMU_MAX_EVENTS) ? C1725_ACQ_STATUS_EVENT_FULL : 0;
+      rval |= (REG(b, OFF(acq_ctrl)) & C1725_ACQ_CLK_EXT) ? C1725_ACQ_STATUS_CLK_EXTERNAL : 0;
+      rval |= C1725_ACQ_STATUS_PLL_LOCKED | C1725_ACQ_STATUS_ACQ_READY;
+      return rval;
+    }
+
+  if(offset == OFF(event_stored))
+    {
+      emuAdvance(b);
+      return b->nev;
+    }
+
+  if(offset == OFF(event_size))
+    {
+      emuAdvance(b);
+      return b->nev ? b->evsize[b->evhead] : 0;
+    }
+
+  if(offset == OFF(readout_status))
+    {
+      emuAdvance(b);
+      rval = (emuStored(b) > 0) ? C1725_READOUT_STATUS_EVENT_READY : 0;
+      rval |= b->berr ? C1725_READOUT_STATUS_BERR_OCCURRED : 0;
+      rval |= (b->wtail == b->whead) ? C1725_READOUT_STATUS_VME_FIFO_EMPTY : 0;
+      b->berr = 0; /* cleared on read */
+      return rval;
+    }
+
+  if(offset < C1725EMU_REGSPACE)
+    return REG(b, offset);
+
+  return C1725_FILLER_WORD;
+}
+
+/* Register write, without counting a VME cycle */
+static void
+emuRegWrite(emuBoard *b, uint32_t offset, uint32_t val)
+{
+  uint32_t ich, ib;
+
+  if(offset >= C1725EMU_REGSPACE)
+    return;
+
+  /* Broadcast to all channels */
+  if((offset & 0xFF00) == 0x8000)
+    {
+      for(ib = 0; ib < sizeof(emuBroadcast) / sizeof(emuBroadcast[0]); ib++)
+	{
+	  if((offset & 0xFF) == emuBroadcast[ib])
+	    {
+	      for(ich = 0; ich < C1725_MAX_ADC_CHANNELS; ich++)
+		emuRegWrite(b, CHOFF(ich, minimum_record_length) - 0x20 + emuBroadcast[ib],
+			      val);
+	      return;
+	    }
+	}
+    }
+
+  if((offset >= OFF(chan[0])) && (offset < OFF(chan[C1725_MAX_ADC_CHANNELS])))
+    {
+      ich = (offset >> 8) & 0xF;
+      switch(offset & 0xFF)
+	{
+	case 0x88: /* status */
+	case 0x8C: /* firmware_revision */
+	case 0xA8: /* adc_temperature */
+	  return;
+	case 0x98: /* dc_offset */
+	  b->spi_busy[ich] = emu.spi_reads;
+	  b->spi_until[ich] = emu.spi_ns ? emuNow() + emu.spi_ns : 0;
+	  break;
+	}
+      REG(b, offset) = val;
+      b->dirty = 1;
+      return;
+    }
+
+  if(offset == OFF(config_bitset))
+    REG(b, OFF(config)) |= val;
+  else if(offset == OFF(config_bitclear))
+    REG(b, OFF(config)) &= ~val;
+  else if(offset == OFF(channel_adc_calibration))
+    {
+      for(ich = 0; ich < C1725_MAX_ADC_CHANNELS; ich++)
+	b->calib_busy[ich] = emu.calib_reads;
+    }
+  else if(offset == OFF(acq_ctrl))
+    {
+      emuAdvance(b);
+      REG(b, offset) = val;
+    }
+  else if(offset == OFF(sw_trigger))
+    {
+      emuAdvance(b);
+      if((REG(b, OFF(acq_ctrl)) & C1725_ACQ_RUN) && (emuStored(b) < C1725EMU_MAX_EVENTS))
+	emuGenerate(b, b->trig_seen);
+    }
+  else if(offset == OFF(software_clear))
+    {
+      emuAdvance(b);	/* triggers already delivered are cleared too */
+      emuBoardClear(b);
+    }
+  else if((offset == OFF(software_reset)) || (offset == OFF(config_reload)))
+    {
+      emuBoardReset(b);
+    }
+  else if((offset == OFF(acq_status)) || (offset == OFF(event_stored)) ||
+	  (offset == OFF(event_size)) || (offset == OFF(readout_status)) ||
+	  (offset == OFF(roc_firmware_revision)) || (offset == OFF(board_info)) ||
+	  (offset == OFF(board_failure_status)) || (offset >= OFF(rom)))
+    {
+      return; /* read only */
+    }
+  else
+    {
+      REG(b, offset) = val;
+      if((offset == OFF(channel_enable_mask)) || (offset == OFF(board_id)))
+	b->dirty = 1;
+    }
+}
+
+void
+emuBoardWrite(emuBoard *b, uint32_t offset, uint32_t val)
+{
+  emu.stats.sct_writes++;
+  emuRegWrite(b, offset, val);
+}
+
+void
+emuMcstWrite(uint32_t mcst, uint32_t offset, uint32_t val)
+{
+  int32_t slot;
+
+  emu.stats.sct_writes++;
+
+  for(slot = 0; slot <= MAX_VME_SLOTS; slot++)
+    if(emu.board[slot] && emuInChain(emu.board[slot], mcst))
+      emuRegWrite(emu.board[slot], offset, val);
+}
+
+/**
+ * Interrupt raised by any board on level: its readout_ctrl interrupt level is
+ * set and it holds interrupt_num events.  The interrupt is acknowledged; with
+ * ROAK a board raises it again only after falling below interrupt_num, with
+ * RORA for as long as it holds the events.
+ * Returns the number of boards interrupting, their vector in *vector
+ */
+int32_t
+emuIrqPending(uint32_t level, uint32_t *vector)
+{
+  int32_t slot, nirq = 0;
+
+  for(slot = 0; slot <= MAX_VME_SLOTS; slot++)
+    {
+      emuBoard *b = emu.board[slot];
+      uint32_t ctrl, num;
+
+      if(b == NULL)
+	continue;
+
+      ctrl = REG(b, OFF(readout_ctrl));
+      num = REG(b, OFF(interrupt_num)) & C1725_INTERRUPT_NUM_MASK;
+      if(((ctrl & C1725_READOUT_CTRL_INTLEVEL_MASK) != level) || (num == 0))
+	continue;
+
+      emuAdvance(b);
+      if(emuStored(b) < num)
+	{
+	  b->irq_acked = 0;
+	  continue;
+	}
+
+      if(b->irq_acked)
+	continue;
+
+      if(ctrl & C1725_READOUT_CTRL_ROAK_ENABLE)
+	b->irq_acked = 1;
+
+      *vector = REG(b, OFF(interrupt_id)) & C1725_INTERRUPT_ID_MASK;
+      nirq++;
+    }
+
+  if(nirq)
+    emu.stats.irqs++;
+
+  return nirq;
+}
+
+emuBoard *
+emuBoardFromSlot(int32_t slot)
+{
+  if((slot < 0) || (slot > MAX_VME_SLOTS))
+    return NULL;
+
+  return emu.board[slot];
+}
+
+uint32_t
+emuSCTTime()
+{
+  return emu.sct_ns;
+}
+
+double
+emuDMARate()
+{
+  return emu.dma_mbps;
+}
+
+uint32_t
+emuDMASetupTime()
+{
+  return emu.dma_setup_ns;
+}
+
+static void
+emuDefaults()
+{
+  const char *env;
+
+  if(emu.init)
+    return;
+
+  emu.init = 1;
+  emu.cblt_pos = -1;
+  emu.spi_reads = 2;
+  emu.calib_reads = 4;
+  emu.rate_t0 = emuNow();
+
+  if((env = getenv("C1725EMU_RATE")))
+    emu.rate = atof(env);
+  if((env = getenv("C1725EMU_DMA_MBPS")))
+    emu.dma_mbps = atof(env);
+  if((env = getenv("C1725EMU_SCT_NS")))
+    emu.sct_ns = strtoul(env, NULL, 0);
+  if((env = getenv("C1725EMU_DMA_SETUP_NS")))
+    emu.dma_setup_ns = strtoul(env, NULL, 0);
+  if((env = getenv("C1725EMU_SPI_BUSY")))
+    emu.spi_reads = strtoul(env, NULL, 0);
+  if((env = getenv("C1725EMU_SPI_BUSY_NS")))
+    emu.spi_ns = strtoul(env, NULL, 0);
+  if((env = getenv("C1725EMU_VERBOSE")))
+    emu.verbose = atoi(env);
+}
+
+static int32_t
+emuAddBoard(int32_t slot)
+{
+  emuBoard *b;
+
+  if((slot < 2) || (slot > MAX_VME_SLOTS))
+    {
+      fprintf(stderr, "%s: ERROR: Invalid slot (%d)\n", __func__, slot);
+      return ERROR;
+    }
+
+  if(emu.board[slot] != NULL)
+    return OK;
+
+  b = calloc(1, sizeof(emuBoard));
+  if(b == NULL)
+    return ERROR;
+
+  b->slot = slot;
+  emuBoardReset(b);
+  emu.board[slot] = b;
+  emu.nboards++;
+
+  if(emu.verbose)
+    printf("%s: emulated C1725 in slot %d\n", __func__, slot);
+
+  return OK;
+}
+
+/* Called with the model locked when the first VME window is opened */
+void
+emuModelInit()
+{
+  const char *env;
+  char slots[256], *tok, *save = NULL;
+  static int32_t model_init = 0;
+
+  emuDefaults();
+
+  if(model_init)
+    return;
+  model_init = 1;
+
+  if(emu.nboards > 0)
+    return;
+
+  env = getenv("C1725EMU_SLOTS");
+  strncpy(slots, env ? env : "3", sizeof(slots) - 1);
+  slots[sizeof(slots) - 1] = 0;
+
+  for(tok = strtok_r(slots, ", ", &save); tok; tok = strtok_r(NULL, ", ", &save))
+    {
+      char *dash = strchr(tok, '-');
+      int32_t slot, last = dash ? atoi(dash + 1) : atoi(tok);
+
+      for(slot = atoi(tok); slot <= last; slot++)
+	emuAddBoard(slot);
+    }
+}
+
+/**
+ * @brief Add an emulated board in the specified slot
+ * @param[in] slot VME slot number (A24 address slot << 19)
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725EmuAddBoard(int32_t slot)
+{
+  int32_t rval;
+
+  emuLock();
+  emuDefaults();
+  rval = emuAddBoard(slot);
+  emuUnlock();
+
+  return rval;
+}
+
+/**
+ * @brief Remove all emulated boards
+ * @return OK
+ */
+int32_t
+c1725EmuRemoveAllBoards()
+{
+  int32_t slot;
+
+  emuLock();
+  for(slot = 0; slot <= MAX_VME_SLOTS; slot++)
+    {
+      if(emu.board[slot])
+	{
+	  free(emu.board[slot]->words);
+	  free(emu.board[slot]->tmpl);
+	  free(emu.board[slot]);
+	  emu.board[slot] = NULL;
+	}
+    }
+  emu.nboards = 0;
+  emu.cblt_pos = -1;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Return the number of emulated boards
+ */
+int32_t
+c1725EmuNBoards()
+{
+  return emu.nboards;
+}
+
+/**
+ * @brief Set the rate of triggers delivered to all armed boards
+ * @param[in] rate_hz Trigger rate in Hz (0: only c1725EmuTrigger/software triggers)
+ * @return OK if successful, ERROR otherwise.
+ */
+int32_t
+c1725EmuSetTriggerRate(double rate_hz)
+{
+  uint64_t now;
+
+  if(rate_hz < 0)
+    return ERROR;
+
+  emuLock();
+  emuDefaults();
+  now = emuNow();
+  if(emu.rate > 0)
+    emu.rate_base += (uint64_t) ((double) (now - emu.rate_t0) * 1e-9 * emu.rate);
+  emu.rate_t0 = now;
+  emu.rate = rate_hz;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Deliver triggers to all armed boards
+ * @param[in] ntrig Number of triggers
+ * @return OK
+ */
+int32_t
+c1725EmuTrigger(uint32_t ntrig)
+{
+  emuLock();
+  emuDefaults();
+  emu.manual += ntrig;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Set the modeled DMA bandwidth
+ * @param[in] mbps MB/s (0: transfers complete immediately)
+ * @return OK
+ */
+int32_t
+c1725EmuSetDMARate(double mbps)
+{
+  emuLock();
+  emuDefaults();
+  emu.dma_mbps = (mbps < 0) ? 0 : mbps;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Set the modeled VME single cycle access time
+ * @param[in] ns nanoseconds per read or write
+ * @return OK
+ */
+int32_t
+c1725EmuSetSCTTime(uint32_t ns)
+{
+  emuLock();
+  emuDefaults();
+  emu.sct_ns = ns;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Set the modeled CPU time to program a DMA transfer
+ * @param[in] ns nanoseconds per vmeDmaSend
+ * @return OK
+ */
+int32_t
+c1725EmuSetDMASetupTime(uint32_t ns)
+{
+  emuLock();
+  emuDefaults();
+  emu.dma_setup_ns = ns;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Set the number of channel status reads that report SPI busy after a DAC write
+ * @param[in] nreads Number of reads
+ * @return OK
+ */
+int32_t
+c1725EmuSetSPIBusyReads(uint32_t nreads)
+{
+  emuLock();
+  emuDefaults();
+  emu.spi_reads = nreads;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Set how long a channel reports SPI busy after a DAC write
+ * @param[in] ns Busy time, 0 for none
+ * @return OK
+ */
+int32_t
+c1725EmuSetSPIBusyTime(uint32_t ns)
+{
+  emuLock();
+  emuDefaults();
+  emu.spi_ns = ns;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Get the emulator access statistics
+ * @param[out] stats Statistics
+ * @return OK
+ */
+int32_t
+c1725EmuGetStats(c1725EmuStats_t *stats)
+{
+  emuLock();
+  emu.stats.triggers = emuCrateTriggers();
+  *stats = emu.stats;
+  emuUnlock();
+
+  return OK;
+}
+
+/**
+ * @brief Reset the emulator access statistics
+ * @return OK
+ */
+int32_t
+c1725EmuResetStats()
+{
+  emuLock();
+  memset(&emu.stats, 0, sizeof(emu.stats));
+  emuUnlock();
+
+  return OK;
+}
@@ -0,0 +1,69 @@
+#pragma once
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      c1725Emu.h
+ * @brief     Software emulator of the CAEN 1725 (DPP-DAW) register map.
+ *
+ *            The emulator backs the c1725_address layout with an in-memory
+ *            model and is reached through the stand-in jvme library
+ *            (jvme.h in this directory).  Programs built against it run the
+ *            caen1725 library unmodified.
+ *
+ *            Boards may be added with c1725EmuAddBoard(), or from the
+ *            environment when the first VME window is opened:
+ *              C1725EMU_SLOTS     comma separated list of slots or ranges,
+ *                                 e.g. "3,5-10" (default "3")
+ *              C1725EMU_RATE      crate trigger rate in Hz while armed (default 0)
+ *              C1725EMU_DMA_MBPS  modeled DMA bandwidth in MB/s (0: instant)
+ *              C1725EMU_DMA_SETUP_NS  modeled CPU time to program each DMA, in ns
+ *              C1725EMU_SCT_NS    modeled single-cycle access time in ns
+ *              C1725EMU_SPI_BUSY  status reads a DAC write keeps SPI busy (default 2)
+ *              C1725EMU_SPI_BUSY_NS  time a DAC write keeps SPI busy, in ns (default 0)
+ *              C1725EMU_IRQ_US    interval at which board interrupts are
+ *                                 checked, in microseconds (default 10)
+ *              C1725EMU_VERBOSE   print emulator activity
+ *
+ */
+#include <stdint.h>
+#include "caen1725Lib.h"
+
+/** Maximum number of events the emulated output buffer holds */
+#define C1725EMU_MAX_EVENTS   1023
+
+typedef struct
+{
+  uint64_t sct_reads;		/* single cycle reads */
+  uint64_t sct_writes;		/* single cycle writes */
+  uint64_t dma_transfers;	/* vmeDmaSend calls */
+  uint64_t dma_bytes;		/* bytes delivered by DMA */
+  uint64_t berr;		/* transfers terminated with BERR */
+  uint64_t triggers;		/* triggers delivered to the crate */
+  uint64_t events_lost;		/* events dropped on a full output buffer */
+  uint64_t irqs;		/* interrupts delivered */
+} c1725EmuStats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t c1725EmuAddBoard(int32_t slot);
+int32_t c1725EmuRemoveAllBoards();
+int32_t c1725EmuNBoards();
+
+int32_t c1725EmuSetTriggerRate(double rate_hz);
+int32_t c1725EmuTrigger(uint32_t ntrig);
+int32_t c1725EmuSetDMARate(double mbps);
+int32_t c1725EmuSetSCTTime(uint32_t ns);
+int32_t c1725EmuSetDMASetupTime(uint32_t ns);
+int32_t c1725EmuSetSPIBusyReads(uint32_t nreads);
+int32_t c1725EmuSetSPIBusyTime(uint32_t ns);
+
+int32_t c1725EmuGetStats(c1725EmuStats_t *stats);
+int32_t c1725EmuResetStats();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      c1725EmuPriv.h
+ * @brief     Interface between the jvme stand-in (jvmeEmu.c) and the
+ *            CAEN 1725 board model (c1725Emu.c).  Not installed.
+ *
+ */
+#include <stdint.h>
+
+/** Size of the register space decoded by each board */
+#define C1725EMU_REGSPACE   0x10000
+/** Size of the readout buffer window */
+#define C1725EMU_BLT_SPACE  0x1000
+
+typedef struct emuBoard emuBoard;
+
+/* Model lock; held around every call below */
+void      emuLock();
+void      emuUnlock();
+
+void      emuModelInit();
+emuBoard *emuBoardFromSlot(int32_t slot);
+int32_t   emuMcstPresent(uint32_t mcst);
+
+uint32_t  emuBoardRead(emuBoard *b, uint32_t offset);
+void      emuBoardWrite(emuBoard *b, uint32_t offset, uint32_t val);
+void      emuMcstWrite(uint32_t mcst, uint32_t offset, uint32_t val);
+
+int32_t   emuBoardDma(emuBoard *b, volatile uint32_t *dst, uint32_t maxwords);
+int32_t   emuCbltDma(uint32_t mcst, volatile uint32_t *dst, uint32_t maxwords);
+
+int32_t   emuIrqPending(uint32_t level, uint32_t *vector);
+
+/* Bus timing model */
+uint32_t  emuSCTTime();
+double    emuDMARate();
+uint32_t  emuDMASetupTime();
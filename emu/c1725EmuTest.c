@@ -0,0 +1,752 @@
+/*
+ * File:
+ *    c1725EmuTest.c
+ *
+ * Description:
+ *    Exercise the caen 1725 library readout paths against the emulator
+ *
+ *
+ */
+
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "jvme.h"
+#include "caen1725Lib.h"
+#include "caen1725Config.h"
+#include "c1725Emu.h"
+
+#define DOALL(x) {				\
+    int32_t _ic=0;				\
+    for(_ic = 0; _ic < c1725N(); _ic++)		\
+      {						\
+	x;					\
+      }						\
+  }
+
+#define MAXWORDS  (64 * 1024)
+
+/* Library memory map, to change a module behind the library's back */
+extern volatile c1725_address *c1725p[MAX_VME_SLOTS+1];
+
+static int32_t nfail = 0;
+
+#define EXPECT(_cond, ...) {				\
+    if(!(_cond))					\
+      {							\
+	printf("FAIL %s:%d: ", __func__, __LINE__);	\
+	printf(__VA_ARGS__);				\
+	printf("\n");					\
+	nfail++;					\
+      }							\
+  }
+
+static volatile uint32_t data[MAXWORDS + 2];
+
+static void
+setRecordLength(uint32_t reclen)
+{
+  int32_t ichan;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    DOALL(c1725SetRecordLength(c1725Slot(_ic), ichan, reclen));
+}
+
+/* Check the events in a buffer (VME byte order), return number of events found */
+static int32_t
+checkEvents(volatile uint32_t *buf, int32_t nwords, uint32_t reclen)
+{
+  int32_t iw = 0, nev = 0;
+  uint32_t evsize = C1725_HEADER_NWORDS + C1725_MAX_ADC_CHANNELS *
+    (C1725_CHANNEL_HEADER_NWORDS + (reclen * C1725_RECORD_LENGTH_SAMPLES + 1) / 2);
+
+  while(iw < nwords)
+    {
+      uint32_t word = LSWAP(buf[iw]);
+
+      if((word == C1725_DMA_FILLER_WORD) || (word == C1725_FILLER_WORD))
+	{
+	  iw++;
+	  continue;
+	}
+
+      EXPECT((word & C1725_HEADER_TYPE_MASK) == C1725_HEADER_TYPE_ID,
+	     "word %d: invalid header 0x%08x", iw, word);
+      if((word & C1725_HEADER_TYPE_MASK) != C1725_HEADER_TYPE_ID)
+	return ERROR;
+
+      EXPECT((word & C1725_HEADER_EVENTSIZE_MASK) == evsize,
+	     "word %d: event size %d != %d", iw,
+	     word & C1725_HEADER_EVENTSIZE_MASK, evsize);
+
+      EXPECT(LSWAP(buf[iw + C1725_HEADER_NWORDS]) ==
+	     C1725_CHANNEL_HEADER_NWORDS + (reclen * C1725_RECORD_LENGTH_SAMPLES + 1) / 2,
+	     "word %d: channel size 0x%08x", iw, LSWAP(buf[iw + C1725_HEADER_NWORDS]));
+
+      iw += word & C1725_HEADER_EVENTSIZE_MASK;
+      nev++;
+    }
+
+  return nev;
+}
+
+/* test/daw-test.cfg, with a threshold, a DC offset and a record length of slot 3 changed */
+static void
+writeReloadConfig(const char *filename, uint32_t thres)
+{
+  char buf[8192];
+  size_t n;
+  FILE *in = fopen("../test/daw-test.cfg", "r"), *out = fopen(filename, "w");
+
+  if((in == NULL) || (out == NULL))
+    return;
+
+  while((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    fwrite(buf, 1, n, out);
+  fprintf(out, "TRG_THRESHOLD_CHAN5=%d\nDC_OFFSET_CHAN4=1000\nRECORD_LENGTH_CHAN5=99\n", thres);
+
+  fclose(in);
+  fclose(out);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int32_t stat, ic, id, nwrds, nev;
+  uint32_t scanmask, datascan, reclen = 2;
+  uint32_t transfers, retries, readouts, saved;
+  c1725EmuStats_t stats;
+
+  printf("\n %s\n", argv[0]);
+  printf("----------------------------\n");
+
+  c1725EmuAddBoard(3);
+  c1725EmuAddBoard(4);
+  c1725EmuAddBoard(5);
+
+  stat = vmeOpenDefaultWindows();
+  if(stat != OK)
+    goto CLOSE;
+
+  vmeBusLock();
+
+  c1725Init(3 << 19, 1 << 19, 4);
+  EXPECT(c1725N() == 3, "c1725N() = %d", c1725N());
+  if(c1725N() != 3)
+    goto CLOSE;
+
+  scanmask = c1725SlotMask();
+
+  setRecordLength(reclen);
+  DOALL(c1725SetMaxEventsPerBLT(c1725Slot(_ic), 1));
+  DOALL(c1725SetAcquisitionControl(c1725Slot(_ic), 0, 1, 0, 0, 0, 0));
+
+  /* Block ready */
+  datascan = c1725GBlockReady(scanmask, 10, 1);
+  EXPECT(datascan == 0, "data before trigger, datascan = 0x%x", datascan);
+
+  c1725EmuTrigger(1);
+  datascan = c1725GBlockReady(scanmask, 10, 1);
+  EXPECT(datascan == scanmask, "datascan = 0x%x, scanmask = 0x%x", datascan, scanmask);
+
+  {
+    uint32_t nscans = 0;
+    uint64_t scan_ns = 0;
+
+    datascan = c1725GBlockReadyScan(scanmask, 10, 1, &nscans, &scan_ns);
+    EXPECT((datascan == scanmask) && (nscans == 1),
+	   "batched scan: datascan = 0x%x, nscans = %d", datascan, nscans);
+    datascan = c1725GBlockReadyScan(scanmask, 10, 2, &nscans, &scan_ns);
+    EXPECT((datascan == 0) && (nscans == 10),
+	   "batched scan, not ready: datascan = 0x%x, nscans = %d", datascan, nscans);
+  }
+
+  /* Programmed I/O, through direct access of the readout buffer */
+  id = c1725Slot(0);
+  nwrds = c1725ReadEvent(id, data, MAXWORDS, 0);
+  nev = checkEvents(data, nwrds, reclen);
+  EXPECT(nev == 1, "PIO: nwrds = %d, nev = %d", nwrds, nev);
+
+  /* DMA */
+  vmeDmaConfig(1, 5, 1);
+  id = c1725Slot(1);
+  nwrds = c1725ReadEvent(id, data, MAXWORDS, 1);
+  nev = checkEvents(data, nwrds, reclen);
+  EXPECT(nev == 1, "DMA: nwrds = %d, nev = %d", nwrds, nev);
+
+  /* DMA to an unaligned address inserts a filler */
+  c1725EmuTrigger(1);
+  id = c1725Slot(1);
+  nwrds = c1725ReadEvent(id, &data[1], MAXWORDS, 1);
+  EXPECT(LSWAP(data[1]) == C1725_DMA_FILLER_WORD, "DMA: no filler 0x%08x", LSWAP(data[1]));
+  nev = checkEvents(&data[1], nwrds, reclen);
+  EXPECT(nev == 1, "DMA unaligned: nwrds = %d, nev = %d", nwrds, nev);
+
+  /* Words per block from the record length */
+  {
+    uint32_t maxwords = 0, expwords = 0, evsize = C1725_HEADER_NWORDS +
+      C1725_MAX_ADC_CHANNELS * (C1725_CHANNEL_HEADER_NWORDS + reclen * C1725_RECORD_LENGTH_SAMPLES / 2);
+
+    c1725GBlockWords(1, &maxwords, &expwords);
+    EXPECT((expwords == 3 * evsize) && (maxwords > expwords),
+	   "block words: expected %d, max %d, event size %d", expwords, maxwords, evsize);
+  }
+
+  /* CBLT, one event per board per block transfer */
+  c1725SetMulticast(0x09000000);
+  vmeDmaConfig(2, 5, 1);
+  /* slot 3 has 2, slot 4 has 1, slot 5 has 3 events stored */
+  c1725EmuTrigger(1);
+  nev = 0;
+  for(ic = 0; ic < 3; ic++)
+    {
+      nwrds = c1725CBLTReadBlock(data, MAXWORDS, 1);
+      stat = checkEvents(data, nwrds, reclen);
+      if(stat > 0)
+	nev += stat;
+    }
+  EXPECT(nev == 6, "CBLT: nev = %d", nev);
+  DOALL(c1725GetEvStored(c1725Slot(_ic), &datascan); EXPECT(datascan == 0,
+							    "%d: evstored = %d",
+							    c1725Slot(_ic), datascan));
+
+  /* CBLT started and completed separately, nested calls refused.  The modules
+     can be used in between, but not what takes the DMA lock */
+  {
+    int32_t nested, nestedev, again, get, gset, gstats;
+    uint32_t transfers, retries;
+
+    c1725EmuTrigger(1);
+    stat = c1725CBLTReadStart(data, MAXWORDS);
+    nested = c1725CBLTReadStart(data, MAXWORDS);
+    nestedev = c1725ReadEvent(c1725Slot(0), data, MAXWORDS, 1);
+    get = c1725GetEvStored(c1725Slot(2), &datascan);
+    gset = c1725GClear();
+    gstats = c1725GetDMAStats(&transfers, &retries);
+    nwrds = c1725ReadComplete();
+    again = c1725ReadComplete();
+    nev = checkEvents(data, nwrds, reclen);
+    EXPECT((stat == OK) && (nested == ERROR) && (nestedev == ERROR) && (again == ERROR) &&
+	   (get == OK) && (gset == ERROR) && (gstats == ERROR) && (nev == 3),
+	   "CBLT start/complete: stat %d, nested %d %d, get %d, c1725G* %d %d, again %d, nev = %d",
+	   stat, nested, nestedev, get, gset, gstats, again, nev);
+  }
+
+  /* Events larger than the readout window need multiple DMAs */
+  reclen = 20;
+  setRecordLength(reclen);
+  c1725EmuTrigger(1);
+  id = c1725Slot(2);
+  vmeDmaConfig(1, 5, 1);
+  nwrds = c1725ReadEvent(id, data, MAXWORDS, 1);
+  nev = checkEvents(data, nwrds, reclen);
+  EXPECT(nev == 1, "DMA chunked: nwrds = %d, nev = %d", nwrds, nev);
+
+  /* ...unless the extended block transfer space is enabled */
+  c1725SetReadoutControl(id, 0, 0, 1, 0, 0, 0, 1);
+  c1725ResetDMAStats();
+  c1725EmuTrigger(1);
+  nwrds = c1725ReadEvent(id, data, MAXWORDS, 1);
+  nev = checkEvents(data, nwrds, reclen);
+  c1725GetDMAStats(&transfers, &retries);
+  c1725GetDMAChunkStats(&readouts, &saved);
+  EXPECT((nev == 1) && (transfers == 1) && (saved > 0),
+	 "DMA extended: nwrds = %d, nev = %d, transfers = %d, saved = %d",
+	 nwrds, nev, transfers, saved);
+
+  /* More than a block stored is ready too */
+  {
+    uint32_t scanready;
+
+    c1725EmuTrigger(2);
+    datascan = c1725GBlockReady(scanmask, 10, 1);
+    scanready = c1725GBlockReadyScan(scanmask, 10, 1, NULL, NULL);
+    EXPECT((datascan == scanmask) && (scanready == scanmask),
+	   "block ready past blocklevel: datascan = 0x%x, 0x%x", datascan, scanready);
+  }
+
+  /* Readout counters, from block ready to the DMA of one board */
+  {
+    c1725Counters_t cnt;
+
+    /* Start with no events stored */
+    DOALL(while((c1725GetEvStored(c1725Slot(_ic), &datascan) == OK) && (datascan > 0))
+	    c1725ReadEvent(c1725Slot(_ic), data, MAXWORDS, 0));
+    c1725ResetCounters();
+    c1725EmuTrigger(1);
+    datascan = c1725GBlockReady(scanmask, 10, 1);
+    datascan = c1725GBlockReady(scanmask, 10, 2);
+    id = c1725Slot(0);
+    nwrds = c1725ReadEvent(id, data, MAXWORDS, 1);
+    c1725CountersSnapshot(id, &cnt);
+    EXPECT((cnt.events == 1) && (cnt.words == nwrds) && (cnt.scan_polls == 11) &&
+	   (cnt.scan_timeouts == 1) && (cnt.dma_calls == cnt.dma_retries + 1) &&
+	   (cnt.dma_retries > 0) && (cnt.berr_terms == 1) && (cnt.zero_words == 0) &&
+	   (cnt.lock_waits == 0),
+	   "counters: events %d, words %d/%d, polls %d, timeouts %d, DMAs %d, retries %d, berr %d",
+	   (int32_t) cnt.events, (int32_t) cnt.words, nwrds, (int32_t) cnt.scan_polls,
+	   (int32_t) cnt.scan_timeouts, (int32_t) cnt.dma_calls, (int32_t) cnt.dma_retries,
+	   (int32_t) cnt.berr_terms);
+
+    /* Counted per board in a CBLT */
+    DOALL(while((c1725GetEvStored(c1725Slot(_ic), &datascan) == OK) && (datascan > 0))
+	    c1725ReadEvent(c1725Slot(_ic), data, MAXWORDS, 0));
+    c1725ResetCounters();
+    c1725EmuTrigger(1);
+    nwrds = c1725CBLTReadBlock(data, MAXWORDS, 1);
+    nev = 0;
+    DOALL(c1725CountersSnapshot(c1725Slot(_ic), &cnt); nev += cnt.events);
+    c1725CountersSnapshot(c1725Slot(1), &cnt);
+    EXPECT((nev == 3) && (cnt.events == 1) && (cnt.dma_calls == 0),
+	   "CBLT counters: events %d, slot %d events %d", nev, c1725Slot(1),
+	   (int32_t) cnt.events);
+  }
+
+  /* Configuration reads come from the shadow */
+  {
+    uint32_t hits0, hits1, misses, mismatch, val = 0, major, minor, date;
+    c1725EmuStats_t s0, s1;
+
+    id = c1725Slot(0);
+    c1725GetShadowStats(id, &hits0, &misses, &mismatch);
+    c1725EmuGetStats(&s0);
+    c1725GetRecordLength(id, 3, &val);
+    c1725EmuGetStats(&s1);
+    c1725GetShadowStats(id, &hits1, &misses, &mismatch);
+    EXPECT((val == reclen) && (s1.sct_reads == s0.sct_reads) && (hits1 == hits0 + 1),
+	   "shadow: reclen %d, sct_reads %d, hits %d", val,
+	   (int32_t) (s1.sct_reads - s0.sct_reads), hits1 - hits0);
+
+    stat = c1725ShadowCheck(id, 1);
+    EXPECT(stat == 0, "shadow check: %d registers differ", stat);
+
+    c1725ShadowRefresh(id);
+    c1725SetShadowMode(C1725_SHADOW_CHECK);
+    c1725EmuGetStats(&s0);
+    c1725GetRecordLength(id, 3, &val);
+    c1725EmuGetStats(&s1);
+    EXPECT(s1.sct_reads == s0.sct_reads + 1, "shadow check mode: sct_reads %d",
+	   (int32_t) (s1.sct_reads - s0.sct_reads));
+    c1725GetShadowStats(id, &hits1, &misses, &mismatch);
+    EXPECT(mismatch == 0, "shadow: %d mismatches", mismatch);
+    c1725SetShadowMode(C1725_SHADOW_ENABLE);
+
+    /* Kept by a data clear, cleared on request, and never holding read only registers */
+    c1725Clear(id);
+    c1725EmuGetStats(&s0);
+    c1725GetRecordLength(id, 3, &val);
+    c1725EmuGetStats(&s1);
+    EXPECT((val == reclen) && (s1.sct_reads == s0.sct_reads),
+	   "shadow after data clear: sct_reads %d", (int32_t) (s1.sct_reads - s0.sct_reads));
+    c1725ShadowInvalidate(id);
+    c1725EmuGetStats(&s0);
+    c1725GetRecordLength(id, 3, &val);
+    c1725GetRecordLength(id, 3, &val);
+    c1725GetROCFimwareRevision(id, &major, &minor, &date);
+    c1725GetROCFimwareRevision(id, &major, &minor, &date);
+    c1725EmuGetStats(&s1);
+    EXPECT((val == reclen) && (s1.sct_reads - s0.sct_reads == 1 + 2),
+	   "shadow after clear: sct_reads %d", (int32_t) (s1.sct_reads - s0.sct_reads));
+  }
+
+  /* Channel block: shared values through the all channel registers */
+  {
+    c1725ChannelConfig_t cfg[C1725_MAX_ADC_CHANNELS];
+    uint32_t thres0 = 0, thres5 = 0, ichan, writes, skipped0, skipped1;
+    c1725EmuStats_t s0, s1, s2, s3;
+
+    memset(cfg, 0, sizeof(cfg));
+    for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+      {
+	cfg[ichan].record_length = reclen;
+	cfg[ichan].input_delay = 8;
+	cfg[ichan].trigger_threshold = (ichan == 5) ? 200 : 100;
+	cfg[ichan].maximum_tail = 10;
+	cfg[ichan].self_trigger_enable = 1;
+	cfg[ichan].dc_offset = 0x8000 + ichan;
+      }
+
+    id = c1725Slot(1);
+    c1725EmuGetStats(&s0);
+    stat = c1725SetChannelBlock(id, 0xFFFF, cfg);
+    c1725EmuGetStats(&s1);
+    stat |= c1725SetChannelBlock(id, 0xFFFF, cfg);
+    c1725EmuGetStats(&s2);
+    /* Only what changed, and the skipped writes counted */
+    c1725GetWriteStats(id, &writes, &skipped0);
+    c1725SetWriteMode(C1725_WRITE_CHANGED);
+    stat |= c1725SetChannelBlock(id, 0xFFFF, cfg);
+    c1725SetWriteMode(C1725_WRITE_ALL);
+    c1725EmuGetStats(&s3);
+    c1725GetWriteStats(id, &writes, &skipped1);
+    c1725GetTriggerThreshold(id, 0, &thres0);
+    c1725GetTriggerThreshold(id, 5, &thres5);
+    EXPECT((stat == OK) && (s1.sct_writes - s0.sct_writes <= 9 + 1 + 16) &&
+	   (s2.sct_writes - s1.sct_writes == s1.sct_writes - s0.sct_writes) &&
+	   (s3.sct_writes == s2.sct_writes) && (skipped1 - skipped0 == 9 * 16) &&
+	   (thres0 == 100) && (thres5 == 200),
+	   "channel block: writes %d, %d then %d (%d skipped), thresholds %d %d",
+	   (int32_t) (s1.sct_writes - s0.sct_writes),
+	   (int32_t) (s2.sct_writes - s1.sct_writes),
+	   (int32_t) (s3.sct_writes - s2.sct_writes), skipped1 - skipped0, thres0, thres5);
+
+    c1725ShadowRefresh(id);
+    stat = c1725ShadowCheck(id, 1);
+    EXPECT(stat == 0, "channel block: %d registers differ", stat);
+
+    /* Read back against the settings, after one register is changed behind them */
+    {
+      c1725Readback_t regs[C1725_CHANBLOCK_NREG * C1725_MAX_ADC_CHANNELS];
+      int32_t nregs, nbad0, nbad1, ir;
+
+      nregs = c1725ChannelBlockReadback(0xFFFF, cfg, regs, C1725_CHANBLOCK_NREG * C1725_MAX_ADC_CHANNELS);
+      nbad0 = c1725Readback(id, regs, nregs);
+      c1725SetTriggerThreshold(id, 3, 111);
+      nbad1 = c1725Readback(id, regs, nregs);
+      for(ir = 0; ir < nregs; ir++)
+	if(regs[ir].offset == 0x1360)
+	  break;
+      EXPECT((nregs > 0) && (nbad0 == 0) && (nbad1 == 1) && (ir < nregs) &&
+	     (regs[ir].readback == 111) && (regs[ir].expected == 100),
+	     "readback: %d registers, %d then %d differ", nregs, nbad0, nbad1);
+      c1725SetTriggerThreshold(id, 3, 100);
+    }
+  }
+
+  /* Only changed registers are written; a dry run writes nothing */
+  {
+    c1725EmuStats_t s0, s1, s2;
+    uint32_t thres = 0, writes, skipped;
+
+    id = c1725Slot(2);
+    c1725SetWriteMode(C1725_WRITE_CHANGED);
+    c1725EmuGetStats(&s0);
+    c1725SetTriggerThreshold(id, 4, 77);
+    c1725SetTriggerThreshold(id, 4, 77);
+    c1725EmuGetStats(&s1);
+    c1725SetWriteMode(C1725_WRITE_DRYRUN);
+    c1725SetTriggerThreshold(id, 4, 88);
+    c1725EmuGetStats(&s2);
+    c1725SetWriteMode(C1725_WRITE_ALL);
+    c1725GetTriggerThreshold(id, 4, &thres);
+    c1725GetWriteStats(id, &writes, &skipped);
+    EXPECT((s1.sct_writes - s0.sct_writes == 1) && (s2.sct_writes == s1.sct_writes) &&
+	   (thres == 77) && (skipped > 0),
+	   "write mode: writes %d then %d, thres %d, skipped %d",
+	   (int32_t) (s1.sct_writes - s0.sct_writes),
+	   (int32_t) (s2.sct_writes - s1.sct_writes), thres, skipped);
+  }
+
+  /* DC offsets loaded in the background, boards interleaved */
+  {
+    uint32_t offset[C1725_MAX_ADC_CHANNELS], pending = 0, failed = 0, val = 0, nbad = 0, ichan;
+
+    c1725EmuSetSPIBusyTime(20000);
+    for(ic = 0; ic < c1725N(); ic++)
+      {
+	for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	  offset[ichan] = 0x1000 * ic + ichan;
+	c1725DACLoadQueue(c1725Slot(ic), 0xFFFF, offset);
+      }
+    stat = c1725DACLoadStart(1000000);
+    stat |= c1725DACLoadWait(2000000);
+    c1725EmuSetSPIBusyTime(0);
+
+    for(ic = 0; ic < c1725N(); ic++)
+      {
+	id = c1725Slot(ic);
+	c1725DACLoadStatus(id, &pending, &failed);
+	for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	  {
+	    c1725GetDCOffset(id, ichan, &val);
+	    if(val != 0x1000 * ic + ichan)
+	      nbad++;
+	  }
+	nbad += (pending != 0) + (failed != 0);
+      }
+    EXPECT((stat == OK) && (nbad == 0), "DAC load: stat %d, %d errors", stat, nbad);
+  }
+
+  /* ADC calibration of the whole crate, every channel checked */
+  {
+    uint32_t done[MAX_VME_SLOTS + 1], nbad = 0;
+
+    stat = c1725GADCCalibrationStart();
+    c1725ADCCalibrationStatus(c1725Slot(0), &done[0]);
+    stat |= c1725GADCCalibrationWait(100000, done);
+    for(ic = 0; ic < c1725N(); ic++)
+      nbad += (done[c1725Slot(ic)] != 0xFFFF);
+    stat |= c1725ADCCalibration(c1725Slot(1));
+    EXPECT((stat == OK) && (nbad == 0), "ADC calibration: stat %d, %d boards not done",
+	   stat, nbad);
+  }
+
+  /* Interrupt driven block ready */
+  DOALL(c1725Clear(c1725Slot(_ic)));
+  stat = c1725IntConnect(0, 0, 1);
+  EXPECT(stat == OK, "c1725IntConnect = %d", stat);
+  if(stat == OK)
+    {
+      uint32_t level, oint, berr, a64, reloc, roak, ext;
+
+      /* A configuration download leaves the interrupt level alone */
+      id = c1725Slot(0);
+      c1725SetReadoutControl(id, 0, 0, 1, 0, 0, 1, 0);
+      c1725GetReadoutControl(id, &level, &oint, &berr, &a64, &reloc, &roak, &ext);
+      EXPECT(level == 5, "IRQ: level %d after c1725SetReadoutControl", level);
+
+      datascan = c1725WaitBlockReady(scanmask, 1, 2000);
+      EXPECT(datascan == 0, "IRQ: data before trigger, datascan = 0x%x", datascan);
+
+      c1725EmuSetTriggerRate(500);
+      datascan = c1725WaitBlockReady(scanmask, 1, 200000);
+      c1725EmuSetTriggerRate(0);
+      EXPECT((datascan == scanmask) && (c1725GetIntCount() > 0),
+	     "IRQ: datascan = 0x%x, scanmask = 0x%x, interrupts = %d",
+	     datascan, scanmask, c1725GetIntCount());
+
+      c1725IntDisconnect();
+      DOALL(c1725Clear(c1725Slot(_ic)));
+    }
+
+  /* Multicast writes reach every board in one cycle */
+  {
+    c1725EmuStats_t s0, s1;
+    uint32_t thres = 0, nbad = 0, mode, arm, clk, busy, veto, runin;
+
+    c1725EmuGetStats(&s0);
+    stat = c1725GSetTriggerThreshold(-1, 300);
+    stat |= c1725GSetAcquisitionControl(0, 0, 0, 0, 0, 0);
+    c1725EmuGetStats(&s1);
+    for(ic = 0; ic < c1725N(); ic++)
+      {
+	id = c1725Slot(ic);
+	c1725GetTriggerThreshold(id, 9, &thres);
+	c1725SetShadowMode(C1725_SHADOW_DISABLE);
+	c1725GetAcquisitionControl(id, &mode, &arm, &clk, &busy, &veto, &runin);
+	c1725SetShadowMode(C1725_SHADOW_ENABLE);
+	if((thres != 300) || arm || (c1725ShadowCheck(id, 1) != 0))
+	  nbad++;
+      }
+    EXPECT((stat == OK) && (s1.sct_writes - s0.sct_writes == 2) && (nbad == 0),
+	   "MCST: writes %d, %d boards differ", (int32_t) (s1.sct_writes - s0.sct_writes), nbad);
+  }
+
+  /* The configuration read back from every board */
+  {
+    caen1725mismatch_t report[4];
+    int32_t nbad0, nbad1;
+
+    caen1725ConfigInitGlobals();
+    caen1725ConfigSetCache(0, NULL);
+    stat = caen1725Config("../test/daw-test.cfg");
+    nbad0 = caen1725ConfigVerify(report, 4);
+    c1725SetTriggerThreshold(3, 11, 1234);
+    nbad1 = caen1725ConfigVerify(report, 4);
+    EXPECT((stat == 0) && (nbad0 == 0) && (nbad1 == 1) && (report[0].slot == 3) &&
+	   (report[0].chan == 11) && (report[0].expected == 333) && (report[0].readback == 1234),
+	   "verify: stat %d, %d then %d registers differ", stat, nbad0, nbad1);
+
+    /* Rewritten from the configuration, also after a change behind the library
+       that only a new Init sees */
+    stat = caen1725ConfigRestore();
+    nbad0 = caen1725ConfigVerify(report, 4);
+    vmeWrite32(&c1725p[3]->chan[11].trigger_threshold, 1235);
+    c1725Init(3 << 19, 1 << 19, 4);
+    stat |= caen1725ConfigRestore();
+    nbad1 = caen1725ConfigVerify(report, 4);
+    EXPECT((stat == 0) && (nbad0 == 0) && (nbad1 == 0),
+	   "restore: stat %d, %d then %d registers differ", stat, nbad0, nbad1);
+
+    /* Thresholds and offsets changed in the file during a run */
+    {
+      const char *reloadfile = "c1725EmuReload.cfg";
+      uint32_t thres = 0, offset = 0, reclen5 = 0, reclen4 = 0, iwait;
+      c1725EmuStats_t s0, s1;
+
+      c1725GetRecordLength(3, 4, &reclen4);
+      writeReloadConfig(reloadfile, 444);
+      c1725GSetAcquisitionControl(0, 1, 0, 0, 0, 0);
+      stat = caen1725ConfigReload(reloadfile);
+      c1725EmuGetStats(&s0);
+      stat |= caen1725ConfigReload(reloadfile);
+      c1725EmuGetStats(&s1);
+      c1725SetShadowMode(C1725_SHADOW_DISABLE);
+      c1725GetTriggerThreshold(3, 5, &thres);
+      c1725GetDCOffset(3, 4, &offset);
+      c1725GetRecordLength(3, 5, &reclen5);
+      c1725SetShadowMode(C1725_SHADOW_ENABLE);
+      EXPECT((stat == 0) && (thres == 444) && (offset == 1000) && (reclen5 == reclen4) &&
+	     (s1.sct_writes == s0.sct_writes) && (caen1725ConfigVerify(NULL, 0) == 0),
+	     "reload: stat %d, threshold %d, offset %d, record length %d (%d), writes %d",
+	     stat, thres, offset, reclen5, reclen4, (int32_t) (s1.sct_writes - s0.sct_writes));
+
+      stat = caen1725ConfigWatch(reloadfile, 10);
+      writeReloadConfig(reloadfile, 555);
+      for(iwait = 0; iwait < 100; iwait++)
+	{
+	  usleep(10000);
+	  c1725GetTriggerThreshold(3, 5, &thres);
+	  if(thres == 555)
+	    break;
+	}
+      stat |= caen1725ConfigWatch(NULL, 0);
+      c1725GSetAcquisitionControl(0, 0, 0, 0, 0, 0);
+      EXPECT((stat == 0) && (thres == 555), "watch: stat %d, threshold %d", stat, thres);
+      remove(reloadfile);
+    }
+    caen1725ConfigFree();
+  }
+
+  /* A crate file that includes a shared base file, and CRATE sections */
+  {
+    const char *basefile = "c1725EmuBase.cfg", *cratefile = "c1725EmuCrate.cfg",
+      *cachefile = "c1725EmuCrate.cache";
+    uint32_t thres[4] = {0, 0, 0, 0};
+    FILE *f;
+
+    f = fopen(basefile, "w");
+    fprintf(f, "[ALLSLOTS]\nTRG_THRESHOLD=10\n[SLOT 4]\nTRG_THRESHOLD=20\n"
+	    "[CRATE emucrate]\nTRG_THRESHOLD=30\n");
+    fclose(f);
+    f = fopen(cratefile, "w");
+    fprintf(f, "INCLUDE=%s\n[SLOT 4]\nTRG_THRESHOLD_CHAN1=40\n[CRATE other SLOT 5]\n"
+	    "TRG_THRESHOLD=99\n[CRATE emucrate SLOT 5]\nTRG_THRESHOLD=50\n", basefile);
+    fclose(f);
+
+    caen1725ConfigInitGlobals();
+    caen1725ConfigSetCrate("emucrate");
+    caen1725ConfigSetCache(1, cachefile);
+    stat = caen1725Config(cratefile);
+    c1725GetTriggerThreshold(3, 0, &thres[0]);
+    c1725GetTriggerThreshold(4, 0, &thres[1]);
+    c1725GetTriggerThreshold(4, 1, &thres[2]);
+    c1725GetTriggerThreshold(5, 0, &thres[3]);
+    EXPECT((stat == 0) && (thres[0] == 30) && (thres[1] == 20) && (thres[2] == 40) &&
+	   (thres[3] == 50), "layers: stat %d, thresholds %d %d %d %d",
+	   stat, thres[0], thres[1], thres[2], thres[3]);
+
+    /* The cache is rebuilt when the included file changes */
+    f = fopen(basefile, "w");
+    fprintf(f, "[ALLSLOTS]\nTRG_THRESHOLD=10\n[CRATE emucrate]\nTRG_THRESHOLD=31\n");
+    fclose(f);
+    caen1725ConfigInitGlobals();
+    stat = caen1725Config(cratefile);
+    c1725GetTriggerThreshold(3, 0, &thres[0]);
+    EXPECT((stat == 0) && (thres[0] == 31), "layers cache: stat %d, threshold %d",
+	   stat, thres[0]);
+
+    caen1725ConfigFree();
+    caen1725ConfigSetCrate(NULL);
+    caen1725ConfigSetCache(0, NULL);
+    remove(basefile);
+    remove(cratefile);
+    remove(cachefile);
+  }
+
+  /* Board settings from the file, and values out of range */
+  {
+    const char *boardfile = "c1725EmuBoard.cfg";
+    uint32_t chmask = 0, window = 0, majority = 0, lvds = 0, ext = 1, sw = 0,
+      maxev = 0, delay3 = 1, delay4 = 0;
+    int32_t nbad, stat2;
+    FILE *f;
+
+    f = fopen(boardfile, "w");
+    fprintf(f, "[ALLSLOTS]\nEXTERNAL_TRIGGER=DISABLED\nFPIO_LEVEL=ttl\nGLOBAL_TRG_MAJORITY=2\n"
+	    "GLOBAL_TRG_COINC_WINDOW=3\nMAX_EVENTS_PER_BLT=8\n[SLOT 4]\nRUN_DELAY=5\n");
+    fclose(f);
+
+    caen1725ConfigInitGlobals();
+    stat = caen1725Config(boardfile);
+    nbad = caen1725ConfigVerify(NULL, 0);
+    c1725GetGlobalTrigger(3, &chmask, &window, &majority, &lvds, &ext, &sw);
+    c1725GetMaxEventsPerBLT(3, &maxev);
+    c1725GetRunDelay(3, &delay3);
+    c1725GetRunDelay(4, &delay4);
+    EXPECT((stat == 0) && (nbad == 0) && (window == 3) && (majority == 2) && (ext == 0) &&
+	   (sw == 1) && (maxev == 8) && (delay3 == 0) && (delay4 == 5),
+	   "board: stat %d, %d differ, window %d, majority %d, ext %d, %d events per BLT,"
+	   " run delay %d %d", stat, nbad, window, majority, ext, maxev, delay3, delay4);
+
+    f = fopen(boardfile, "w");
+    fprintf(f, "[ALLSLOTS]\nMAX_EVENTS_PER_BLT=1\nGLOBAL_TRG_MAJORITY=9\n"
+	    "[SLOT 4]\nMONITOR_MODE=2\nEXTERNAL_TRIGGER=YES\n");
+    fclose(f);
+
+    caen1725ConfigInitGlobals();
+    stat = caen1725Config(boardfile);
+    stat2 = caen1725ConfigReload(boardfile);
+    c1725GetMaxEventsPerBLT(3, &maxev);
+    EXPECT((stat == 1) && (stat2 == 1) && (maxev == 8),
+	   "board range: stat %d, reload %d, %d events per BLT", stat, stat2, maxev);
+
+    caen1725ConfigFree();
+    remove(boardfile);
+  }
+
+  /* Status snapshot, and its JSON and binary forms */
+  {
+    static c1725Status_t st0, st1, st2;
+    static uint8_t packed[sizeof(c1725Status_t) + 64];
+    static char json[65536];
+    c1725EmuStats_t s0, s1;
+    int32_t npacked, njson;
+
+    c1725GSetAcquisitionControl(0, 1, 0, 0, 0, 0);
+    c1725EmuTrigger(2);
+    stat = c1725GStatusSnapshot(&st0);
+    c1725EmuGetStats(&s0);
+    stat |= c1725GStatusSnapshot(&st1);
+    c1725EmuGetStats(&s1);
+    EXPECT((stat == OK) && (st1.nboards == 3) && (st1.board[1].slot == 4) &&
+	   (st1.board[1].running == 1) && (st1.board[1].event_stored == 2) &&
+	   (st1.board[1].run_delay == 5) &&
+	   (memcmp(st0.board, st1.board, sizeof(st1.board)) == 0) &&
+	   (s1.sct_reads - s0.sct_reads == 3 * (6 + 2 * C1725_MAX_ADC_CHANNELS)),
+	   "snapshot: stat %d, %d boards, slot %d, %d events, %d reads",
+	   stat, st1.nboards, st1.board[1].slot, st1.board[1].event_stored,
+	   (int32_t) (s1.sct_reads - s0.sct_reads));
+
+    npacked = c1725StatusSnapshotPack(&st1, packed, sizeof(packed));
+    stat = c1725StatusSnapshotUnpack(packed, npacked, &st2);
+    njson = c1725StatusSnapshotJSON(&st1, json, sizeof(json));
+    EXPECT((npacked < (int32_t) sizeof(c1725Status_t)) && (stat == OK) &&
+	   (memcmp(&st1, &st2, sizeof(st1)) == 0) && (njson == (int32_t) strlen(json)) &&
+	   (strstr(json, "{\"slot\":4,") != NULL) && (strstr(json, "\"event_stored\":2,") != NULL) &&
+	   (c1725StatusSnapshotJSON(&st1, json, 64) == ERROR) &&
+	   (c1725StatusSnapshotUnpack(packed, npacked - 4, &st2) == ERROR),
+	   "snapshot forms: %d bytes packed, unpack %d, %d bytes JSON", npacked, stat, njson);
+
+    c1725GSetAcquisitionControl(0, 0, 0, 0, 0, 0);
+    DOALL(c1725Clear(c1725Slot(_ic)));
+  }
+
+  c1725EmuGetStats(&stats);
+  printf("  sct_reads = %llu  sct_writes = %llu  dma = %llu (%llu bytes)  berr = %llu  irqs = %llu\n",
+	 (unsigned long long) stats.sct_reads, (unsigned long long) stats.sct_writes,
+	 (unsigned long long) stats.dma_transfers, (unsigned long long) stats.dma_bytes,
+	 (unsigned long long) stats.berr, (unsigned long long) stats.irqs);
+
+ CLOSE:
+
+  vmeBusUnlock();
+
+  stat = vmeCloseDefaultWindows();
+  if (stat != OK)
+    {
+      printf("vmeCloseDefaultWindows failed: code 0x%08x\n",stat);
+      return -1;
+    }
+
+  printf("%s: %s\n", argv[0], nfail ? "FAILED" : "PASSED");
+
+  exit(nfail ? 1 : 0);
+}
+/*
+  Local Variables:
+  compile-command: "make -k c1725EmuTest "
+  End:
+*/
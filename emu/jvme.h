@@ -0,0 +1,134 @@
+#pragma once
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      jvme.h
+ * @brief     Stand-in for the JLab VME (jvme) library header, backed by the
+ *            CAEN 1725 software emulator in this directory.
+ *
+ *            Only the subset of the jvme API used by the caen1725 library,
+ *            its test programs and readout lists is provided.  Build against
+ *            it with LINUXVME_INC/LINUXVME_LIB pointing here.
+ *
+ */
+#include <stdint.h>
+
+#ifndef OK
+#define OK     0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/* Byte swapping (VME is big endian) */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LSWAP(x) __builtin_bswap32((uint32_t)(x))
+#define SSWAP(x) __builtin_bswap16((uint16_t)(x))
+#else
+#define LSWAP(x) (x)
+#define SSWAP(x) (x)
+#endif
+
+typedef void (*VOIDFUNCPTR) ();
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int logMsg(const char *format, ...);
+
+/* Windows and address translation */
+int  vmeOpenDefaultWindows();
+int  vmeCloseDefaultWindows();
+int  vmeBusToLocalAdrs(int vmeAdrsSpace, char *vmeBusAdrs, char **pPciAdrs);
+int  vmeLocalToBusAdrs(int vmeAdrsSpace, char *localAdrs, char **pVmeAdrs);
+int  vmeMemProbe(char *addr, int size, char *rval);
+
+/* Single cycle access */
+unsigned char  vmeRead8(volatile unsigned char *addr);
+unsigned short vmeRead16(volatile unsigned short *addr);
+unsigned int   vmeRead32(volatile unsigned int *addr);
+void vmeWrite8(volatile unsigned char *addr, unsigned char val);
+void vmeWrite16(volatile unsigned short *addr, unsigned short val);
+void vmeWrite32(volatile unsigned int *addr, unsigned int val);
+
+/* DMA */
+int  vmeDmaConfig(unsigned int addrType, unsigned int dataType, unsigned int sstMode);
+int  vmeDmaSend(unsigned long locAdrs, unsigned int vmeAdrs, int size);
+int  vmeDmaDone();
+int  vmeDmaFlush(unsigned int addr);
+
+/* Interrupts */
+int  vmeIntConnect(unsigned int vector, unsigned int level, VOIDFUNCPTR routine,
+		   unsigned int arg);
+int  vmeIntDisconnect(unsigned int level);
+
+/* Bus mutex and exceptions */
+int  vmeBusLock();
+int  vmeBusUnlock();
+int  vmeCheckMutexHealth(int sleepTime);
+int  vmeClearException(int pflag);
+
+/* DMA buffer partitions (minimal dmaPList) */
+typedef struct dmanode
+{
+  struct dmanode   *next;
+  struct dmapart   *part;
+  long              length;	/* length of data, in 4 byte words */
+  int               nevent;
+  volatile unsigned int data[1];
+} DMANODE;
+
+typedef struct dmapart
+{
+  char              name[40];
+  int               size;	/* size of each item, in bytes */
+  int               nitems;
+  DMANODE          *free;	/* free list */
+  DMANODE          *head;	/* filled list */
+  DMANODE          *tail;
+  struct dmapart   *next;
+} DMA_MEM_PART;
+
+typedef DMA_MEM_PART *DMA_MEM_ID;
+
+extern DMANODE *the_event;
+extern unsigned int *dma_dabufp;
+
+DMA_MEM_ID dmaPCreate(char *name, int size, int c, int incr);
+void       dmaPFreeAll();
+void       dmaPStatsAll();
+int        dmaPReInitAll();
+DMANODE   *dmaPGetItem(DMA_MEM_ID pPart);
+void       dmaPPutItem(DMA_MEM_ID pPart, DMANODE *pItem);
+void       dmaPFreeItem(DMANODE *pItem);
+
+#define GETEVENT(id, evnum)						\
+  {									\
+    the_event = dmaPGetItem(id);					\
+    if(the_event != NULL)						\
+      {									\
+	dma_dabufp = (unsigned int *) &the_event->data[0];		\
+	the_event->nevent = evnum;					\
+	the_event->length = 0;						\
+      }									\
+  }
+
+#define PUTEVENT(id)							\
+  {									\
+    the_event->length = dma_dabufp - (unsigned int *) &the_event->data[0]; \
+    dmaPPutItem(id, the_event);						\
+  }
+
+#ifdef __cplusplus
+}
+#endif
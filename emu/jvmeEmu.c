@@ -0,0 +1,806 @@
+/**
+ * @copyright Copyright 2022, Jefferson Science Associates, LLC.
+ *            Subject to the terms in the LICENSE file found in the
+ *            top-level directory.
+ *
+ * @file      jvmeEmu.c
+ * @brief     Stand-in for the JLab VME (jvme) library.  VME windows are
+ *            mapped to local memory and accesses to emulated boards are
+ *            routed to the CAEN 1725 model in c1725Emu.c.
+ *
+ *            On x86_64 Linux the windows are mapped without access rights,
+ *            so that direct pointer reads/writes (e.g. programmed I/O from
+ *            readout_buffer) are trapped, emulated and single-stepped.
+ *            Elsewhere only the vmeRead/vmeWrite routines are emulated.
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#if defined(__linux__) && defined(__x86_64__)
+#include <ucontext.h>
+#define EMU_TRAP_ACCESS
+#endif
+#include "jvme.h"
+#include "c1725Emu.h"
+#include "c1725EmuPriv.h"
+
+#define EMU_WINDOW_SIZE  0x01000000  /* A24, CR/CSR and each 16MB of A32 */
+#define EMU_MAX_A32      8
+
+typedef struct
+{
+  uint8_t  *base;
+  uint32_t  space;   /* 0: A24, 1: CR/CSR, 2: A32 */
+  uint32_t  vmebase; /* VME address of the start of the window */
+} emuWindow;
+
+static emuWindow emuWin[2 + EMU_MAX_A32];
+static int32_t   emuNWin = 0;
+static int32_t   emuInitDone = 0;
+static pthread_mutex_t emuWinMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t emuBusMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t emuVmeBusLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t  emuBusFree = 0;
+
+static struct
+{
+  int32_t  pending;
+  int32_t  result;
+  uint64_t done_at;
+  uint32_t addrType;
+} emuDma;
+
+/* Interrupt handler, called from a thread that checks the boards */
+static struct
+{
+  int32_t     connected;
+  uint32_t    vector, level, arg;
+  VOIDFUNCPTR routine;
+  uint32_t    period_us;
+  pthread_t   thread;
+  volatile int32_t run;
+} emuIrq;
+
+DMANODE *the_event = NULL;
+unsigned int *dma_dabufp = NULL;
+static DMA_MEM_ID emuPartList = NULL;
+
+static uint64_t
+emuNowNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+emuWaitUntil(uint64_t t)
+{
+  uint64_t now;
+
+  while((now = emuNowNs()) < t)
+    {
+      if((t - now) > 200000)
+	{
+	  struct timespec ts = { 0, (long) (t - now - 100000) };
+	  nanosleep(&ts, NULL);
+	}
+    }
+}
+
+/* Reserve the bus for ns nanoseconds, return the time the access completes */
+static uint64_t
+emuBusReserve(uint64_t ns)
+{
+  uint64_t start, now = emuNowNs();
+
+  pthread_mutex_lock(&emuBusMutex);
+  start = (emuBusFree > now) ? emuBusFree : now;
+  emuBusFree = start + ns;
+  pthread_mutex_unlock(&emuBusMutex);
+
+  return start + ns;
+}
+
+static void
+emuSCTWait()
+{
+  uint32_t ns = emuSCTTime();
+
+  if(ns)
+    emuWaitUntil(emuBusReserve(ns));
+}
+
+/* Find the window containing the local address */
+static emuWindow *
+emuFindWindow(uintptr_t addr)
+{
+  int32_t iw;
+
+  for(iw = 0; iw < emuNWin; iw++)
+    {
+      if((addr >= (uintptr_t) emuWin[iw].base) &&
+	 (addr < (uintptr_t) emuWin[iw].base + EMU_WINDOW_SIZE))
+	return &emuWin[iw];
+    }
+
+  return NULL;
+}
+
+/**
+ * Resolve a local address.
+ * Returns 1 for an emulated board, 2 for a multicast window,
+ * 0 for an empty location within a VME window, -1 for non-VME memory
+ */
+static int32_t
+emuResolve(uintptr_t addr, emuBoard **b, uint32_t *mcst, uint32_t *offset)
+{
+  emuWindow *w = emuFindWindow(addr);
+  uint32_t woff;
+
+  if(w == NULL)
+    return -1;
+
+  woff = addr - (uintptr_t) w->base;
+
+  if(w->space == 2)
+    {
+      *mcst = w->vmebase >> 24;
+      *offset = woff;
+      return ((woff < C1725EMU_REGSPACE) && emuMcstPresent(*mcst)) ? 2 : 0;
+    }
+
+  *b = emuBoardFromSlot(woff >> 19);
+  *offset = woff & 0x7FFFF;
+
+  return ((*b != NULL) && (*offset < C1725EMU_REGSPACE)) ? 1 : 0;
+}
+
+static uint32_t
+emuAccessRead(uintptr_t addr)
+{
+  emuBoard *b = NULL;
+  uint32_t mcst = 0, offset = 0, rval = 0xFFFFFFFF;
+
+  emuLock();
+  if(emuResolve(addr, &b, &mcst, &offset) == 1)
+    rval = emuBoardRead(b, offset & ~0x3);
+  emuUnlock();
+
+  emuSCTWait();
+
+  return rval;
+}
+
+static void
+emuAccessWrite(uintptr_t addr, uint32_t val)
+{
+  emuBoard *b = NULL;
+  uint32_t mcst = 0, offset = 0;
+  int32_t rval;
+
+  emuLock();
+  rval = emuResolve(addr, &b, &mcst, &offset);
+  if(rval == 1)
+    emuBoardWrite(b, offset & ~0x3, val);
+  else if(rval == 2)
+    emuMcstWrite(mcst, offset & ~0x3, val);
+  emuUnlock();
+
+  emuSCTWait();
+}
+
+#ifdef EMU_TRAP_ACCESS
+/*
+ * Direct access to a window faults.  The SIGSEGV handler stages the
+ * emulated value, opens the page and single-steps the access.  The SIGTRAP
+ * handler then forwards any written value and closes the page again.
+ */
+static __thread struct
+{
+  int32_t   active;
+  int32_t   write;
+  uintptr_t addr;
+  uintptr_t page;
+} emuTrap;
+static volatile char emuTrapSpin = 0;
+static long emuPageSize = 4096;
+
+#define EMU_EFLAGS_TF      0x100
+#define EMU_PF_WRITE       0x2
+
+static void
+emuSegvHandler(int sig, siginfo_t *si, void *ctx)
+{
+  ucontext_t *uc = (ucontext_t *) ctx;
+  uintptr_t addr = (uintptr_t) si->si_addr;
+
+  if((emuFindWindow(addr) == NULL) || emuTrap.active)
+    {
+      signal(SIGSEGV, SIG_DFL); /* not ours: fault again with the default action */
+      return;
+    }
+
+  while(__atomic_test_and_set(&emuTrapSpin, __ATOMIC_ACQUIRE))
+    ;
+
+  emuTrap.active = 1;
+  emuTrap.addr = addr & ~0x3;
+  emuTrap.page = addr & ~(emuPageSize - 1);
+  emuTrap.write = (uc->uc_mcontext.gregs[REG_ERR] & EMU_PF_WRITE) ? 1 : 0;
+
+  mprotect((void *) emuTrap.page, emuPageSize, PROT_READ | PROT_WRITE);
+  if(!emuTrap.write)
+    *(volatile uint32_t *) emuTrap.addr = LSWAP(emuAccessRead(emuTrap.addr));
+
+  uc->uc_mcontext.gregs[REG_EFL] |= EMU_EFLAGS_TF;
+}
+
+static void
+emuTrapHandler(int sig, siginfo_t *si, void *ctx)
+{
+  ucontext_t *uc = (ucontext_t *) ctx;
+
+  if(!emuTrap.active)
+    return;
+
+  if(emuTrap.write)
+    emuAccessWrite(emuTrap.addr, LSWAP(*(volatile uint32_t *) emuTrap.addr));
+
+  mprotect((void *) emuTrap.page, emuPageSize, PROT_NONE);
+  uc->uc_mcontext.gregs[REG_EFL] &= ~EMU_EFLAGS_TF;
+  emuTrap.active = 0;
+
+  __atomic_clear(&emuTrapSpin, __ATOMIC_RELEASE);
+}
+#endif /* EMU_TRAP_ACCESS */
+
+static void
+emuInit()
+{
+  pthread_mutex_lock(&emuWinMutex);
+  if(emuInitDone == 0)
+    {
+#ifdef EMU_TRAP_ACCESS
+      struct sigaction sa;
+
+      emuPageSize = sysconf(_SC_PAGESIZE);
+
+      memset(&sa, 0, sizeof(sa));
+      sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+      sigemptyset(&sa.sa_mask);
+      sa.sa_sigaction = emuSegvHandler;
+      sigaction(SIGSEGV, &sa, NULL);
+      sa.sa_sigaction = emuTrapHandler;
+      sigaction(SIGTRAP, &sa, NULL);
+#endif
+      emuLock();
+      emuModelInit();
+      emuUnlock();
+      emuInitDone = 1;
+    }
+  pthread_mutex_unlock(&emuWinMutex);
+}
+
+static emuWindow *
+emuMapWindow(uint32_t space, uint32_t vmebase)
+{
+  emuWindow *w = NULL;
+  int32_t iw, prot = PROT_READ | PROT_WRITE;
+
+#ifdef EMU_TRAP_ACCESS
+  prot = PROT_NONE;
+#endif
+
+  pthread_mutex_lock(&emuWinMutex);
+  for(iw = 0; iw < emuNWin; iw++)
+    {
+      if((emuWin[iw].space == space) && (emuWin[iw].vmebase == vmebase))
+	{
+	  w = &emuWin[iw];
+	  break;
+	}
+    }
+
+  if((w == NULL) && (emuNWin < (int32_t) (sizeof(emuWin) / sizeof(emuWin[0]))))
+    {
+      void *base = mmap(NULL, EMU_WINDOW_SIZE, prot,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if(base != MAP_FAILED)
+	{
+	  w = &emuWin[emuNWin++];
+	  w->base = (uint8_t *) base;
+	  w->space = space;
+	  w->vmebase = vmebase;
+	}
+    }
+  pthread_mutex_unlock(&emuWinMutex);
+
+  return w;
+}
+
+int
+logMsg(const char *format, ...)
+{
+  va_list args;
+  int rval;
+
+  va_start(args, format);
+  rval = vfprintf(stderr, format, args);
+  va_end(args);
+
+  return rval;
+}
+
+int
+vmeOpenDefaultWindows()
+{
+  emuInit();
+  emuMapWindow(0, 0);
+
+  return OK;
+}
+
+int
+vmeCloseDefaultWindows()
+{
+  return OK;
+}
+
+int
+vmeBusToLocalAdrs(int vmeAdrsSpace, char *vmeBusAdrs, char **pPciAdrs)
+{
+  uint32_t busaddr = (uint32_t) (unsigned long) vmeBusAdrs, space;
+  emuWindow *w;
+
+  emuInit();
+
+  switch(vmeAdrsSpace & 0x3F)
+    {
+    case 0x38: case 0x39: case 0x3A: case 0x3B:
+    case 0x3C: case 0x3D: case 0x3E: case 0x3F:
+      space = 0;
+      busaddr &= 0x00FFFFFF;
+      w = emuMapWindow(space, 0);
+      break;
+
+    case 0x2F:
+      space = 1;
+      busaddr &= 0x00FFFFFF;
+      w = emuMapWindow(space, 0);
+      break;
+
+    case 0x08: case 0x09: case 0x0A: case 0x0B:
+    case 0x0C: case 0x0D: case 0x0E: case 0x0F:
+      space = 2;
+      w = emuMapWindow(space, busaddr & 0xFF000000);
+      busaddr &= 0x00FFFFFF;
+      break;
+
+    default:
+      fprintf(stderr, "%s: ERROR: Unsupported address modifier 0x%02x\n",
+	      __func__, vmeAdrsSpace);
+      return ERROR;
+    }
+
+  if(w == NULL)
+    return ERROR;
+
+  *pPciAdrs = (char *) (w->base + busaddr);
+
+  return OK;
+}
+
+int
+vmeLocalToBusAdrs(int vmeAdrsSpace, char *localAdrs, char **pVmeAdrs)
+{
+  emuWindow *w = emuFindWindow((uintptr_t) localAdrs);
+
+  if(w == NULL)
+    return ERROR;
+
+  *pVmeAdrs = (char *) (unsigned long) (w->vmebase + ((uintptr_t) localAdrs - (uintptr_t) w->base));
+
+  return OK;
+}
+
+int
+vmeMemProbe(char *addr, int size, char *rval)
+{
+  emuBoard *b = NULL;
+  uint32_t mcst = 0, offset = 0, val;
+
+  emuLock();
+  if(emuResolve((uintptr_t) addr, &b, &mcst, &offset) != 1)
+    {
+      emuUnlock();
+      return ERROR;
+    }
+  val = LSWAP(emuBoardRead(b, offset & ~0x3));
+  emuUnlock();
+
+  memcpy(rval, &val, (size < 4) ? size : 4);
+
+  return OK;
+}
+
+unsigned int
+vmeRead32(volatile unsigned int *addr)
+{
+  if(emuFindWindow((uintptr_t) addr) == NULL)
+    return LSWAP(*addr);
+
+  return emuAccessRead((uintptr_t) addr);
+}
+
+unsigned short
+vmeRead16(volatile unsigned short *addr)
+{
+  uint32_t rval;
+
+  if(emuFindWindow((uintptr_t) addr) == NULL)
+    return SSWAP(*addr);
+
+  rval = emuAccessRead((uintptr_t) addr);
+
+  return ((uintptr_t) addr & 0x2) ? (rval & 0xFFFF) : (rval >> 16);
+}
+
+unsigned char
+vmeRead8(volatile unsigned char *addr)
+{
+  uint32_t rval;
+
+  if(emuFindWindow((uintptr_t) addr) == NULL)
+    return *addr;
+
+  rval = emuAccessRead((uintptr_t) addr);
+
+  return (rval >> (8 * (3 - ((uintptr_t) addr & 0x3)))) & 0xFF;
+}
+
+void
+vmeWrite32(volatile unsigned int *addr, unsigned int val)
+{
+  if(emuFindWindow((uintptr_t) addr) == NULL)
+    {
+      *addr = LSWAP(val);
+      return;
+    }
+
+  emuAccessWrite((uintptr_t) addr, val);
+}
+
+void
+vmeWrite16(volatile unsigned short *addr, unsigned short val)
+{
+  if(emuFindWindow((uintptr_t) addr) == NULL)
+    {
+      *addr = SSWAP(val);
+      return;
+    }
+
+  emuAccessWrite((uintptr_t) addr, val);
+}
+
+void
+vmeWrite8(volatile unsigned char *addr, unsigned char val)
+{
+  if(emuFindWindow((uintptr_t) addr) == NULL)
+    {
+      *addr = val;
+      return;
+    }
+
+  emuAccessWrite((uintptr_t) addr, val);
+}
+
+int
+vmeDmaConfig(unsigned int addrType, unsigned int dataType, unsigned int sstMode)
+{
+  emuDma.addrType = addrType;
+
+  return OK;
+}
+
+int
+vmeDmaSend(unsigned long locAdrs, unsigned int vmeAdrs, int size)
+{
+  volatile uint32_t *dst = (volatile uint32_t *) locAdrs;
+  uint32_t maxwords = size >> 2, words = 0;
+  emuBoard *b;
+  double mbps;
+
+  if(emuDma.pending)
+    {
+      fprintf(stderr, "%s: ERROR: DMA already in progress\n", __func__);
+      return ERROR;
+    }
+
+  emuLock();
+  if(((emuDma.addrType == 2) || (vmeAdrs > 0x00FFFFFF)) &&
+     emuMcstPresent(vmeAdrs >> 24) && ((vmeAdrs & 0x00FFFFFF) < C1725EMU_BLT_SPACE))
+    {
+      words = emuCbltDma(vmeAdrs >> 24, dst, maxwords);
+    }
+  else if((vmeAdrs <= 0x00FFFFFF) &&
+	  ((b = emuBoardFromSlot(vmeAdrs >> 19)) != NULL) &&
+	  ((vmeAdrs & 0x7FFFF) < C1725EMU_BLT_SPACE))
+    {
+      words = emuBoardDma(b, dst, maxwords);
+    }
+  /* else: nothing answers the address, immediate bus error */
+  mbps = emuDMARate();
+  emuUnlock();
+
+  /* Programming the DMA engine occupies the CPU */
+  emuWaitUntil(emuNowNs() + emuDMASetupTime());
+
+  emuDma.result = words << 2;
+  emuDma.done_at = emuBusReserve((mbps > 0) ? (uint64_t) ((words << 2) * 1e3 / mbps) : 0);
+  emuDma.pending = 1;
+
+  return OK;
+}
+
+int
+vmeDmaDone()
+{
+  if(!emuDma.pending)
+    {
+      fprintf(stderr, "%s: ERROR: No DMA in progress\n", __func__);
+      return ERROR;
+    }
+
+  emuWaitUntil(emuDma.done_at);
+  emuDma.pending = 0;
+
+  return emuDma.result;
+}
+
+int
+vmeDmaFlush(unsigned int addr)
+{
+  return OK;
+}
+
+static void *
+emuIrqThread(void *arg)
+{
+  uint32_t vector = 0;
+  int32_t pending;
+
+  while(emuIrq.run)
+    {
+      emuLock();
+      pending = emuIrqPending(emuIrq.level, &vector);
+      emuUnlock();
+
+      if(pending && (vector == emuIrq.vector))
+	(*emuIrq.routine) (emuIrq.arg);
+
+      usleep(emuIrq.period_us);
+    }
+
+  return NULL;
+}
+
+int
+vmeIntConnect(unsigned int vector, unsigned int level, VOIDFUNCPTR routine,
+	      unsigned int arg)
+{
+  const char *env;
+
+  if(emuIrq.connected)
+    {
+      fprintf(stderr, "%s: ERROR: Interrupt handler already connected\n", __func__);
+      return ERROR;
+    }
+
+  emuInit();
+
+  emuIrq.vector = vector;
+  emuIrq.level = level;
+  emuIrq.routine = routine;
+  emuIrq.arg = arg;
+  emuIrq.period_us = 10;
+  if((env = getenv("C1725EMU_IRQ_US")))
+    emuIrq.period_us = strtoul(env, NULL, 0);
+
+  emuIrq.run = 1;
+  if(pthread_create(&emuIrq.thread, NULL, emuIrqThread, NULL) != 0)
+    {
+      perror("pthread_create");
+      emuIrq.run = 0;
+      return ERROR;
+    }
+  emuIrq.connected = 1;
+
+  return OK;
+}
+
+int
+vmeIntDisconnect(unsigned int level)
+{
+  if(!emuIrq.connected || (level != emuIrq.level))
+    {
+      fprintf(stderr, "%s: ERROR: No handler connected on level %d\n", __func__, level);
+      return ERROR;
+    }
+
+  emuIrq.run = 0;
+  pthread_join(emuIrq.thread, NULL);
+  emuIrq.connected = 0;
+
+  return OK;
+}
+
+int
+vmeBusLock()
+{
+  return pthread_mutex_lock(&emuVmeBusLock);
+}
+
+int
+vmeBusUnlock()
+{
+  return pthread_mutex_unlock(&emuVmeBusLock);
+}
+
+int
+vmeCheckMutexHealth(int sleepTime)
+{
+  return OK;
+}
+
+int
+vmeClearException(int pflag)
+{
+  return OK;
+}
+
+DMA_MEM_ID
+dmaPCreate(char *name, int size, int c, int incr)
+{
+  DMA_MEM_ID part = calloc(1, sizeof(DMA_MEM_PART));
+  int32_t ii;
+
+  if(part == NULL)
+    return NULL;
+
+  strncpy(part->name, name, sizeof(part->name) - 1);
+  part->size = size;
+  part->nitems = c;
+
+  for(ii = 0; ii < c; ii++)
+    {
+      /* 8 byte aligned data, like the DMA memory of the real library */
+      DMANODE *node = aligned_alloc(64, (sizeof(DMANODE) + size + 63) & ~63);
+      if(node == NULL)
+	break;
+      memset(node, 0, sizeof(DMANODE));
+      node->part = part;
+      node->next = part->free;
+      part->free = node;
+    }
+
+  part->next = emuPartList;
+  emuPartList = part;
+
+  return part;
+}
+
+static void
+emuFreeNodes(DMANODE *node)
+{
+  while(node)
+    {
+      DMANODE *next = node->next;
+      free(node);
+      node = next;
+    }
+}
+
+void
+dmaPFreeAll()
+{
+  while(emuPartList)
+    {
+      DMA_MEM_ID next = emuPartList->next;
+      emuFreeNodes(emuPartList->free);
+      emuFreeNodes(emuPartList->head);
+      free(emuPartList);
+      emuPartList = next;
+    }
+}
+
+void
+dmaPStatsAll()
+{
+  DMA_MEM_ID part;
+
+  for(part = emuPartList; part; part = part->next)
+    printf("%s: %-20s  size = %d  items = %d\n", __func__,
+	   part->name, part->size, part->nitems);
+}
+
+int
+dmaPReInitAll()
+{
+  DMA_MEM_ID part;
+
+  for(part = emuPartList; part; part = part->next)
+    {
+      while(part->head)
+	{
+	  DMANODE *node = part->head;
+	  part->head = node->next;
+	  dmaPFreeItem(node);
+	}
+      part->tail = NULL;
+    }
+
+  return OK;
+}
+
+DMANODE *
+dmaPGetItem(DMA_MEM_ID pPart)
+{
+  DMANODE *node;
+
+  if(pPart == NULL)
+    return NULL;
+
+  if(pPart->size == 0)
+    { /* output list, take from the filled list */
+      node = pPart->head;
+      if(node)
+	{
+	  pPart->head = node->next;
+	  if(pPart->head == NULL)
+	    pPart->tail = NULL;
+	  node->next = NULL;
+	}
+      return node;
+    }
+
+  node = pPart->free;
+  if(node)
+    {
+      pPart->free = node->next;
+      node->next = NULL;
+    }
+
+  return node;
+}
+
+void
+dmaPPutItem(DMA_MEM_ID pPart, DMANODE *pItem)
+{
+  pItem->next = NULL;
+  if(pPart->tail)
+    pPart->tail->next = pItem;
+  else
+    pPart->head = pItem;
+  pPart->tail = pItem;
+}
+
+void
+dmaPFreeItem(DMANODE *pItem)
+{
+  DMA_MEM_ID part = pItem->part;
+
+  pItem->next = part->free;
+  part->free = pItem;
+}
@@ -29,6 +29,10 @@
 /* for the calculation of maximum data words in the block transfer */
 unsigned int MAXC1725WORDS=0;
 
+/* Config file, watched during the run for threshold and offset changes */
+static char c1725ConfigFile[256];
+#define C1725_CONFIG_WATCH_MS 1000
+
 void
 c1725_Download(char* configFilename)
 {
@@ -45,6 +49,7 @@ c1725_Download(char* configFilename)
 
   /* configure all modules based on config file */
   caen1725Config(configFilename);
+  strncpy(c1725ConfigFile, configFilename, sizeof(c1725ConfigFile) - 1);
 
   c1725SetMulticast(0x09000000);
 
@@ -61,6 +66,23 @@ c1725_Prestart()
   /* Program/Init VME Modules Here */
   /* DOALL(...); */
 
+  /* Check that the modules still hold the configuration, once the DC offsets
+     left loading by Download are done.  Rewrite what differs, and fail the
+     transition if that does not fix it */
+  if(caen1725ConfigVerify(NULL, 0) != 0)
+    {
+      printf("%s: WARN: Modules differ from the configuration, rewriting\n", __func__);
+      if((caen1725ConfigRestore() != 0) || (caen1725ConfigVerify(NULL, 0) != 0))
+	daLogMsg("ERROR", "C1725 modules differ from the configuration");
+    }
+
+  /* ADC calibration runs on all modules while the rest of the crate is
+     prestarted.  c1725_Go waits for it */
+  c1725GADCCalibrationStart();
+
+  /* Readout counters of this run */
+  c1725ResetCounters();
+
   c1725GStatus(1);
 
   printf("%s: done\n", __func__);
@@ -75,18 +97,22 @@ c1725_Go()
   DOALL(c1725SetMaxEventsPerBLT(c1725Slot(_ic), blockLevel));
 
 
-  /* Get the C1725 mode and window size to determine max data size */
-  // ...
-  uint32_t ptw = 0;
+  /* Max data words from the programmed record lengths and channel masks */
+  uint32_t expwords = 0;
+  c1725GBlockWords(blockLevel, &MAXC1725WORDS, &expwords);
 
-  /* Set Max words from fadc (proc mode == 1 produces the most)
-     nfadc * ( Block Header + Trailer + 2  # 2 possible filler words
-               blockLevel * ( Event Header + Header2 + Timestamp1 + Timestamp2 +
-	                      nchan * (Channel Header + (WindowSize / 2) )
-             ) +
-     scaler readout # 16 channels + header/trailer
-   */
-  MAXC1725WORDS = c1725N() * (4 + blockLevel * (4 + 16 * (1 + (ptw / 2))) + 18);
+  printf("%s: Block of %d events: expect %d words, at most %d words\n",
+	 __func__, blockLevel, expwords, MAXC1725WORDS);
+  if((MAXC1725WORDS << 2) > MAX_EVENT_LENGTH)
+    {
+      printf("%s: WARN: Largest block (%d bytes) exceeds the event buffer (%d bytes).\n",
+	     __func__, MAXC1725WORDS << 2, MAX_EVENT_LENGTH);
+      printf("%s:       Readout is limited to the event buffer.\n", __func__);
+      MAXC1725WORDS = MAX_EVENT_LENGTH >> 2;
+    }
+
+  if(c1725GADCCalibrationWait(1000000, NULL) != OK)
+    printf("%s: WARN: ADC calibration did not finish on every channel\n", __func__);
 
   /*  Enable C1725 */
   uint32_t lvds_busy_enable = 0, lvds_veto_enable = 0, lvds_runin_enable = 0,
@@ -94,9 +120,13 @@ c1725_Go()
     clocksource = 0, // 0: internal
     arm = 1;         // 0: Stop, 1: Start
 
-  DOALL(c1725SetAcquisitionControl(c1725Slot(_ic), mode, arm, clocksource,
-				   lvds_busy_enable, lvds_veto_enable,
-				   lvds_runin_enable));
+  /* All modules start with the same multicast write */
+  c1725GSetAcquisitionControl(mode, arm, clocksource,
+			      lvds_busy_enable, lvds_veto_enable,
+			      lvds_runin_enable);
+
+  /* Thresholds, baselines and DC offsets follow the config file during the run */
+  caen1725ConfigWatch(c1725ConfigFile, C1725_CONFIG_WATCH_MS);
 
   /* Interrupts/Polling enabled after conclusion of rocGo() */
 }
@@ -104,6 +134,8 @@ c1725_Go()
 void
 c1725_End()
 {
+  /* Back to the parameters of the next Download */
+  caen1725ConfigWatch(NULL, 0);
 
   /* C1725 Disable */
   uint32_t lvds_busy_enable = 0, lvds_veto_enable = 0, lvds_runin_enable = 0,
@@ -111,13 +143,22 @@ c1725_End()
     clocksource = 0, // 0: internal
     arm = 0;         // 0: Stop, 1: Start
 
-  DOALL(c1725SetAcquisitionControl(c1725Slot(_ic), mode, arm, clocksource,
-				   lvds_busy_enable, lvds_veto_enable,
-				   lvds_runin_enable));
+  c1725GSetAcquisitionControl(mode, arm, clocksource,
+			      lvds_busy_enable, lvds_veto_enable,
+			      lvds_runin_enable);
 
   /* C1725 Event status - Is all data read out */
   c1725GStatus(1);
 
+  /* Readout counters of the run */
+  c1725Counters_t cnt;
+  DOALL(if(c1725CountersSnapshot(c1725Slot(_ic), &cnt) == OK)
+	  printf("%s: slot %2d: %llu events %llu words %llu DMAs (%llu retries) "
+		 "%llu scan timeouts %llu lock waits\n", __func__, c1725Slot(_ic),
+		 (unsigned long long) cnt.events, (unsigned long long) cnt.words,
+		 (unsigned long long) cnt.dma_calls, (unsigned long long) cnt.dma_retries,
+		 (unsigned long long) cnt.scan_timeouts, (unsigned long long) cnt.lock_waits));
+
   printf("%s: done\n", __func__);
 
 }
@@ -126,7 +167,8 @@ void
 c1725_Trigger(int arg)
 {
   int32_t stat = 0, nwords = 0, roCount = 0;
-  uint32_t datascan = 0, scanmask = 0;
+  uint32_t datascan = 0, scanmask = 0, nscans = 0;
+  uint64_t scan_ns = 0;
 
   roCount = tiGetIntCount();
 
@@ -146,7 +188,7 @@ c1725_Trigger(int arg)
   /* Mask of initialized modules */
   scanmask = c1725SlotMask();
   /* Check scanmask for block ready up to 100 times */
-  datascan = c1725GBlockReady(scanmask, 100, blockLevel);
+  datascan = c1725GBlockReadyScan(scanmask, 100, blockLevel, &nscans, &scan_ns);
   stat = (datascan == scanmask);
 
   if(stat)
@@ -170,8 +212,8 @@ c1725_Trigger(int arg)
     }
   else
     {
-      printf("ERROR: Event %d: Datascan != Scanmask  (0x%08x != 0x%08x)\n",
-	     roCount, datascan, scanmask);
+      printf("ERROR: Event %d: Datascan != Scanmask  (0x%08x != 0x%08x) after %d scans, %d us\n",
+	     roCount, datascan, scanmask, nscans, (uint32_t) (scan_ns / 1000));
     }
   BANKCLOSE;
 
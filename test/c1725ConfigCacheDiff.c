@@ -0,0 +1,139 @@
+/*
+ * File:
+ *    c1725ConfigCacheDiff.c
+ *
+ * Description:
+ *    Print the parameters that differ between two compiled configuration
+ *    caches (written by caen1725Config as <config file>.<crate>.cache)
+ *
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include "jvme.h"
+#include "caen1725Lib.h"
+#include "caen1725Config.h"
+
+static caen1725param_t a[MAX_VME_SLOTS + 1], b[MAX_VME_SLOTS + 1];
+
+int
+main(int argc, char *argv[])
+{
+  uint64_t ahash = 0, bhash = 0;
+  int32_t islot, ich, ndiff = 0;
+
+  if(argc != 3)
+    {
+      printf("Usage: %s <cache file> <cache file>\n", argv[0]);
+      exit(2);
+    }
+
+  if(caen1725ConfigCacheRead(argv[1], a, &ahash) != 0)
+    {
+      printf("%s: Can't read cache: %s\n", argv[0], argv[1]);
+      exit(2);
+    }
+  if(caen1725ConfigCacheRead(argv[2], b, &bhash) != 0)
+    {
+      printf("%s: Can't read cache: %s\n", argv[0], argv[2]);
+      exit(2);
+    }
+
+  printf("< %s (0x%016" PRIx64 ")\n", argv[1], ahash);
+  printf("> %s (0x%016" PRIx64 ")\n", argv[2], bhash);
+
+#define DIFFPARAM(_reg)							\
+  if(a[islot]._reg != b[islot]._reg)					\
+    {									\
+      printf("  %-8s %22s = %8d | %d\n",				\
+	     slot, #_reg, a[islot]._reg, b[islot]._reg);		\
+      ndiff++;								\
+    }
+#define DIFFCH(_reg)							\
+  for(ich = 0; ich <= CHANNEL_COMMON; ich++)				\
+    if(a[islot]._reg[ich] != b[islot]._reg[ich])			\
+      {									\
+	printf("  %-8s %18s[%2d] = %8d | %d\n",				\
+	       slot, #_reg, ich, a[islot]._reg[ich], b[islot]._reg[ich]); \
+	ndiff++;							\
+      }
+
+  for(islot = 0; islot <= MAX_VME_SLOTS; islot++)
+    {
+      char slot[16];
+
+      if(islot == 0)
+	snprintf(slot, sizeof(slot), "ALLSLOTS");
+      else
+	snprintf(slot, sizeof(slot), "SLOT %d", islot);
+
+      DIFFPARAM(external_trigger);
+      DIFFPARAM(fpio_level);
+      DIFFPARAM(enable_input_mask);
+
+      DIFFPARAM(trg_in_mode);
+      DIFFPARAM(veto_polarity);
+      DIFFPARAM(flag_trunc_event);
+
+      DIFFPARAM(global_trg_channel_mask);
+      DIFFPARAM(global_trg_coinc_window);
+      DIFFPARAM(global_trg_majority);
+      DIFFPARAM(global_trg_lvds);
+      DIFFPARAM(global_trg_software);
+
+      DIFFPARAM(fptrgout_channel_mask);
+      DIFFPARAM(fptrgout_channel_logic);
+      DIFFPARAM(fptrgout_majority);
+      DIFFPARAM(fptrgout_lvds);
+      DIFFPARAM(fptrgout_software);
+
+      DIFFPARAM(fpio_trgout_enable);
+      DIFFPARAM(fpio_lvds_mask);
+      DIFFPARAM(fpio_trg_in_mask);
+      DIFFPARAM(fpio_trg_out_mask);
+
+      DIFFPARAM(run_delay);
+      DIFFPARAM(veto_delay);
+
+      DIFFPARAM(monitor_mode);
+      DIFFPARAM(monitor_dac);
+
+      DIFFPARAM(intlevel);
+      DIFFPARAM(optical_int);
+      DIFFPARAM(vme_berr);
+      DIFFPARAM(align64);
+      DIFFPARAM(address_relocate);
+      DIFFPARAM(roak);
+      DIFFPARAM(ext_blk_space);
+
+      DIFFPARAM(max_events_per_blt);
+
+      DIFFCH(record_length);
+      DIFFCH(input_delay);
+      DIFFCH(gain_factor);
+      DIFFCH(pre_trigger);
+      DIFFCH(trg_threshold);
+      DIFFCH(bline_defmode);
+      DIFFCH(bline_defvalue);
+      DIFFCH(max_tail);
+      DIFFCH(dc_offset);
+      DIFFCH(n_lfw);
+      DIFFCH(test_pulse_polarity);
+      DIFFCH(test_pulse);
+      DIFFCH(test_pulse_rate);
+      DIFFCH(self_trigger);
+    }
+
+  printf("%d parameters differ\n", ndiff);
+
+  exit(ndiff ? 1 : 0);
+}
+/*
+  Local Variables:
+  compile-command: "make -k c1725ConfigCacheDiff "
+  End:
+*/
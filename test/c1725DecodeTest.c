@@ -0,0 +1,248 @@
+/*
+ * File:
+ *    c1725DecodeTest.c
+ *
+ * Description:
+ *    Test the caen 1725 data decoder on a generated CBLT block, with each
+ *    available sample unpacking implementation, and report its throughput.
+ *
+ *
+ */
+
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include "jvme.h"
+#include "caen1725Lib.h"
+#include "caen1725Decode.h"
+
+#define NBOARDS   16
+#define NEVENTS   4      /* events per board */
+#define RECLEN    100    /* in units of C1725_RECORD_LENGTH_SAMPLES */
+#define NSAMPLES  (RECLEN * C1725_RECORD_LENGTH_SAMPLES)
+#define MAXWORDS  (NBOARDS * NEVENTS * (C1725_HEADER_NWORDS + C1725_MAX_ADC_CHANNELS * \
+					(C1725_CHANNEL_HEADER_NWORDS + NSAMPLES / 2)) + 1024)
+#define MAXEVENTS (NBOARDS * NEVENTS)
+
+static uint32_t data[MAXWORDS];
+static int16_t samples[2 * MAXWORDS];
+static c1725DecodedEvent_t events[MAXEVENTS];
+
+static int16_t
+sampleValue(uint32_t slot, uint32_t ev, uint32_t ch, uint32_t is)
+{
+  return (slot * 1000 + ev * 100 + ch * 37 + is * 7) & C1725_CHANNEL_SAMPLE_MASK;
+}
+
+/* Fill a block like c1725CBLTReadBlock, in VME byte order.  Return words */
+static uint32_t
+makeBlock(uint32_t chanmask)
+{
+  uint32_t iw = 0, slot, ev, ch, is;
+
+  data[iw++] = LSWAP(C1725_DMA_FILLER_WORD);
+
+  for(slot = 3; slot < 3 + NBOARDS; slot++)
+    {
+      for(ev = 0; ev < NEVENTS; ev++)
+	{
+	  uint32_t start = iw;
+
+	  iw++;
+	  data[iw++] = LSWAP((slot << 27) | (0x1234 << 8) | (chanmask & 0xFF));
+	  data[iw++] = LSWAP(((chanmask >> 8) << 24) | ev);
+	  data[iw++] = LSWAP(ev * 125);
+
+	  for(ch = 0; ch < C1725_MAX_ADC_CHANNELS; ch++)
+	    {
+	      if(!(chanmask & (1 << ch)))
+		continue;
+
+	      data[iw++] = LSWAP(C1725_CHANNEL_HEADER_NWORDS + NSAMPLES / 2);
+	      data[iw++] = LSWAP(ev * 125 + ch);
+	      for(is = 0; is < NSAMPLES; is += 2)
+		data[iw++] = LSWAP(sampleValue(slot, ev, ch, is) |
+				   ((uint32_t) sampleValue(slot, ev, ch, is + 1)
+				    << C1725_CHANNEL_SAMPLE_SHIFT) |
+				   0xC000C000); /* bits above the samples are ignored */
+	    }
+
+	  data[start] = LSWAP(C1725_HEADER_TYPE_ID | (iw - start));
+	}
+      if(iw & 1)
+	data[iw++] = LSWAP(C1725_FILLER_WORD);
+    }
+
+  return iw;
+}
+
+static int32_t
+checkBlock(int32_t nev, uint32_t chanmask)
+{
+  int32_t iev, ich, is, nerr = 0;
+
+  if(nev != MAXEVENTS)
+    {
+      printf("  ERROR: %d events decoded, expected %d\n", nev, MAXEVENTS);
+      return 1;
+    }
+
+  for(iev = 0; iev < nev; iev++)
+    {
+      c1725DecodedEvent_t *e = &events[iev];
+      uint32_t slot = 3 + iev / NEVENTS, ev = iev % NEVENTS;
+
+      if((e->slot != slot) || (e->event_counter != ev) || (e->channel_mask != chanmask) ||
+	 (e->pattern != 0x1234) || (e->trigger_time != ev * 125))
+	{
+	  printf("  ERROR: event %d header: slot %d counter %d mask 0x%04x pattern 0x%x\n",
+		 iev, e->slot, e->event_counter, e->channel_mask, e->pattern);
+	  nerr++;
+	  continue;
+	}
+
+      for(ich = 0; ich < e->nchannels; ich++)
+	{
+	  c1725DecodedChannel_t *c = &e->chan[ich];
+
+	  if((c->nsamples != NSAMPLES) || (c->trigger_time != ev * 125 + c->channel))
+	    {
+	      printf("  ERROR: event %d channel %d: nsamples %d\n", iev, c->channel, c->nsamples);
+	      nerr++;
+	      continue;
+	    }
+
+	  for(is = 0; is < c->nsamples; is++)
+	    {
+	      if(c->samples[is] != sampleValue(slot, ev, c->channel, is))
+		{
+		  printf("  ERROR: event %d channel %d sample %d: 0x%04x != 0x%04x\n",
+			 iev, c->channel, is, c->samples[is],
+			 sampleValue(slot, ev, c->channel, is));
+		  nerr++;
+		  break;
+		}
+	    }
+	}
+    }
+
+  return nerr;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char *isaName[] = { "scalar", "sse2", "avx2" };
+  uint32_t chanmask[] = { 0xFFFF, 0x8421 }, nwords, im;
+  int32_t isa, nev, nerr = 0, iter, niter = 200;
+  struct timespec t0, t1;
+
+  printf("\n %s\n", argv[0]);
+  printf("----------------------------\n");
+
+  for(isa = C1725_DECODE_SCALAR; isa <= C1725_DECODE_AVX2; isa++)
+    {
+      if(c1725DecodeSetISA(isa) != OK)
+	continue;
+
+      for(im = 0; im < sizeof(chanmask) / sizeof(chanmask[0]); im++)
+	{
+	  nwords = makeBlock(chanmask[im]);
+	  memset(samples, 0, sizeof(samples));
+
+	  nev = c1725DecodeBlock(data, nwords, events, MAXEVENTS, samples, 2 * MAXWORDS);
+	  nerr += checkBlock(nev, chanmask[im]);
+
+	  clock_gettime(CLOCK_MONOTONIC, &t0);
+	  for(iter = 0; iter < niter; iter++)
+	    c1725DecodeBlock(data, nwords, events, MAXEVENTS, samples, 2 * MAXWORDS);
+	  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	  double sec = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+	  printf("  %-6s  chanmask 0x%04x  %7d words  %8.1f MB/s\n",
+		 isaName[isa], chanmask[im], nwords,
+		 (double) niter * nwords * 4 / sec * 1e-6);
+	}
+    }
+
+  /* Zero-copy view must see the same events, boards and samples */
+  c1725DecodeSetISA(-1);
+  for(im = 0; im < sizeof(chanmask) / sizeof(chanmask[0]); im++)
+    {
+      c1725View_t view, bview;
+      c1725BoardView_t board;
+      c1725EventView_t ev;
+      c1725ChannelView_t chan;
+      int32_t nboards = 0, nchanerr = 0, ich, is;
+
+      nwords = makeBlock(chanmask[im]);
+      nev = c1725DecodeBlock(data, nwords, events, MAXEVENTS, samples, 2 * MAXWORDS);
+
+      c1725ViewInit(&view, data, nwords);
+      while(c1725ViewNextBoard(&view, &board) == 1)
+	{
+	  int32_t iev = 0;
+
+	  if((board.slot != 3 + nboards) || (board.nevents != NEVENTS))
+	    {
+	      printf("  ERROR: view board %d: slot %d nevents %d\n",
+		     nboards, board.slot, board.nevents);
+	      nerr++;
+	    }
+
+	  c1725ViewInit(&bview, board.data, board.nwords);
+	  while(c1725ViewNextEvent(&bview, &ev) == 1)
+	    {
+	      c1725DecodedEvent_t *e = &events[nboards * NEVENTS + iev++];
+
+	      for(ich = 0; ich < e->nchannels; ich++)
+		{
+		  if(c1725EventViewChannel(&ev, e->chan[ich].channel, &chan) != OK)
+		    {
+		      nchanerr++;
+		      continue;
+		    }
+		  for(is = 0; is < chan.nsamples; is++)
+		    if(c1725ChannelViewSample(&chan, is) != e->chan[ich].samples[is])
+		      {
+			nchanerr++;
+			break;
+		      }
+		}
+	    }
+	  if(iev != NEVENTS)
+	    nchanerr++;
+	  nboards++;
+	}
+
+      if((nboards != NBOARDS) || nchanerr)
+	{
+	  printf("  ERROR: view: %d boards, %d channel errors\n", nboards, nchanerr);
+	  nerr++;
+	}
+      else
+	printf("  view    chanmask 0x%04x  %d boards, %d events\n", chanmask[im], nboards, nev);
+    }
+
+  /* Corrupted event size must be rejected */
+  nwords = makeBlock(0xFFFF);
+  data[1] = LSWAP(C1725_HEADER_TYPE_ID | 10);
+  nev = c1725DecodeBlock(data, nwords, events, MAXEVENTS, samples, 2 * MAXWORDS);
+  if(nev != ERROR)
+    {
+      printf("  ERROR: corrupted event accepted\n");
+      nerr++;
+    }
+
+  printf("%s: %s\n", argv[0], nerr ? "FAILED" : "PASSED");
+
+  exit(nerr ? 1 : 0);
+}
+/*
+  Local Variables:
+  compile-command: "make -k c1725DecodeTest "
+  End:
+*/
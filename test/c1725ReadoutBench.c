@@ -0,0 +1,528 @@
+/*
+ * File:
+ *    c1725ReadoutBench.c
+ *
+ * Description:
+ *    Readout throughput benchmark for the caen 1725 library.
+ *
+ *    Drives c1725ReadEvent (programmed I/O and DMA) and c1725CBLTReadBlock
+ *    with software triggers, and reports MB/s, events/s, per-call latency
+ *    percentiles and DMA retries for each combination of board count,
+ *    block level and record length.
+ *
+ *    Runs against real modules, or against the emulator by building with
+ *    LINUXVME_INC=../emu LINUXVME_LIB=../emu and, e.g.
+ *      C1725EMU_SLOTS=3-20 C1725EMU_DMA_MBPS=200 C1725EMU_SCT_NS=1000 \
+ *        ./c1725ReadoutBench -n 1,4,18 -b 1,10 -r 2,50
+ *    (emulated programmed I/O timing is dominated by the cost of trapping
+ *     each access to the readout buffer)
+ *
+ *    With -p, a second thread polls the status registers of all modules
+ *    during readout, as a slow control / monitoring thread would.
+ *
+ *    With -x, the modules' extended block transfer space is enabled, so
+ *    a block is read with one DMA instead of one per 4 KB.
+ *
+ *    With -f, each block is also copied into a bank buffer at a fixed CPU cost
+ *    per word, as a readout list formatting the data would.  The async mode
+ *    does that with c1725CBLTReadStart / c1725ReadComplete into two buffers,
+ *    formatting the previous block while the next one is transferred.
+ *
+ */
+
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "caen1725Lib.h"
+
+#define DOALL(x) {				\
+    int32_t _ic=0;				\
+    for(_ic = 0; _ic < c1725N(); _ic++)		\
+      {						\
+	x;					\
+      }						\
+  }
+
+#define MAXLIST   16
+#define MAXPOINTS 512
+
+enum { MODE_PIO, MODE_DMA, MODE_CBLT, MODE_ASYNC, NMODES };
+static const char *modeName[NMODES] = { "pio", "dma", "cblt", "async" };
+
+typedef struct
+{
+  int32_t  mode, nboards, blocklevel, reclen;
+  uint32_t nblocks, errors;
+  uint64_t words, events, ncalls;
+  uint64_t readout_ns;
+  double   p50, p99, p999;		/* per call latency, microseconds */
+  uint32_t dma_transfers, dma_retries, dma_readouts, dma_saved;
+  uint64_t polls;			/* status poll cycles during readout */
+} benchResult;
+
+static benchResult result[MAXPOINTS];
+static int32_t nresult = 0;
+
+/* Status polling thread */
+static int32_t pollInterval = -1;	/* microseconds, -1: disabled */
+static volatile int32_t pollRun = 0;
+static volatile uint64_t pollCycles = 0;
+
+/* Simulated formatting into the output bank */
+static int32_t formatNs = -1;		/* nanoseconds per word, -1: disabled */
+static uint32_t *bank = NULL;
+
+static int32_t extBlkSpace = 0;
+
+static uint64_t
+nowNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+cmpU64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+static double
+percentile(uint64_t *lat, uint64_t n, double p)
+{
+  uint64_t i;
+
+  if(n == 0)
+    return 0;
+
+  i = (uint64_t) (p * (double) (n - 1) + 0.5);
+
+  return lat[i] * 1e-3;
+}
+
+static int32_t
+parseList(const char *arg, int32_t *list)
+{
+  char buf[256], *tok, *save = NULL;
+  int32_t n = 0;
+
+  strncpy(buf, arg, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = 0;
+
+  for(tok = strtok_r(buf, ",", &save); tok && (n < MAXLIST);
+      tok = strtok_r(NULL, ",", &save))
+    {
+      int32_t im;
+
+      list[n] = -1;
+      for(im = 0; im < NMODES; im++)
+	if(strcmp(tok, modeName[im]) == 0)
+	  list[n] = im;
+
+      if(list[n] < 0)
+	list[n] = atoi(tok);
+      n++;
+    }
+
+  return n;
+}
+
+/* Words in one event with all channels enabled */
+static uint32_t
+eventWords(uint32_t reclen)
+{
+  return C1725_HEADER_NWORDS + C1725_MAX_ADC_CHANNELS *
+    (C1725_CHANNEL_HEADER_NWORDS + (reclen * C1725_RECORD_LENGTH_SAMPLES + 1) / 2);
+}
+
+static void *
+statusPoll(void *arg)
+{
+  uint32_t arm, eventready, eventfull, clocksource, pll, ready, sinlevel, trglevel,
+    shutdown, temperature, evstored, memory, spi_busy, calibration, overtemp;
+  int32_t ic, ichan;
+
+  while(pollRun)
+    {
+      for(ic = 0; ic < c1725N(); ic++)
+	{
+	  int32_t id = c1725Slot(ic);
+
+	  c1725GetAcquisitionStatus(id, &arm, &eventready, &eventfull, &clocksource,
+				    &pll, &ready, &sinlevel, &trglevel, &shutdown,
+				    &temperature);
+	  c1725GetEvStored(id, &evstored);
+
+	  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+	    {
+	      c1725GetChannelStatus(id, ichan, &memory, &spi_busy, &calibration, &overtemp);
+	      c1725GetADCTemperature(id, ichan, &temperature);
+	    }
+	}
+      pollCycles++;
+
+      if(pollInterval > 0)
+	usleep(pollInterval);
+    }
+
+  return NULL;
+}
+
+/* Copy a block into the bank, taking at least formatNs per word */
+static void
+format(volatile uint32_t *buf, int32_t nwrds)
+{
+  uint64_t end;
+  int32_t iw;
+
+  if((formatNs < 0) || (nwrds <= 0))
+    return;
+
+  end = nowNs() + (uint64_t) nwrds * formatNs;
+  for(iw = 0; iw < nwrds; iw++)
+    bank[iw] = LSWAP(buf[iw]);
+
+  while(nowNs() < end)
+    ;
+}
+
+static void
+setup(int32_t blocklevel, int32_t reclen, uint32_t arm)
+{
+  int32_t ichan, ic;
+
+  DOALL(c1725SetAcquisitionControl(c1725Slot(_ic), 0, 0, 0, 0, 0, 0));
+  if(!arm)
+    return;
+
+  for(ichan = 0; ichan < C1725_MAX_ADC_CHANNELS; ichan++)
+    DOALL(c1725SetRecordLength(c1725Slot(_ic), ichan, reclen));
+  DOALL(c1725SetMaxEventsPerBLT(c1725Slot(_ic), blocklevel));
+  for(ic = 0; ic < c1725N(); ic++)
+    {
+      uint32_t intlevel, optical_int, vme_berr, align64, address_relocate, roak, ext;
+
+      c1725GetReadoutControl(c1725Slot(ic), &intlevel, &optical_int, &vme_berr, &align64,
+			     &address_relocate, &roak, &ext);
+      c1725SetReadoutControl(c1725Slot(ic), intlevel, optical_int, vme_berr, align64,
+			     address_relocate, roak, extBlkSpace);
+    }
+  DOALL(c1725Clear(c1725Slot(_ic)));
+  DOALL(c1725SetAcquisitionControl(c1725Slot(_ic), 0, 1, 0, 0, 0, 0));
+}
+
+static void
+runPoint(benchResult *r, volatile uint32_t *buf[2], uint32_t maxwords, uint64_t *lat)
+{
+  uint32_t iblock, scanmask = c1725SlotMask(), datascan;
+  int32_t ic, iev, nwrds, prev = 0, cur = 0;
+  uint64_t t0, t1;
+  pthread_t poller;
+
+  setup(r->blocklevel, r->reclen, 1);
+  vmeDmaConfig((r->mode >= MODE_CBLT) ? 2 : 1, 5, 1);
+  c1725ResetDMAStats();
+
+  if(pollInterval >= 0)
+    {
+      pollCycles = 0;
+      pollRun = 1;
+      if(pthread_create(&poller, NULL, statusPoll, NULL) != 0)
+	{
+	  perror("pthread_create");
+	  pollRun = 0;
+	}
+    }
+
+  for(iblock = 0; iblock < r->nblocks; iblock++)
+    {
+      for(ic = 0; ic < c1725N(); ic++)
+	for(iev = 0; iev < r->blocklevel; iev++)
+	  c1725SoftTrigger(c1725Slot(ic));
+
+      datascan = c1725GBlockReady(scanmask, 1000, r->blocklevel);
+      if(datascan != scanmask)
+	{
+	  r->errors++;
+	  continue;
+	}
+
+      switch(r->mode)
+	{
+	case MODE_PIO:
+	case MODE_DMA:
+	  for(ic = 0; ic < c1725N(); ic++)
+	    {
+	      for(iev = 0; iev < ((r->mode == MODE_PIO) ? r->blocklevel : 1); iev++)
+		{
+		  t0 = nowNs();
+		  nwrds = c1725ReadEvent(c1725Slot(ic), buf[0], maxwords,
+					 (r->mode == MODE_PIO) ? 0 : 1);
+		  format(buf[0], nwrds);
+		  t1 = nowNs();
+
+		  lat[r->ncalls++] = t1 - t0;
+		  r->readout_ns += t1 - t0;
+		  if(nwrds > 0)
+		    r->words += nwrds;
+		  else
+		    r->errors++;
+		}
+	    }
+	  break;
+
+	case MODE_CBLT:
+	  t0 = nowNs();
+	  nwrds = c1725CBLTReadBlock(buf[0], maxwords, 1);
+	  format(buf[0], nwrds);
+	  t1 = nowNs();
+
+	  lat[r->ncalls++] = t1 - t0;
+	  r->readout_ns += t1 - t0;
+	  if(nwrds > 0)
+	    r->words += nwrds;
+	  else
+	    r->errors++;
+	  break;
+
+	case MODE_ASYNC:
+	  /* Transfer this block while the previous one is formatted */
+	  t0 = nowNs();
+	  if(c1725CBLTReadStart(buf[cur], maxwords) == OK)
+	    {
+	      format(buf[cur ^ 1], prev);
+	      nwrds = c1725ReadComplete();
+	    }
+	  else
+	    {
+	      format(buf[cur ^ 1], prev);
+	      nwrds = ERROR;
+	    }
+	  t1 = nowNs();
+
+	  lat[r->ncalls++] = t1 - t0;
+	  r->readout_ns += t1 - t0;
+	  if(nwrds > 0)
+	    r->words += nwrds;
+	  else
+	    r->errors++;
+	  prev = nwrds;
+	  cur ^= 1;
+	  break;
+	}
+
+      r->events += c1725N() * r->blocklevel;
+    }
+
+  if(r->mode == MODE_ASYNC)
+    { /* Format the last block */
+      t0 = nowNs();
+      format(buf[cur ^ 1], prev);
+      r->readout_ns += nowNs() - t0;
+    }
+
+  if(pollRun)
+    {
+      pollRun = 0;
+      pthread_join(poller, NULL);
+      r->polls = pollCycles;
+    }
+
+  setup(r->blocklevel, r->reclen, 0);
+  c1725GetDMAStats(&r->dma_transfers, &r->dma_retries);
+  c1725GetDMAChunkStats(&r->dma_readouts, &r->dma_saved);
+
+  qsort(lat, r->ncalls, sizeof(uint64_t), cmpU64);
+  r->p50 = percentile(lat, r->ncalls, 0.50);
+  r->p99 = percentile(lat, r->ncalls, 0.99);
+  r->p999 = percentile(lat, r->ncalls, 0.999);
+}
+
+static void
+printResults()
+{
+  int32_t ir;
+
+  printf("\n");
+  printf("                                        "
+	 "                    Latency per call (us)                 DMA\n");
+  printf("Mode  Boards  Block  RecLen   Blocks    MB/s       Events/s"
+	 "       p50       p99     p99.9    per block  retries    saved  Errors     Polls\n");
+  printf("----------------------------------------"
+	 "---------------------------------------------------------------------------------------------\n");
+
+  for(ir = 0; ir < nresult; ir++)
+    {
+      benchResult *r = &result[ir];
+      double sec = r->readout_ns * 1e-9;
+
+      printf("%-4s  %6d  %5d  %6d  %7d  %8.2f  %12.1f  %8.2f  %8.2f  %8.2f    %9.2f  %7d  %7d  %6d  %8llu\n",
+	     modeName[r->mode], r->nboards, r->blocklevel, r->reclen, r->nblocks,
+	     (sec > 0) ? (r->words * 4.0) / sec * 1e-6 : 0,
+	     (sec > 0) ? r->events / sec : 0,
+	     r->p50, r->p99, r->p999,
+	     r->nblocks ? (double) r->dma_transfers / r->nblocks : 0,
+	     r->dma_retries, r->dma_saved, r->errors, (unsigned long long) r->polls);
+    }
+  printf("\n");
+}
+
+static void
+usage(const char *name)
+{
+  printf("Usage: %s [-s slot] [-n boards] [-b blocklevels] [-r reclens] [-m modes] [-N blocks]\n"
+	 "          [-p usec] [-f ns] [-x]\n",
+	 name);
+  printf("   -s  slot of the first module (default 3)\n");
+  printf("   -n  comma separated list of board counts (default 1)\n");
+  printf("   -b  comma separated list of block levels (default 1)\n");
+  printf("   -r  comma separated list of record lengths, in units of %d samples (default 2)\n",
+	 C1725_RECORD_LENGTH_SAMPLES);
+  printf("   -m  comma separated list of modes: pio,dma,cblt,async (default all)\n");
+  printf("   -N  blocks read per point (default 1000)\n");
+  printf("   -p  poll module status from a second thread, every usec (0: continuously)\n");
+  printf("   -x  enable the extended block transfer space\n");
+  printf("   -f  format each block into a bank buffer, at ns per word (latency includes it)\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int32_t stat, opt, slot = 3, nblocks = 1000;
+  int32_t boards[MAXLIST] = { 1 }, nboards = 1;
+  int32_t blocks[MAXLIST] = { 1 }, nblocklevel = 1;
+  int32_t reclens[MAXLIST] = { 2 }, nreclen = 1;
+  int32_t modes[MAXLIST] = { MODE_PIO, MODE_DMA, MODE_CBLT, MODE_ASYNC }, nmodes = NMODES;
+  int32_t maxboards = 0, maxblock = 0, maxreclen = 0;
+  int32_t ib, il, ir, im;
+  uint32_t maxwords;
+  uint64_t *lat = NULL;
+  volatile uint32_t *buf[2];
+  DMA_MEM_ID vmeIN;
+
+  while((opt = getopt(argc, argv, "s:n:b:r:m:N:p:f:xh")) != -1)
+    {
+      switch(opt)
+	{
+	case 's': slot = atoi(optarg); break;
+	case 'n': nboards = parseList(optarg, boards); break;
+	case 'b': nblocklevel = parseList(optarg, blocks); break;
+	case 'r': nreclen = parseList(optarg, reclens); break;
+	case 'm': nmodes = parseList(optarg, modes); break;
+	case 'N': nblocks = atoi(optarg); break;
+	case 'p': pollInterval = atoi(optarg); break;
+	case 'f': formatNs = atoi(optarg); break;
+	case 'x': extBlkSpace = 1; break;
+	default:
+	  usage(argv[0]);
+	  exit(1);
+	}
+    }
+
+  for(ib = 0; ib < nboards; ib++)
+    if(boards[ib] > maxboards) maxboards = boards[ib];
+  for(il = 0; il < nblocklevel; il++)
+    if(blocks[il] > maxblock) maxblock = blocks[il];
+  for(ir = 0; ir < nreclen; ir++)
+    if(reclens[ir] > maxreclen) maxreclen = reclens[ir];
+
+  maxwords = (maxboards * (maxblock * eventWords(maxreclen) + 8) + 1024) & ~1;
+
+  printf("\n %s: %d blocks per point, buffer %d words\n", argv[0], nblocks, maxwords);
+  printf("----------------------------\n");
+
+  stat = vmeOpenDefaultWindows();
+  if(stat != OK)
+    goto CLOSE;
+
+  vmeCheckMutexHealth(1);
+  vmeBusLock();
+
+  dmaPFreeAll();
+  /* Two readout buffers, for the async mode */
+  vmeIN = dmaPCreate("vmeIN", 2 * maxwords * 4, 1, 0);
+  if(vmeIN == NULL)
+    goto CLOSE;
+  dmaPReInitAll();
+  GETEVENT(vmeIN, 0);
+  buf[0] = dma_dabufp;
+  buf[1] = dma_dabufp + maxwords;
+
+  bank = calloc(maxwords, sizeof(uint32_t));
+  if(bank == NULL)
+    goto CLOSE;
+
+  lat = calloc((uint64_t) nblocks * maxboards * maxblock, sizeof(uint64_t));
+  if(lat == NULL)
+    goto CLOSE;
+
+  for(ib = 0; ib < nboards; ib++)
+    {
+      if(c1725N() > 0)
+	c1725DisableMulticast();
+      c1725Init(slot << 19, 1 << 19, boards[ib]);
+      if(c1725N() != boards[ib])
+	{
+	  printf("%s: ERROR: %d of %d boards found\n", argv[0], c1725N(), boards[ib]);
+	  continue;
+	}
+      c1725SetMulticast(0x09000000);
+
+      for(im = 0; im < nmodes; im++)
+	for(il = 0; il < nblocklevel; il++)
+	  for(ir = 0; ir < nreclen; ir++)
+	    {
+	      benchResult *r;
+
+	      if(nresult >= MAXPOINTS)
+		break;
+
+	      r = &result[nresult++];
+	      memset(r, 0, sizeof(benchResult));
+	      r->mode = modes[im];
+	      r->nboards = boards[ib];
+	      r->blocklevel = blocks[il];
+	      r->reclen = reclens[ir];
+	      r->nblocks = nblocks;
+
+	      runPoint(r, buf, maxwords, lat);
+	    }
+    }
+
+  printResults();
+
+ CLOSE:
+
+  if(lat)
+    free(lat);
+  if(bank)
+    free(bank);
+
+  if(c1725N() > 0)
+    c1725DisableMulticast();
+
+  dmaPFreeAll();
+
+  vmeBusUnlock();
+
+  stat = vmeCloseDefaultWindows();
+  if (stat != OK)
+    {
+      printf("vmeCloseDefaultWindows failed: code 0x%08x\n",stat);
+      return -1;
+    }
+
+  exit(0);
+}
+/*
+  Local Variables:
+  compile-command: "make -k c1725ReadoutBench "
+  End:
+*/
@@ -3,7 +3,8 @@
  *    c1725Status.c
  *
  * Description:
- *    Print the Status of C1725 to standard out
+ *    Print the Status of C1725 to standard out, or with -j a status
+ *    snapshot as JSON
  *
  *
  */
@@ -19,9 +20,15 @@ int
 main(int argc, char *argv[])
 {
 
-  int32_t stat, ninit = 1;
+  int32_t stat, ninit = 1, json = 0;
   uint32_t address=0;
 
+  if((argc > 1) && (strcmp(argv[argc - 1], "-j") == 0))
+    {
+      json = 1;
+      argc--;
+    }
+
   if (argc > 1)
     {
       address = (uint32_t) strtoll(argv[1],NULL,16)&0xffffffff;
@@ -43,8 +50,20 @@ main(int argc, char *argv[])
   vmeBusLock();
 
   c1725Init(address, (1 << 19), ninit);
-  c1725CheckAddresses();
-  c1725GStatus(1);
+  if(json)
+    {
+      static c1725Status_t st;
+      static char buf[1 << 20];
+
+      if((c1725GStatusSnapshot(&st) == OK) &&
+	 (c1725StatusSnapshotJSON(&st, buf, sizeof(buf)) > 0))
+	printf("%s\n", buf);
+    }
+  else
+    {
+      c1725CheckAddresses();
+      c1725GStatus(1);
+    }
 
  CLOSE:
 